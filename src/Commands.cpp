@@ -5,4 +5,12 @@ void registerCommands(pulse::utils::Console &console,
 {
     console.registerCommand("connections",
                             [&](const std::vector<std::string> &args) { network_manager.showClients(std::cout); });
+
+    console.registerCommand("sockets", [&](const std::vector<std::string> & /*args*/) {
+        network_manager.showSocketOptions(std::cout);
+    });
+
+    console.registerCommand("topology", [&](const std::vector<std::string> & /*args*/) {
+        network_manager.showTopology(std::cout);
+    });
 }
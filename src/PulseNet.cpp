@@ -2,11 +2,12 @@
 #include "networking/Client.h"
 #include "networking/LoggerManager.h"
 #include "networking/TCPServer.h"
-#include "networking/ThreadPool.h"
+#include "networking/TaskScheduler.h"
 #include "networking/http/HttpAssembler.h"
 #include "utils/ConfigParser.h"
 #include "utils/Console.h"
 #include "utils/Logger.h"
+#include <algorithm>
 #include <codecvt>
 #include <iostream>
 #include <locale>
@@ -21,14 +22,118 @@ int main()
     parser.read();
 
     /********** Initialize sockets ***********/
+    std::string max_clients_value = parser.getValue("MAX_CLIENTS", std::to_string(pulse::net::MAX_CLIENTS));
+    uint32_t max_clients = pulse::net::MAX_CLIENTS;
+
+    try
+    {
+        unsigned long value = std::stoul(max_clients_value);
+
+        if (value < 1 || value > UINT32_MAX)
+        {
+            throw std::out_of_range(max_clients_value);
+        }
+
+        max_clients = static_cast<uint32_t>(value);
+    }
+    catch (const std::exception &)
+    {
+        logger.log(LogType::APPLICATION, LogSeverity::LOG_WARNING,
+                   "Invalid MAX_CLIENTS " + max_clients_value + ", using " + std::to_string(max_clients));
+    }
+
+    // Assembling and handling requests share the workers of one scheduler
+    pulse::net::TaskScheduler scheduler(std::max(1, static_cast<int>(std::thread::hardware_concurrency())),
+                                        max_clients);
+
     auto assembler = std::make_unique<pulse::net::HttpAssembler>();
-    pulse::net::TCPServer<pulse::net::HttpAssembler> server(80, "0.0.0.0", 2, std::move(assembler));
+    pulse::net::TCPServer<pulse::net::HttpAssembler> server(80, "0.0.0.0", 2, std::move(assembler), max_clients);
     // server.setClientBufferLen(60);
 
+    // A listener takes the profile of its port, or the one of every listener
+    std::string profile_name = parser.getValue("SOCKET_PROFILE_" + std::to_string(server.getPort()),
+                                               parser.getValue("SOCKET_PROFILE", "default"));
+    pulse::net::SocketProfile profile;
+
+    if (!pulse::net::parseSocketProfile(profile_name, profile))
+    {
+        logger.log(LogType::APPLICATION, LogSeverity::LOG_WARNING,
+                   "Unknown socket profile " + profile_name + ", using the default one");
+        profile = pulse::net::SocketProfile::DEFAULT;
+    }
+
+    server.setSocketOptions(pulse::net::SocketOptions::forProfile(profile));
+
+    // Every kind of thread takes its own placement, or the one of every thread
+    auto placement = [&parser, &logger](const std::string &key) {
+        std::string name = parser.getValue(key, parser.getValue("THREAD_PLACEMENT", "none"));
+        pulse::net::ThreadPlacement placement;
+
+        if (!pulse::net::parseThreadPlacement(name, placement))
+        {
+            logger.log(LogType::APPLICATION, LogSeverity::LOG_WARNING,
+                       "Unknown thread placement " + name + " for " + key + ", threads will float");
+        }
+
+        return placement;
+    };
+
     pulse::net::LoggerManager::setLevel(pulse::net::SEVERITY::TRACE);
 
     try
     {
+#ifdef PULSENET_TLS
+        // TLS is terminated on the listeners with a certificate
+        std::string port = std::to_string(server.getPort());
+        pulse::net::TlsConfig tls;
+        tls.certificate_file = parser.getValue("TLS_CERTIFICATE_" + port, parser.getValue("TLS_CERTIFICATE", ""));
+        tls.private_key_file = parser.getValue("TLS_PRIVATE_KEY_" + port, parser.getValue("TLS_PRIVATE_KEY", ""));
+        tls.kernel_offload = parser.getValue("TLS_KERNEL_OFFLOAD", "0") == "1";
+
+        if (!tls.certificate_file.empty())
+        {
+            server.setTls(tls);
+        }
+#endif
+
+#ifndef _WIN32
+        // Local clients may connect through a Unix domain socket as well
+        std::string unix_socket = parser.getValue("UNIX_SOCKET_" + std::to_string(server.getPort()),
+                                                  parser.getValue("UNIX_SOCKET", ""));
+
+        if (!unix_socket.empty())
+        {
+            server.setUnixSocket(unix_socket);
+        }
+#endif
+
+        server.setIoPlacement(placement("IO_PLACEMENT"));
+
+        scheduler.setPlacement(placement("WORKER_PLACEMENT"));
+        scheduler.start();
+        server.setScheduler(scheduler);
+
+        server.setRequestCallback([&server](pulse::net::TCPServer<pulse::net::HttpAssembler>::Request request) {
+            std::shared_ptr<pulse::net::HttpMessage> message = request.message;
+
+            // std::cout << request.message->rawBody() << '\n';
+            // std::cout << "**************************************************************\n";
+
+            static const std::string RESPONSE = "HTTP/1.1 200 OK\r\n"
+                                                "Content-Type: application/json\r\n"
+                                                "Content-Length: 35\r\n"
+                                                "\r\n"
+                                                "{\n\"message\" : \"Message received!\"\n}";
+
+            bool isChunked = message->headerContainsValue("transfer-encoding", "chunked");
+
+            if ((isChunked && message->rawBody().size() == 0) || !isChunked)
+            {
+                server.send(request.client.id, RESPONSE);
+                // server.send(request.client.id, "");
+            }
+        });
+
         server.start();
     }
     catch (const std::exception &ex)
@@ -41,33 +146,18 @@ int main()
     logger.log(LogType::NETWORK, LogSeverity::LOG_INFO,
                "Socket listener created successfully at " + server.getIp() + ":" + std::to_string(server.getPort()));
 
-    pulse::utils::Console console;
-    registerCommands(console, server);
-
-    pulse::net::ThreadPool test(4, [&server](int id) {
-        auto request = server.next();
-
-        std::shared_ptr<pulse::net::HttpMessage> message = request->message;
-
-        // std::cout << request->message->rawBody() << '\n';
-        // std::cout << "**************************************************************\n";
+    if (!server.getUnixSocket().empty())
+    {
+        logger.log(LogType::NETWORK, LogSeverity::LOG_INFO, "Local clients accepted at " + server.getUnixSocket());
+    }
 
-        static const std::string RESPONSE = "HTTP/1.1 200 OK\r\n"
-                                            "Content-Type: application/json\r\n"
-                                            "Content-Length: 35\r\n"
-                                            "\r\n"
-                                            "{\n\"message\" : \"Message received!\"\n}";
+    server.showSocketOptions(std::cout);
 
-        bool isChunked = message->headerContainsValue("transfer-encoding", "chunked");
+    server.showTopology(std::cout);
 
-        if ((isChunked && message->rawBody().size() == 0) || !isChunked)
-        {
-            server.send(request->client.id, RESPONSE);
-            // server.send(request->client.id, "");
-        }
-    });
+    pulse::utils::Console console;
+    registerCommands(console, server);
 
-    test.run();
     console.run();
 
     return 0;
@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct AddressLimits
+ * @brief What every source address is held to. 0 disables a limit.
+ *
+ * Rates are refilled continuously into buckets of burst tokens, so an address
+ * may go over its rate for a while, up to its burst.
+ */
+struct AddressLimits
+{
+    uint32_t max_connections{0}; ///< Connections open at once
+
+    double requests_per_second{0};
+    double request_burst{0};
+
+    double bytes_per_second{0};
+    double byte_burst{0};
+
+    bool isEnabled() const
+    {
+        return max_connections > 0 || requests_per_second > 0 || bytes_per_second > 0;
+    }
+};
+
+/**
+ * @struct AddressLimiterStats
+ * @brief What an AddressLimiter refused.
+ */
+struct AddressLimiterStats
+{
+    std::atomic<uint64_t> refused_connections{0}; ///< Over the connection cap, or out of tokens
+    std::atomic<uint64_t> limited_requests{0};    ///< Messages assembled without a request token
+    std::atomic<uint64_t> limited_receives{0};    ///< Receives not parsed, the byte bucket was empty
+};
+
+/**
+ * @struct TokenBucket
+ * @brief Tokens refilled at a rate, up to a burst.
+ */
+struct TokenBucket
+{
+    double tokens = 0;
+    uint64_t updated_ms = 0;
+
+    void refill(double rate, double burst, uint64_t now)
+    {
+        if (now > updated_ms)
+        {
+            tokens = std::min(burst, tokens + static_cast<double>(now - updated_ms) * rate / 1000.0);
+            updated_ms = now;
+        }
+    }
+
+    /**
+     * @brief Takes amount tokens if there are that many.
+     */
+    bool take(double amount)
+    {
+        if (tokens < amount)
+        {
+            return false;
+        }
+
+        tokens -= amount;
+        return true;
+    }
+};
+
+/**
+ * @class AddressLimiter
+ * @brief Connection counts and token buckets of every source address with
+ * connections, or whose buckets are still refilling.
+ *
+ * Addresses are IPv4 addresses in network byte order. The table is split in
+ * ADDRESS_LIMITER_SHARDS shards by the hash of the address, each an open
+ * addressing table of flat entries behind its own lock, so threads only
+ * contend on the same shard and a lookup touches one cache line. An address
+ * is forgotten once it has no connection and full buckets, which keeps the
+ * table to the addresses active lately, however many there are.
+ *
+ * The caller passes the time, in milliseconds of any monotonic clock.
+ */
+class AddressLimiter
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    AddressLimiter()
+    {
+        for (auto &shard : m_shards)
+        {
+            shard.slots.resize(ADDRESS_LIMITER_SHARD_SLOTS);
+        }
+    }
+
+    AddressLimiter(const AddressLimiter &limiter) = delete;
+    AddressLimiter &operator=(const AddressLimiter &limiter) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Sets the limits. Must be called before any address is checked.
+     */
+    void configure(const AddressLimits &limits)
+    {
+        m_limits = limits;
+    }
+
+    bool isEnabled() const
+    {
+        return m_limits.isEnabled();
+    }
+
+    /**
+     * @brief Parses a textual IPv4 address.
+     *
+     * @return false if it is not one.
+     */
+    static bool parseAddress(const std::string &ip_address, uint32_t &address)
+    {
+        in_addr parsed{};
+
+#ifdef _WIN32
+        if (InetPtonA(AF_INET, ip_address.c_str(), &parsed) != 1)
+#else
+        if (inet_pton(AF_INET, ip_address.c_str(), &parsed) != 1)
+#endif
+        {
+            return false;
+        }
+
+        address = parsed.s_addr;
+        return true;
+    }
+
+    /**
+     * @brief Counts a new connection from address, unless it already has as
+     * many as allowed or has run out of request or byte tokens.
+     */
+    bool acquireConnection(uint32_t address, uint64_t now)
+    {
+        Shard &shard = shardOf(address);
+        std::lock_guard lock(shard.mtx);
+
+        Entry &entry = findOrInsert(shard, address, now);
+        refill(entry, now);
+
+        bool out_of_tokens = (m_limits.requests_per_second > 0 && entry.requests.tokens < 1) ||
+                             (m_limits.bytes_per_second > 0 && entry.bytes.tokens <= 0);
+
+        if ((m_limits.max_connections > 0 && entry.connections >= m_limits.max_connections) || out_of_tokens)
+        {
+            m_stats.refused_connections.fetch_add(1, std::memory_order_relaxed);
+            eraseIfIdle(shard, entry);
+            return false;
+        }
+
+        entry.connections++;
+        return true;
+    }
+
+    void releaseConnection(uint32_t address, uint64_t now)
+    {
+        Shard &shard = shardOf(address);
+        std::lock_guard lock(shard.mtx);
+
+        Entry *entry = find(shard, address);
+
+        if (entry != nullptr)
+        {
+            entry->connections = entry->connections > 0 ? entry->connections - 1 : 0;
+            refill(*entry, now);
+            eraseIfIdle(shard, *entry);
+        }
+    }
+
+    /**
+     * @brief Takes a request token from address.
+     */
+    bool admitRequest(uint32_t address, uint64_t now)
+    {
+        if (m_limits.requests_per_second <= 0)
+        {
+            return true;
+        }
+
+        Shard &shard = shardOf(address);
+        std::lock_guard lock(shard.mtx);
+
+        Entry &entry = findOrInsert(shard, address, now);
+        refill(entry, now);
+
+        if (!entry.requests.take(1))
+        {
+            m_stats.limited_requests.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Charges bytes received from address to its byte bucket.
+     *
+     * The bytes are already received, so they are always charged and may
+     * leave the bucket in debt; the receive is refused if the bucket was
+     * empty before it.
+     */
+    bool admitBytes(uint32_t address, size_t bytes, uint64_t now)
+    {
+        if (m_limits.bytes_per_second <= 0)
+        {
+            return true;
+        }
+
+        Shard &shard = shardOf(address);
+        std::lock_guard lock(shard.mtx);
+
+        Entry &entry = findOrInsert(shard, address, now);
+        refill(entry, now);
+
+        bool admitted = entry.bytes.tokens > 0;
+        entry.bytes.tokens -= static_cast<double>(bytes);
+
+        if (!admitted)
+        {
+            m_stats.limited_receives.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return admitted;
+    }
+
+    /**
+     * @brief Number of addresses in the table.
+     */
+    size_t size()
+    {
+        size_t total = 0;
+
+        for (auto &shard : m_shards)
+        {
+            std::lock_guard lock(shard.mtx);
+            total += shard.size;
+        }
+
+        return total;
+    }
+
+    const AddressLimiterStats &getStats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    /**
+     * @struct Entry
+     * @brief State of one address. Slots with used false are free.
+     */
+    struct Entry
+    {
+        uint32_t address = 0;
+        uint32_t connections = 0;
+        bool used = false;
+
+        TokenBucket requests;
+        TokenBucket bytes;
+    };
+
+    /**
+     * @struct Shard
+     * @brief Linear probing table with a power of two number of slots, kept
+     * at most half full.
+     */
+    struct Shard
+    {
+        std::mutex mtx;
+        std::vector<Entry> slots;
+        size_t size = 0;
+    };
+
+    AddressLimits m_limits{};
+    AddressLimiterStats m_stats{};
+
+    Shard m_shards[ADDRESS_LIMITER_SHARDS];
+
+    static uint64_t hash(uint32_t address)
+    {
+        return static_cast<uint64_t>(address) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    Shard &shardOf(uint32_t address)
+    {
+        return m_shards[hash(address) >> 56 & (ADDRESS_LIMITER_SHARDS - 1)];
+    }
+
+    static size_t homeSlot(const Shard &shard, uint32_t address)
+    {
+        return static_cast<size_t>(hash(address) >> 16) & (shard.slots.size() - 1);
+    }
+
+    void refill(Entry &entry, uint64_t now) const
+    {
+        entry.requests.refill(m_limits.requests_per_second, m_limits.request_burst, now);
+        entry.bytes.refill(m_limits.bytes_per_second, m_limits.byte_burst, now);
+    }
+
+    /**
+     * @brief Whether the entry holds nothing a new one would not: no
+     * connection and full buckets.
+     */
+    bool isIdle(const Entry &entry) const
+    {
+        return entry.connections == 0 &&
+               (m_limits.requests_per_second <= 0 || entry.requests.tokens >= m_limits.request_burst) &&
+               (m_limits.bytes_per_second <= 0 || entry.bytes.tokens >= m_limits.byte_burst);
+    }
+
+    Entry *find(Shard &shard, uint32_t address)
+    {
+        size_t mask = shard.slots.size() - 1;
+
+        for (size_t i = homeSlot(shard, address);; i = (i + 1) & mask)
+        {
+            Entry &slot = shard.slots[i];
+
+            if (!slot.used)
+            {
+                return nullptr;
+            }
+
+            if (slot.address == address)
+            {
+                return &slot;
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the entry of an address, creating it with full buckets.
+     */
+    Entry &findOrInsert(Shard &shard, uint32_t address, uint64_t now)
+    {
+        Entry *found = find(shard, address);
+
+        if (found != nullptr)
+        {
+            return *found;
+        }
+
+        if ((shard.size + 1) * 2 > shard.slots.size())
+        {
+            rehash(shard, now);
+        }
+
+        size_t mask = shard.slots.size() - 1;
+        size_t i = homeSlot(shard, address);
+
+        while (shard.slots[i].used)
+        {
+            i = (i + 1) & mask;
+        }
+
+        Entry &entry = shard.slots[i];
+        entry = Entry{address, 0, true, TokenBucket{m_limits.request_burst, now},
+                      TokenBucket{m_limits.byte_burst, now}};
+        shard.size++;
+
+        return entry;
+    }
+
+    /**
+     * @brief Drops the idle entries of a full shard, and doubles it unless
+     * that freed enough slots.
+     */
+    void rehash(Shard &shard, uint64_t now)
+    {
+        std::vector<Entry> live;
+
+        for (Entry &entry : shard.slots)
+        {
+            if (entry.used)
+            {
+                refill(entry, now);
+
+                if (!isIdle(entry))
+                {
+                    live.push_back(entry);
+                }
+            }
+        }
+
+        size_t slots = shard.slots.size();
+
+        if ((live.size() + 1) * 4 > slots)
+        {
+            slots *= 2;
+        }
+
+        shard.slots.assign(slots, Entry{});
+        shard.size = live.size();
+
+        for (const Entry &entry : live)
+        {
+            size_t i = homeSlot(shard, entry.address);
+
+            while (shard.slots[i].used)
+            {
+                i = (i + 1) & (slots - 1);
+            }
+
+            shard.slots[i] = entry;
+        }
+    }
+
+    void eraseIfIdle(Shard &shard, Entry &entry)
+    {
+        if (isIdle(entry))
+        {
+            erase(shard, static_cast<size_t>(&entry - shard.slots.data()));
+        }
+    }
+
+    /**
+     * @brief Frees a slot, shifting the entries probed past it back so that
+     * every entry stays reachable from its home slot.
+     */
+    void erase(Shard &shard, size_t hole)
+    {
+        size_t mask = shard.slots.size() - 1;
+
+        for (size_t i = (hole + 1) & mask; shard.slots[i].used; i = (i + 1) & mask)
+        {
+            size_t home = homeSlot(shard, shard.slots[i].address);
+
+            // Moved back unless its home lies cyclically in (hole, i]
+            if (((i - home) & mask) >= ((i - hole) & mask))
+            {
+                shard.slots[hole] = shard.slots[i];
+                hole = i;
+            }
+        }
+
+        shard.slots[hole] = Entry{};
+        shard.size--;
+    }
+};
+
+} // namespace pulse::net
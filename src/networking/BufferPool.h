@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct RecvBufferPolicy
+ * @brief How client receive buffers follow the traffic of their connection.
+ *
+ * A buffer that fills up is replaced right away by one twice as large, up to
+ * max_len. The size a client starts its next reads with only follows with
+ * hysteresis: it is raised once grow_after reads in a row needed a larger
+ * buffer, and halved (down to min_len) once shrink_after reads in a row used
+ * at most a quarter of it.
+ */
+struct RecvBufferPolicy
+{
+    size_t min_len{0};
+    size_t max_len{0};
+    int grow_after{RECV_BUFFER_GROW_AFTER};
+    int shrink_after{RECV_BUFFER_SHRINK_AFTER};
+};
+
+/**
+ * @struct RecvBufferStats
+ * @brief How often client receive buffers were resized.
+ */
+struct RecvBufferStats
+{
+    std::atomic<uint64_t> expansions{0}; ///< Full buffers replaced by a larger one while reading
+    std::atomic<uint64_t> grows{0};      ///< Times the size of a client was raised
+    std::atomic<uint64_t> shrinks{0};    ///< Times the size of a client was lowered
+};
+
+/**
+ * @struct RecvBufferSizing
+ * @brief Receive buffer policy of a server and its counters, shared by its
+ * clients.
+ */
+struct RecvBufferSizing
+{
+    RecvBufferPolicy policy;
+    RecvBufferStats stats;
+};
+
+/**
+ * @class BufferSource
+ * @brief Owner of the receive buffers lent to clients, which a client gives
+ * its buffer back to once it has no pending bytes left.
+ */
+class BufferSource
+{
+  public:
+    virtual ~BufferSource() = default;
+
+    /**
+     * @brief Takes back a buffer lent with the given size.
+     */
+    virtual void release(char *buffer, size_t size) = 0;
+};
+
+/**
+ * @class BufferPool
+ * @brief Slab allocator of receive buffers, split in power of two size
+ * classes from BUFFER_POOL_MIN_CLASS to BUFFER_POOL_MAX_CLASS bytes.
+ *
+ * Each class carves its buffers out of slabs of about BUFFER_POOL_SLAB_BYTES
+ * and keeps released buffers on a free list, so buffers move between
+ * connections without touching the heap. Slabs are only freed with the pool.
+ * Sizes above the largest class are allocated and freed directly.
+ *
+ * Buffers are usually acquired by an I/O thread and released by an assembler
+ * worker, so every class has its own lock.
+ */
+class BufferPool : public BufferSource
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    BufferPool()
+    {
+        for (size_t size = BUFFER_POOL_MIN_CLASS; size <= BUFFER_POOL_MAX_CLASS; size *= 2)
+        {
+            m_classes.push_back(std::make_unique<SizeClass>());
+            m_classes.back()->size = size;
+        }
+    }
+
+    BufferPool(const BufferPool &pool) = delete;
+    BufferPool(BufferPool &&pool) = delete;
+    BufferPool &operator=(const BufferPool &pool) = delete;
+    BufferPool &operator=(BufferPool &&pool) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Gets a buffer of at least size bytes, from the smallest class
+     * that fits it.
+     */
+    char *acquire(size_t size)
+    {
+        int index = classIndex(size);
+
+        if (index < 0)
+        {
+            return new char[size];
+        }
+
+        SizeClass &size_class = *m_classes[index];
+        std::lock_guard lock(size_class.mtx);
+
+        if (size_class.free.empty())
+        {
+            size_t count = std::max<size_t>(1, BUFFER_POOL_SLAB_BYTES / size_class.size);
+            size_class.slabs.push_back(std::make_unique<char[]>(count * size_class.size));
+
+            char *slab = size_class.slabs.back().get();
+            for (size_t i = 0; i < count; i++)
+            {
+                size_class.free.push_back(slab + i * size_class.size);
+            }
+        }
+
+        char *buffer = size_class.free.back();
+        size_class.free.pop_back();
+
+        return buffer;
+    }
+
+    /**
+     * @brief Puts a buffer back on the free list of its class. size must be
+     * the size it was acquired with.
+     */
+    void release(char *buffer, size_t size) override
+    {
+        int index = classIndex(size);
+
+        if (index < 0)
+        {
+            delete[] buffer;
+            return;
+        }
+
+        SizeClass &size_class = *m_classes[index];
+        std::lock_guard lock(size_class.mtx);
+        size_class.free.push_back(buffer);
+    }
+
+  private:
+    /**
+     * @struct SizeClass
+     * @brief Slabs of one buffer size and the buffers of them not lent.
+     */
+    struct SizeClass
+    {
+        size_t size = 0;
+        std::vector<std::unique_ptr<char[]>> slabs;
+        std::vector<char *> free;
+        std::mutex mtx;
+    };
+
+    std::vector<std::unique_ptr<SizeClass>> m_classes;
+
+    /**
+     * @brief Index of the smallest class of at least size bytes, or -1 if it
+     * is larger than every class.
+     */
+    static int classIndex(size_t size)
+    {
+        if (size > BUFFER_POOL_MAX_CLASS)
+        {
+            return -1;
+        }
+
+        size_t class_size = std::bit_ceil(std::max(size, BUFFER_POOL_MIN_CLASS));
+        return std::countr_zero(class_size) - std::countr_zero(BUFFER_POOL_MIN_CLASS);
+    }
+};
+
+} // namespace pulse::net
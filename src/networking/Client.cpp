@@ -1,16 +1,23 @@
 #include "Client.h"
+#include "TCPMessageAssembler.h"
+
+#include <cstring>
+
 namespace pulse::net
 {
-Client::Client(uint64_t id, int port, std::string ipAddress, int max_buffer_len, SOCKET_TYPE sock)
-    : m_id(id), m_port(port), m_ipAddress(ipAddress), m_sock(sock), m_recv_len(0), m_send_len(0),
-      m_last_bytes_received(0), m_is_disconnecting(false), m_is_sending(false), m_max_buffer_len(max_buffer_len)
+Client::Client(uint64_t id, int port, std::string ipAddress, int max_buffer_len, SOCKET_TYPE sock,
+               RecvBufferSizing *sizing, OutboundBudget *outbound, MemoryBudget *memory)
+    : m_recv_buffer_len(max_buffer_len), m_recv_len(0), m_send_len(0), m_is_sending(false), m_id(id), m_port(port),
+      m_ipAddress(ipAddress), m_sock(sock), m_last_bytes_received(0), m_is_disconnecting(false),
+      m_recv_buffer_sizing(sizing), m_outbound_budget(outbound), m_memory_budget(memory)
 {
-    m_recv_buffer = new char[max_buffer_len];
+    m_timer.owner = this;
 }
 
+// The receive buffer is not released here: it belongs to a pool that may
+// already be gone when the server destroys its remaining clients.
 Client::~Client()
 {
-    delete[] m_recv_buffer;
 }
 
 uint64_t Client::getId() const
@@ -28,6 +35,16 @@ std::pair<int, std::string> Client::getAddress() const
     return {m_port, m_ipAddress};
 }
 
+const std::string &Client::getIpAddress() const
+{
+    return m_ipAddress;
+}
+
+int Client::getPort() const
+{
+    return m_port;
+}
+
 int Client::getReferenceCount() const
 {
     return m_reference_count.load();
@@ -38,14 +55,21 @@ void Client::increaseReferenceCount()
     m_reference_count.fetch_add(1, std::memory_order_relaxed);
 };
 
-void Client::decreaseReferenceCount()
+int Client::decreaseReferenceCount()
 {
-    m_reference_count.fetch_sub(1, std::memory_order_acq_rel);
+    return m_reference_count.fetch_sub(1, std::memory_order_acq_rel) - 1;
 };
 
 void Client::disconnect()
 {
-    m_is_disconnecting = true;
+    bool was_disconnecting = m_is_disconnecting.exchange(true);
+
+#ifndef _WIN32
+    if (!was_disconnecting)
+    {
+        shutdown(m_sock, SHUT_RD);
+    }
+#endif
 }
 
 bool Client::isDisconnecting() const
@@ -55,17 +79,415 @@ bool Client::isDisconnecting() const
 
 void Client::showInfo(std::ostream &os) const
 {
-    os << std::left << std::setfill(' ') << std::setw(10) << m_id << std::setw(3) << "|" << std::setw(24) << m_ipAddress
+    // Local clients are shown by their credentials
+    std::string address = m_peer ? m_peer->toString() : m_ipAddress;
+
+    os << std::left << std::setfill(' ') << std::setw(10) << m_id << std::setw(3) << "|" << std::setw(24) << address
        << std::setw(3) << "|" << std::setw(6) << m_port << std::setw(3) << "|" << std::setw(4) << m_reference_count
        << "|" << std::setw(14) << m_is_disconnecting << "\n";
     os << "---------------------------------------------------------------------"
           "\n";
 }
 
+bool Client::hasRecvBuffer() const
+{
+    return m_recv_buffer != nullptr;
+}
+
+void Client::attachRecvBuffer(char *buffer, size_t size, BufferSource &source)
+{
+    m_recv_buffer = buffer;
+    m_recv_capacity = size;
+    m_recv_buffer_source = &source;
+
+    // Reading needs a buffer, so it is attached even past the limit
+    if (m_memory_budget != nullptr)
+    {
+        m_memory_budget->reserve(MemoryUse::RECV_BUFFERS, size);
+    }
+}
+
+void Client::attachRecvBuffer(BufferPool &pool)
+{
+    attachRecvBuffer(pool.acquire(m_recv_buffer_len), m_recv_buffer_len, pool);
+}
+
+void Client::releaseRecvBuffer()
+{
+    if (m_recv_buffer != nullptr)
+    {
+        adaptRecvBufferLen();
+
+        m_recv_buffer_source->release(m_recv_buffer, m_recv_capacity);
+
+        if (m_memory_budget != nullptr)
+        {
+            m_memory_budget->release(MemoryUse::RECV_BUFFERS, m_recv_capacity);
+        }
+
+        m_recv_buffer = nullptr;
+        m_recv_capacity = 0;
+        m_recv_buffer_source = nullptr;
+    }
+}
+
+bool Client::growRecvBuffer(BufferPool &pool)
+{
+    size_t size = std::min(m_recv_capacity * 2, getRecvBufferLimit());
+
+    if (m_recv_buffer == nullptr || size <= m_recv_capacity)
+    {
+        return false;
+    }
+
+    if (m_memory_budget != nullptr && !m_memory_budget->tryReserve(MemoryUse::RECV_BUFFERS, size - m_recv_capacity))
+    {
+        return false;
+    }
+
+    char *buffer = pool.acquire(size);
+    std::memcpy(buffer, m_recv_buffer, m_recv_len);
+    m_recv_buffer_source->release(m_recv_buffer, m_recv_capacity);
+
+    m_recv_buffer = buffer;
+    m_recv_capacity = size;
+    m_recv_buffer_source = &pool;
+    m_recv_grew = true;
+
+    m_recv_buffer_sizing->stats.expansions.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t Client::getRecvBufferLimit() const
+{
+    return m_recv_buffer_sizing ? std::max(m_recv_buffer_sizing->policy.max_len, m_recv_buffer_len)
+                                : m_recv_buffer_len;
+}
+
+void Client::adaptRecvBufferLen()
+{
+    if (m_recv_buffer_sizing == nullptr)
+    {
+        return;
+    }
+
+    const RecvBufferPolicy &policy = m_recv_buffer_sizing->policy;
+    RecvBufferStats &stats = m_recv_buffer_sizing->stats;
+
+    if (m_recv_grew)
+    {
+        m_shrink_streak = 0;
+
+        if (++m_grow_streak >= policy.grow_after)
+        {
+            m_recv_buffer_len = std::max(m_recv_buffer_len, m_recv_capacity);
+            m_grow_streak = 0;
+            stats.grows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    else if (m_recv_peak <= m_recv_buffer_len / 4 && m_recv_buffer_len > policy.min_len)
+    {
+        m_grow_streak = 0;
+
+        if (++m_shrink_streak >= policy.shrink_after)
+        {
+            m_recv_buffer_len = std::max(m_recv_buffer_len / 2, policy.min_len);
+            m_shrink_streak = 0;
+            stats.shrinks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        m_grow_streak = 0;
+        m_shrink_streak = 0;
+    }
+
+    m_recv_peak = 0;
+    m_recv_grew = false;
+}
+
+void Client::consumeOutbound(size_t bytes)
+{
+    if (m_tls != nullptr && !m_tls->isOffloaded())
+    {
+        m_tls->consumeOutput(bytes);
+        return;
+    }
+
+    consumePlaintext(bytes);
+}
+
+bool Client::hasOutbound() const
+{
+    if (m_tls != nullptr && !m_tls->isOffloaded())
+    {
+        return m_tls->outputSize() > 0 || (m_tls->isEstablished() && !m_outbound_message_queue.empty());
+    }
+
+    return !m_outbound_message_queue.empty();
+}
+
+size_t Client::getPendingOutboundBytes() const
+{
+    return m_outbound_bytes + (m_tls != nullptr ? m_tls->outputSize() : 0);
+}
+
+bool Client::hasPendingInput() const
+{
+    return m_tls != nullptr && m_tls->hasBufferedInput();
+}
+
+bool Client::writesPlaintext()
+{
+    if (m_tls == nullptr || m_tls->isOffloaded())
+    {
+        return true;
+    }
+
+    // What was sealed must reach the socket before the kernel encrypts the rest
+    return m_tls->outputSize() == 0 && m_tls->offload(m_sock);
+}
+
+bool Client::frontFile(OutboundFileSegment &segment)
+{
+    if (m_outbound_message_queue.empty() || !writesPlaintext())
+    {
+        return false;
+    }
+
+    const OutboundMessage &front = m_outbound_message_queue.front();
+
+    if (front.file.length == 0 || m_send_len < front.bufferedSize())
+    {
+        return false;
+    }
+
+    uint64_t written = m_send_len - front.bufferedSize();
+    segment = OutboundFileSegment{front.file.file.get(), front.file.offset + written, front.file.length - written};
+    return true;
+}
+
+bool Client::sealOutbound(size_t max_bytes, int max_segments)
+{
+    if (writesPlaintext())
+    {
+        return false;
+    }
+
+    if (m_tls->isEstablished() && m_tls->outputSize() < max_bytes && !m_outbound_message_queue.empty())
+    {
+        size_t sealed = 0;
+
+        gatherPlaintext(max_bytes - m_tls->outputSize(), max_segments, true,
+                        [this, &sealed](const char *data, size_t len) {
+                            m_tls->seal(data, len);
+                            sealed += len;
+                        });
+
+        m_tls->closeRecord();
+        consumePlaintext(sealed);
+    }
+
+    return true;
+}
+
+void Client::consumePlaintext(size_t bytes)
+{
+    // Only the bytes held in memory were accounted
+    size_t released = 0;
+
+    while (bytes > 0 && !m_outbound_message_queue.empty())
+    {
+        const OutboundMessage &front = m_outbound_message_queue.front();
+        size_t buffered = front.bufferedSize();
+        size_t left = front.size() - m_send_len;
+
+        if (bytes < left)
+        {
+            released += std::min(m_send_len + bytes, buffered) - std::min(m_send_len, buffered);
+            m_send_len += bytes;
+            break;
+        }
+
+        bytes -= left;
+        released += buffered - std::min(m_send_len, buffered);
+        m_outbound_message_queue.pop_front();
+        m_send_len = 0;
+    }
+
+    releaseOutboundBytes(released);
+}
+
+SendStatus Client::queueOutbound(OutboundMessage &&message)
+{
+    if (message.size() == 0)
+    {
+        return SendStatus::QUEUED;
+    }
+
+    size_t size = message.bufferedSize();
+
+    if (m_outbound_budget != nullptr)
+    {
+        const OutboundLimits &limits = m_outbound_budget->limits;
+        OutboundStats &stats = m_outbound_budget->stats;
+
+        // A message larger than the limit still goes through an empty queue
+        if (m_outbound_bytes > 0 && m_outbound_bytes + size > limits.client_high)
+        {
+            m_outbound_congested = true;
+        }
+
+        if (stats.queued_bytes.load(std::memory_order_relaxed) + size > limits.global_high)
+        {
+            m_outbound_budget->congested.store(true, std::memory_order_relaxed);
+        }
+
+        // Without room in the memory budget, no queue may grow either. Global
+        // pressure only falls on queues over their low watermark, so that the
+        // healthy clients are still written to
+        bool reserved = m_memory_budget == nullptr || m_memory_budget->tryReserve(MemoryUse::OUTBOUND, size);
+        bool global = (!reserved || m_outbound_budget->congested.load(std::memory_order_relaxed)) &&
+                      m_outbound_bytes > limits.client_low;
+
+        // A refused message gives its reservation back
+        auto refuse = [&](SendStatus status) {
+            if (reserved && m_memory_budget != nullptr)
+            {
+                m_memory_budget->release(MemoryUse::OUTBOUND, size);
+            }
+
+            return status;
+        };
+
+        if (m_outbound_congested || global)
+        {
+            // Neither the front message, once partly written, nor the ones a
+            // write in flight gathered can be dropped
+            size_t first = std::max(m_send_pinned, m_send_len > 0 ? size_t(1) : size_t(0));
+            first = std::min(first, m_outbound_message_queue.size());
+
+            switch (limits.policy)
+            {
+            case SlowConsumerPolicy::DROP_NEWEST:
+                stats.dropped_messages.fetch_add(1, std::memory_order_relaxed);
+                stats.dropped_bytes.fetch_add(size, std::memory_order_relaxed);
+                return refuse(SendStatus::DROPPED);
+
+            case SlowConsumerPolicy::DISCONNECT:
+                stats.disconnects.fetch_add(1, std::memory_order_relaxed);
+                return refuse(SendStatus::DISCONNECTED);
+
+            case SlowConsumerPolicy::DROP_OLDEST: {
+                // Under the global watermark, the queue must not grow either
+                size_t last = first;
+                size_t freed = 0;
+                auto fits = [&]() {
+                    return m_outbound_bytes - freed + size <= limits.client_high && (!global || freed >= size);
+                };
+
+                while (!fits() && last < m_outbound_message_queue.size())
+                {
+                    freed += m_outbound_message_queue[last++].bufferedSize();
+                }
+
+                if (!fits())
+                {
+                    stats.dropped_messages.fetch_add(1, std::memory_order_relaxed);
+                    stats.dropped_bytes.fetch_add(size, std::memory_order_relaxed);
+                    return refuse(SendStatus::DROPPED);
+                }
+
+                dropOutbound(first, last);
+                break;
+            }
+
+            case SlowConsumerPolicy::CONFLATE:
+                dropOutbound(first, m_outbound_message_queue.size());
+                break;
+            }
+        }
+
+        // Room was made by dropping older messages, or the queue is small
+        // enough to go over the budget
+        if (!reserved)
+        {
+            m_memory_budget->reserve(MemoryUse::OUTBOUND, size);
+        }
+
+        stats.queued_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    m_outbound_message_queue.push_back(std::move(message));
+    m_outbound_bytes += size;
+
+    return SendStatus::QUEUED;
+}
+
+void Client::discardOutbound()
+{
+    releaseOutboundBytes(m_outbound_bytes);
+    m_outbound_message_queue.clear();
+    m_send_len = 0;
+    m_send_pinned = 0;
+}
+
+bool Client::isOutboundCongested() const
+{
+    return m_outbound_congested ||
+           (m_outbound_budget != nullptr && m_outbound_budget->congested.load(std::memory_order_relaxed));
+}
+
+void Client::dropOutbound(size_t first, size_t last)
+{
+    size_t bytes = 0;
+
+    for (size_t i = first; i < last; i++)
+    {
+        bytes += m_outbound_message_queue[i].bufferedSize();
+    }
+
+    m_outbound_message_queue.erase(m_outbound_message_queue.begin() + first, m_outbound_message_queue.begin() + last);
+    releaseOutboundBytes(bytes);
+
+    m_outbound_budget->stats.dropped_messages.fetch_add(last - first, std::memory_order_relaxed);
+    m_outbound_budget->stats.dropped_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Client::releaseOutboundBytes(size_t bytes)
+{
+    m_outbound_bytes -= bytes;
+
+    if (m_outbound_budget == nullptr)
+    {
+        return;
+    }
+
+    if (m_memory_budget != nullptr)
+    {
+        m_memory_budget->release(MemoryUse::OUTBOUND, bytes);
+    }
+
+    const OutboundLimits &limits = m_outbound_budget->limits;
+
+    if (m_outbound_congested && m_outbound_bytes <= limits.client_low)
+    {
+        m_outbound_congested = false;
+    }
+
+    uint64_t queued = m_outbound_budget->stats.queued_bytes.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+
+    if (queued <= limits.global_low && m_outbound_budget->congested.load(std::memory_order_relaxed))
+    {
+        m_outbound_budget->congested.store(false, std::memory_order_relaxed);
+    }
+}
+
 void Client::addBytesReceived(int bytes)
 {
     m_recv_len += bytes;
     m_last_bytes_received = bytes;
+    m_recv_peak = std::max(m_recv_peak, static_cast<size_t>(m_recv_len));
 }
 
 int Client::getLastBytesReceived() const
@@ -1,10 +1,20 @@
 #pragma once
+#include "BufferPool.h"
+#include "MemoryBudget.h"
 #include "NetworkPlatform.h"
+#include "OutboundMessage.h"
+#include "TCPMessageAssembler.h"
+#include "TimingWheel.h"
+#include "TlsSession.h"
 #include "constants.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -16,6 +26,23 @@
 namespace pulse::net
 {
 
+/**
+ * @struct PeerCredentials
+ * @brief Process on the other end of a local (Unix domain socket) connection,
+ * as the kernel reported it when the connection was accepted.
+ */
+struct PeerCredentials
+{
+    int32_t pid{0};
+    uint32_t uid{0};
+    uint32_t gid{0};
+
+    std::string toString() const
+    {
+        return "pid " + std::to_string(pid) + " uid " + std::to_string(uid) + " gid " + std::to_string(gid);
+    }
+};
+
 /**
  * @struct ClientDto
  * @brief Data Transfer Object for client connection information.
@@ -33,8 +60,14 @@ namespace pulse::net
 struct ClientDto
 {
     uint64_t id{0};         ///< Unique identifier of the client
-    std::string ip_address; ///< Client's IP address
+    std::string ip_address; ///< Client's IP address, empty for local clients
     int port{0};            ///< Client's port number
+
+    /**
+     * @brief Identity of a local client, connected through the Unix domain
+     * socket of the server, in place of an IP address.
+     */
+    std::optional<PeerCredentials> peer;
 };
 
 /**
@@ -53,7 +86,17 @@ class Client
      * Constructors
      * ----------------
      */
-    Client(uint64_t id, int port, std::string ipAddress, int buffer_len, SOCKET_TYPE sock);
+    /**
+     * @param buffer_len Size of the receive buffer attached while reading.
+     * @param sizing Policy the buffer size adapts with. Without one, the size
+     * stays buffer_len.
+     * @param outbound Limits the outbound queue is held to. Without them, it
+     * is unbounded.
+     * @param memory Budget the receive buffers and the outbound queue are
+     * reserved against. Without one, they are not accounted.
+     */
+    Client(uint64_t id, int port, std::string ipAddress, int buffer_len, SOCKET_TYPE sock,
+           RecvBufferSizing *sizing = nullptr, OutboundBudget *outbound = nullptr, MemoryBudget *memory = nullptr);
     ~Client();
 
     Client(const Client &client) = delete;
@@ -73,6 +116,10 @@ class Client
 
     std::pair<int, std::string> getAddress() const;
 
+    const std::string &getIpAddress() const;
+
+    int getPort() const;
+
     /**
      * @brief Gets the socket descriptor/handle for this client connection.
      *
@@ -159,37 +206,292 @@ class Client
      */
     void increaseReferenceCount();
 
-    void decreaseReferenceCount();
+    /**
+     * @brief Releases one reference to this client.
+     *
+     * @return int The number of references left after the release. Only the
+     *         caller that observes 0 may terminate the client.
+     */
+    int decreaseReferenceCount();
 
+    /**
+     * @brief Marks the client as disconnecting.
+     *
+     * On Unix-like systems the read side of the socket is also shut down, so
+     * the reactor owning the connection is woken up and can release it.
+     */
     void disconnect();
 
     bool isDisconnecting() const;
 
     void showInfo(std::ostream &os) const;
 
+    bool hasRecvBuffer() const;
+
+    /**
+     * @brief Lends a receive buffer of size bytes to the client. It is given
+     * back to source by releaseRecvBuffer().
+     */
+    void attachRecvBuffer(char *buffer, size_t size, BufferSource &source);
+
+    /**
+     * @brief Lends a buffer of m_recv_buffer_len bytes from pool.
+     */
+    void attachRecvBuffer(BufferPool &pool);
+
+    /**
+     * @brief Gives the receive buffer back to the source it came from, if one
+     * is attached. Only called while m_recv_len is 0, or when the client is
+     * terminated.
+     *
+     * The usage of the buffer since it was attached adapts m_recv_buffer_len.
+     */
+    void releaseRecvBuffer();
+
+    /**
+     * @brief Replaces a full receive buffer with one twice as large from pool,
+     * keeping its bytes.
+     *
+     * @return false if the buffer is already as large as allowed, or the
+     * memory budget has no room for the larger one.
+     */
+    bool growRecvBuffer(BufferPool &pool);
+
+    /**
+     * @brief Largest size the receive buffer may grow to, i.e. the most bytes
+     * the assembler can be handed at once.
+     */
+    size_t getRecvBufferLimit() const;
+
+    /**
+     * @brief Calls fn(const char *data, size_t len) for the unwritten segments
+     * of the outbound queue, in order, until max_bytes or max_segments is
+     * reached. The last segment is cut to fit max_bytes.
+     *
+     * Over TLS, the queue is first sealed into records up to max_bytes, and
+     * the records are gathered instead, unless the kernel encrypts.
+     *
+     * @note Must be called with m_send_mtx held.
+     *
+     * @return The number of segments gathered.
+     */
+    template <typename Fn> int gatherOutbound(size_t max_bytes, int max_segments, Fn &&fn)
+    {
+        if (sealOutbound(max_bytes, max_segments))
+        {
+            return m_tls->gatherOutput(max_bytes, max_segments, fn);
+        }
+
+        return gatherPlaintext(max_bytes, max_segments, false, fn);
+    }
+
+    /**
+     * @brief Gets the file bytes left of the front message, when they are
+     * the next bytes to write and may go from the file to the socket
+     * directly. gatherOutbound() gathers nothing past them.
+     *
+     * Over TLS, only once the kernel encrypts; otherwise gatherOutbound()
+     * reads and seals them.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    bool frontFile(OutboundFileSegment &segment);
+
+    /**
+     * @brief Drops the first bytes of the outbound queue once they have been
+     * written, popping every message written completely, or the first bytes
+     * of the records gathered over TLS.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    void consumeOutbound(size_t bytes);
+
+    /**
+     * @brief Whether gatherOutbound() has anything to write: queued messages,
+     * or over TLS, records, and queued messages once the handshake is done.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    bool hasOutbound() const;
+
+    /**
+     * @brief Bytes waiting to be written, queued and sealed.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    size_t getPendingOutboundBytes() const;
+
+    /**
+     * @brief Whether the TLS session holds decrypted bytes that did not fit in
+     * the receive buffer. The engine then hands the connection back to the
+     * assembler, with 0 bytes received, instead of reading the socket.
+     */
+    bool hasPendingInput() const;
+
+    /**
+     * @brief Appends a message to the outbound queue, applying the slow
+     * consumer policy if the queue, or every queue together, is congested, or
+     * the memory budget has no room for the message.
+     *
+     * Only messages not written yet, even partly, and not gathered by a write
+     * in flight (m_send_pinned) are dropped.
+     *
+     * @note Must be called with m_send_mtx held. On DISCONNECTED, the caller
+     * disconnects the client.
+     */
+    SendStatus queueOutbound(OutboundMessage &&message);
+
+    /**
+     * @brief Drops every queued message, when the client is terminated.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    void discardOutbound();
+
+    /**
+     * @brief Whether messages sent now are subject to the slow consumer
+     * policy: the queue is congested, or every queue together is.
+     *
+     * @note Must be called with m_send_mtx held.
+     */
+    bool isOutboundCongested() const;
+
     /**
      * @brief Buffer for receiving data from the client.
      *
-     * Fixed-size buffer that stores incoming data from recv() operations.
-     * Size defined by MAX_BUFFER_LENGHT_FOR_REQUESTS to accommodate
-     * the maximum expected request size.
+     * Only attached while a read is in flight or received bytes are waiting to
+     * be assembled, so idle connections hold no buffer. Null otherwise.
      *
      * @note Buffer contents are only valid up to m_recv_len bytes.
      * @warning Not null-terminated by default; treat as binary data.
      */
-    char *m_recv_buffer;
+    char *m_recv_buffer = nullptr;
+
+    /**
+     * @brief Size of the attached receive buffer, 0 if none is attached.
+     */
+    size_t m_recv_capacity = 0;
 
-    int m_max_buffer_len;
+    /**
+     * @brief Where the attached receive buffer goes back to.
+     */
+    BufferSource *m_recv_buffer_source = nullptr;
+
+    /**
+     * @brief Size of the receive buffers attached to this client, adapted to
+     * its traffic within the limits of the sizing policy.
+     */
+    size_t m_recv_buffer_len;
 
     int m_recv_len;
-    int m_send_len;
+
+    /**
+     * @brief Bytes of the front outbound message already written to the socket.
+     *
+     * A vectored write may end in the middle of any message. Protected by
+     * m_send_mtx.
+     */
+    size_t m_send_len;
 
     bool m_is_sending;
 
-    std::queue<std::vector<char>> m_outbound_message_queue;
+    /**
+     * @brief Bytes of the outbound queue held in memory and not written yet,
+     * file ranges aside. Protected by m_send_mtx.
+     */
+    size_t m_outbound_bytes = 0;
+
+    /**
+     * @brief Front messages of the outbound queue gathered by a write still
+     * in flight (IOCP), which must stay queued until it completes. Protected
+     * by m_send_mtx.
+     */
+    size_t m_send_pinned = 0;
+
+    /**
+     * @brief Messages waiting to be written. As many of them as the batch
+     * limits allow are written with a single gather call. Protected by
+     * m_send_mtx.
+     */
+    std::deque<OutboundMessage> m_outbound_message_queue;
 
     std::mutex m_send_mtx;
 
+    /**
+     * @brief Parsing state of the assembler for this connection, created when
+     * it is accepted. Only used by the task assembling the client, one at a
+     * time.
+     */
+    std::unique_ptr<AssemblerState> m_assembler_state;
+
+    /**
+     * @brief TLS session of the connection, null for plaintext connections.
+     * Used with m_send_mtx held.
+     */
+    std::unique_ptr<TlsSession> m_tls;
+
+    /**
+     * @brief Node of the connection in the ConnectionTimer of its I/O thread.
+     */
+    TimerNode<Client> m_timer;
+
+    /**
+     * @brief When bytes were last received, in ConnectionTimer::clock()
+     * milliseconds. Only accessed by the I/O thread of the connection.
+     */
+    uint64_t m_last_receive_ms = 0;
+
+    /**
+     * @brief When bytes were last written, and since when the outbound queue
+     * waits for the socket to be writable (0 while it does not). Updated with
+     * m_send_mtx held.
+     */
+    std::atomic<uint64_t> m_last_send_ms{0};
+    std::atomic<uint64_t> m_send_blocked_since{0};
+
+    /**
+     * @brief Phase of the message being received, and since when, as of the
+     * last assembling.
+     */
+    std::atomic<ReadPhase> m_read_phase{ReadPhase::IDLE};
+    std::atomic<uint64_t> m_read_phase_since{0};
+
+    /**
+     * @brief IPv4 address the connection counts against in the AddressLimiter
+     * of the server, in network byte order. 0 if it is not limited.
+     */
+    uint32_t m_source_address = 0;
+
+    /**
+     * @brief Credentials of a local connection, none for TCP connections.
+     */
+    std::optional<PeerCredentials> m_peer;
+
+#ifndef _WIN32
+    /**
+     * @brief Index of the reactor thread that owns this connection.
+     *
+     * Assigned once when the connection is accepted. All receives of the
+     * connection happen on that reactor's thread.
+     */
+    int m_reactor = -1;
+
+    /**
+     * @brief Whether the reactor may read into m_recv_buffer.
+     *
+     * Cleared when received bytes are handed off to an assembler worker and set
+     * again when the worker posts the next receive. Only accessed from the
+     * owning reactor thread.
+     */
+    bool m_recv_armed = false;
+#else
+    /**
+     * @brief Whether the pending WSARecv is a zero-byte read, posted while no
+     * receive buffer is attached, that only reports the socket is readable.
+     */
+    bool m_recv_probe = false;
+#endif
+
   private:
     /* ----------------
      * Private attrbutes
@@ -199,9 +501,10 @@ class Client
     /**
      * @brief Unique identifier assigned to this client connection.
      *
-     * This ID is generated by the server's AUTOGENERATED_ID counter when the
-     * client connects. Used as the key in the server's m_client_list map and
-     * for logging/debugging purposes to track individual client sessions.
+     * Assigned by the server's ClientTable when the client connects: slot in
+     * the low 32 bits, slot generation in the high 32 bits. Used to look the
+     * client up and for logging/debugging purposes to track individual client
+     * sessions.
      *
      * @note This ID is immutable once assigned and remains valid for the
      *       lifetime of the client connection.
@@ -265,6 +568,129 @@ class Client
      */
     std::atomic<bool> m_is_disconnecting;
 
+    RecvBufferSizing *m_recv_buffer_sizing;
+
+    OutboundBudget *m_outbound_budget;
+
+    MemoryBudget *m_memory_budget;
+
+    /**
+     * @brief Whether the outbound queue crossed its high watermark and was not
+     * written down to its low watermark yet. Protected by m_send_mtx.
+     */
+    bool m_outbound_congested = false;
+
+    /**
+     * @brief gatherOutbound() without TLS. Stops at the file range of a
+     * message, unless read_files, where its bytes are read in chunks of one
+     * record.
+     */
+    template <typename Fn> int gatherPlaintext(size_t max_bytes, int max_segments, bool read_files, Fn &&fn) const
+    {
+        size_t bytes = 0;
+        int segments = 0;
+        size_t offset = m_send_len;
+
+        for (const OutboundMessage &message : m_outbound_message_queue)
+        {
+            message.forEachSegment(offset, [&](const char *data, size_t len) {
+                if (segments < max_segments && bytes < max_bytes)
+                {
+                    len = std::min(len, max_bytes - bytes);
+                    fn(data, len);
+                    bytes += len;
+                    segments++;
+                }
+            });
+
+            if (segments == max_segments || bytes == max_bytes)
+            {
+                break;
+            }
+
+            if (message.file.length > 0)
+            {
+                if (read_files)
+                {
+                    uint64_t start = offset > message.bufferedSize() ? offset - message.bufferedSize() : 0;
+                    char chunk[TLS_RECORD_PLAINTEXT_BYTES];
+
+                    while (segments < max_segments && bytes < max_bytes && start < message.file.length)
+                    {
+                        size_t len = static_cast<size_t>(
+                            std::min<uint64_t>({sizeof(chunk), max_bytes - bytes, message.file.length - start}));
+                        long read = message.file.file->read(message.file.offset + start, chunk, len);
+
+                        // A file cut short leaves the rest unwritten, which closes the connection
+                        if (read <= 0)
+                        {
+                            break;
+                        }
+
+                        fn(chunk, static_cast<size_t>(read));
+                        bytes += static_cast<size_t>(read);
+                        segments++;
+                        start += static_cast<uint64_t>(read);
+                    }
+                }
+
+                break;
+            }
+
+            offset = 0;
+        }
+
+        return segments;
+    }
+
+    /**
+     * @brief Whether queued messages are written as they are: without TLS,
+     * or once the kernel encrypts.
+     */
+    bool writesPlaintext();
+
+    /**
+     * @brief consumeOutbound() without TLS.
+     */
+    void consumePlaintext(size_t bytes);
+
+    /**
+     * @brief Seals queued messages into records of the TLS session, until
+     * max_bytes of records wait to be written. Hands the encryption to the
+     * kernel instead when it can take it over.
+     *
+     * @return Whether the records are to be written rather than the queue.
+     */
+    bool sealOutbound(size_t max_bytes, int max_segments);
+
+    /**
+     * @brief Removes the queued messages in [first, last), counting them as
+     * dropped.
+     */
+    void dropOutbound(size_t first, size_t last);
+
+    /**
+     * @brief Accounts for bytes leaving the outbound queue, written or
+     * dropped, and clears the congestion once back to a low watermark.
+     */
+    void releaseOutboundBytes(size_t bytes);
+
+    /**
+     * @brief Most bytes held by the attached buffer, and whether it had to
+     * grow, since it was attached.
+     */
+    size_t m_recv_peak = 0;
+    bool m_recv_grew = false;
+
+    /**
+     * @brief Consecutive buffers that had to grow, and that stayed mostly
+     * empty, feeding the hysteresis of m_recv_buffer_len.
+     */
+    int m_grow_streak = 0;
+    int m_shrink_streak = 0;
+
+    void adaptRecvBufferLen();
+
 #ifdef _WIN32
     OVERLAPPED m_recv_overlapped{};
     OVERLAPPED m_send_overlapped{};
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "Client.h"
+
+namespace pulse::net
+{
+
+/**
+ * @class ClientTable
+ * @brief Fixed-capacity table of the connected clients, indexed by client id.
+ *
+ * A client id encodes the slot of the client in its low 32 bits and the
+ * generation of the slot in its high 32 bits. The generation is bumped every
+ * time a slot is reclaimed, so a stale id never resolves to the client that
+ * later reuses its slot.
+ *
+ * Lookups never lock. Every slot has a single state word holding its
+ * generation, an alive flag and a pin count. A lookup pins the slot with a CAS
+ * while it takes a reference to the client. Reclamation first clears the alive
+ * flag, so no new lookup can succeed, and only frees the client once no pin is
+ * left and no lookup resurrected a reference in between. Free slots are kept
+ * in a lock-free stack.
+ */
+class ClientTable
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit ClientTable(uint32_t capacity)
+        : m_capacity(capacity), m_slots(std::make_unique<Slot[]>(capacity)), m_free_head(EMPTY)
+    {
+        // Every slot starts in the free stack, lowest index on top
+        for (uint32_t i = capacity; i > 0; i--)
+        {
+            m_slots[i - 1].next_free.store(static_cast<uint32_t>(m_free_head.load()), std::memory_order_relaxed);
+            m_free_head.store(i - 1);
+        }
+    }
+
+    ~ClientTable()
+    {
+        for (uint32_t i = 0; i < m_capacity; i++)
+        {
+            delete m_slots[i].client;
+        }
+    }
+
+    ClientTable(const ClientTable &table) = delete;
+    ClientTable(ClientTable &&table) = delete;
+    ClientTable &operator=(const ClientTable &table) = delete;
+    ClientTable &operator=(ClientTable &&table) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Creates a client in a free slot.
+     *
+     * @param create Called with the id of the new client, returns the client.
+     * @return The client, holding the reference the caller owns, or nullptr if
+     * the table is full.
+     */
+    template <typename Factory> Client *add(Factory &&create)
+    {
+        uint32_t slot_index;
+
+        if (!popFree(slot_index))
+        {
+            return nullptr;
+        }
+
+        Slot &slot = m_slots[slot_index];
+        uint64_t generation = slot.state.load(std::memory_order_relaxed) >> GENERATION_SHIFT;
+        uint64_t id = (generation << GENERATION_SHIFT) | slot_index;
+
+        slot.client = create(id);
+        slot.state.store((generation << GENERATION_SHIFT) | ALIVE, std::memory_order_release);
+
+        return slot.client;
+    }
+
+    /**
+     * @brief Gets the client with a new reference, or nullptr if the id does
+     * not belong to a live client.
+     */
+    Client *acquire(uint64_t id)
+    {
+        if (!pin(id, true))
+        {
+            return nullptr;
+        }
+
+        Client *client = m_slots[slotOf(id)].client;
+        client->increaseReferenceCount();
+        unpin(id);
+
+        return client;
+    }
+
+    /**
+     * @brief Frees the client if nothing references it anymore.
+     *
+     * Called by whoever released the last reference of a disconnecting client.
+     * If a concurrent lookup took a new reference meanwhile, the client is kept
+     * and the owner of that reference calls remove() again when releasing it.
+     *
+     * @param release Called with the client right before it is deleted.
+     */
+    template <typename Release> void remove(uint64_t id, Release &&release)
+    {
+        if (slotOf(id) >= m_capacity)
+        {
+            return;
+        }
+
+        Slot &slot = m_slots[slotOf(id)];
+        uint64_t generation = id >> GENERATION_SHIFT;
+
+        // No new lookup may succeed from now on
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        while ((state >> GENERATION_SHIFT) == generation && (state & ALIVE) &&
+               !slot.state.compare_exchange_weak(state, state & ~ALIVE, std::memory_order_acq_rel))
+        {
+        }
+
+        while (true)
+        {
+            // Waits for in-flight lookups, then pins the slot so the client can
+            // be inspected without another remover freeing it
+            if (!pin(id, false))
+            {
+                return;
+            }
+
+            if (slot.client->getReferenceCount() != 0)
+            {
+                unpin(id);
+                return;
+            }
+
+            // Only succeeds if our pin is the only one: bumps the generation,
+            // which makes every id of the old client stale
+            uint64_t pinned = (generation << GENERATION_SHIFT) | 1;
+            uint64_t next = ((generation + 1) & GENERATION_MASK) << GENERATION_SHIFT;
+
+            if (slot.state.compare_exchange_strong(pinned, next, std::memory_order_acq_rel))
+            {
+                break;
+            }
+
+            unpin(id);
+            std::this_thread::yield();
+        }
+
+        Client *client = slot.client;
+        slot.client = nullptr;
+
+        release(*client);
+        delete client;
+
+        pushFree(slotOf(id));
+    }
+
+    /**
+     * @brief Calls fn for every live client. Each client is pinned (not
+     * referenced) during the call, so fn must not keep it.
+     */
+    template <typename Fn> void forEach(Fn &&fn) const
+    {
+        for (uint32_t i = 0; i < m_capacity; i++)
+        {
+            uint64_t state = m_slots[i].state.load(std::memory_order_acquire);
+            uint64_t id = (state & ~(ALIVE | PIN_MASK)) | i;
+
+            if ((state & ALIVE) && pin(id, true))
+            {
+                fn(*m_slots[i].client);
+                unpin(id);
+            }
+        }
+    }
+
+    uint32_t getCapacity() const
+    {
+        return m_capacity;
+    }
+
+  private:
+    static constexpr int GENERATION_SHIFT = 32;
+    static constexpr uint64_t GENERATION_MASK = 0xFFFFFFFF;
+    static constexpr uint64_t ALIVE = uint64_t(1) << 31;
+    static constexpr uint64_t PIN_MASK = ALIVE - 1;
+    static constexpr uint64_t EMPTY = 0xFFFFFFFF;
+
+    /**
+     * @struct Slot
+     * @brief A client and its state word: generation (high 32 bits), alive flag
+     * (bit 31) and pin count (low 31 bits).
+     */
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> state{0};
+        Client *client = nullptr;
+        std::atomic<uint32_t> next_free{0};
+    };
+
+    uint32_t m_capacity;
+
+    std::unique_ptr<Slot[]> m_slots;
+
+    /**
+     * @brief Top of the free slot stack: slot index in the low 32 bits and a
+     * tag in the high 32 bits, bumped on every push to avoid ABA.
+     */
+    std::atomic<uint64_t> m_free_head;
+
+    static uint32_t slotOf(uint64_t id)
+    {
+        return static_cast<uint32_t>(id & GENERATION_MASK);
+    }
+
+    /**
+     * @brief Increments the pin count of the slot while it belongs to the
+     * generation of id (and is alive, if required).
+     *
+     * Removers do not require the slot to be alive, but wait for every lookup
+     * pin to be gone before pinning.
+     */
+    bool pin(uint64_t id, bool require_alive) const
+    {
+        if (slotOf(id) >= m_capacity)
+        {
+            return false;
+        }
+
+        Slot &slot = m_slots[slotOf(id)];
+        uint64_t generation = id >> GENERATION_SHIFT;
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+
+        while (true)
+        {
+            if ((state >> GENERATION_SHIFT) != generation || (require_alive && !(state & ALIVE)))
+            {
+                return false;
+            }
+
+            if (!require_alive && (state & PIN_MASK) != 0)
+            {
+                std::this_thread::yield();
+                state = slot.state.load(std::memory_order_acquire);
+                continue;
+            }
+
+            if (slot.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+            {
+                return true;
+            }
+        }
+    }
+
+    void unpin(uint64_t id) const
+    {
+        m_slots[slotOf(id)].state.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool popFree(uint32_t &slot_index)
+    {
+        uint64_t head = m_free_head.load(std::memory_order_acquire);
+
+        while (true)
+        {
+            uint32_t index = static_cast<uint32_t>(head & GENERATION_MASK);
+
+            if (index == EMPTY)
+            {
+                return false;
+            }
+
+            uint64_t next = (head & ~GENERATION_MASK) | m_slots[index].next_free.load(std::memory_order_relaxed);
+
+            if (m_free_head.compare_exchange_weak(head, next, std::memory_order_acq_rel))
+            {
+                slot_index = index;
+                return true;
+            }
+        }
+    }
+
+    void pushFree(uint32_t slot_index)
+    {
+        uint64_t head = m_free_head.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            uint32_t top = static_cast<uint32_t>(head & GENERATION_MASK);
+            m_slots[slot_index].next_free.store(top, std::memory_order_relaxed);
+            uint64_t next = ((head >> GENERATION_SHIFT) + 1) << GENERATION_SHIFT | slot_index;
+
+            if (m_free_head.compare_exchange_weak(head, next, std::memory_order_release))
+            {
+                return;
+            }
+        }
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "Client.h"
+#include "TimingWheel.h"
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct ConnectionTimeouts
+ * @brief How long, in milliseconds, a connection may stay without progress
+ * before it is closed. 0 disables a timeout.
+ */
+struct ConnectionTimeouts
+{
+    uint32_t idle_ms{IDLE_TIMEOUT_MS};     ///< Nothing received nor written between requests
+    uint32_t header_ms{HEADER_TIMEOUT_MS}; ///< Headers of a request not complete since its first bytes
+    uint32_t body_ms{BODY_TIMEOUT_MS};     ///< Nothing received while the body of a request is incomplete
+    uint32_t write_ms{WRITE_TIMEOUT_MS};   ///< Outbound queue blocked without any byte written
+};
+
+/**
+ * @class ConnectionTimer
+ * @brief Enforces the ConnectionTimeouts of the connections of one I/O
+ * thread, with a TimingWheel of TIMER_WHEEL_TICK_MS ticks.
+ *
+ * Activity never touches the wheel: I/O only stamps the client (see
+ * Client::m_last_receive_ms). Every connection has one node, and when it fires
+ * the deadline is computed from the stamps: past, the connection has timed
+ * out; otherwise the node is scheduled again for it. The node is never
+ * scheduled further than the shortest timeout, so deadlines brought forward
+ * by other threads (a request starting, a write blocking) are still enforced
+ * at most that late.
+ *
+ * @note Only used by the I/O thread owning it.
+ */
+class ConnectionTimer
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    ConnectionTimer() : m_now(clock()), m_wheel(m_now / TIMER_WHEEL_TICK_MS)
+    {
+    }
+
+    ConnectionTimer(const ConnectionTimer &timer) = delete;
+    ConnectionTimer &operator=(const ConnectionTimer &timer) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Monotonic clock every connection timestamp is taken from, in
+     * milliseconds.
+     */
+    static uint64_t clock()
+    {
+        auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    }
+
+    /**
+     * @brief Sets the timeouts. Must be called before any connection is added.
+     */
+    void configure(const ConnectionTimeouts &timeouts)
+    {
+        m_timeouts = timeouts;
+        m_check_ms = 0;
+
+        for (uint32_t timeout : {timeouts.idle_ms, timeouts.header_ms, timeouts.body_ms, timeouts.write_ms})
+        {
+            if (timeout > 0 && (m_check_ms == 0 || timeout < m_check_ms))
+            {
+                m_check_ms = timeout;
+            }
+        }
+    }
+
+    /**
+     * @brief Time of the current iteration of the I/O thread, refreshed by
+     * update() once per batch of events.
+     */
+    uint64_t now() const
+    {
+        return m_now;
+    }
+
+    void update(uint64_t now = clock())
+    {
+        m_now = std::max(m_now, now);
+    }
+
+    void add(Client &client)
+    {
+        client.m_last_receive_ms = m_now;
+
+        if (m_check_ms > 0)
+        {
+            schedule(client, m_now + m_check_ms);
+        }
+    }
+
+    void remove(Client &client)
+    {
+        m_wheel.cancel(client.m_timer);
+    }
+
+    /**
+     * @brief Stamps a receive on the client, postponing its idle and body
+     * timeouts.
+     */
+    void touch(Client &client)
+    {
+        client.m_last_receive_ms = m_now;
+    }
+
+    /**
+     * @brief Calls on_timeout(Client &, const char *timeout) for every
+     * connection past one of its deadlines, as of now(). The connection is no
+     * longer timed, on_timeout is expected to close it.
+     */
+    template <typename OnTimeout> void expire(OnTimeout &&on_timeout)
+    {
+        m_wheel.advance(m_now / TIMER_WHEEL_TICK_MS, [this, &on_timeout](Client &client) {
+            const char *timeout = nullptr;
+            uint64_t deadline = getDeadline(client, timeout);
+
+            if (deadline <= m_now)
+            {
+                on_timeout(client, timeout);
+            }
+            else
+            {
+                schedule(client, std::min(deadline, m_now + m_check_ms));
+            }
+        });
+    }
+
+    /**
+     * @brief Milliseconds the I/O thread may wait for events before expire()
+     * has something to do, -1 if no connection is timed.
+     */
+    int nextTimeout() const
+    {
+        uint64_t ticks = m_wheel.ticksUntilNext();
+
+        if (ticks == 0)
+        {
+            return -1;
+        }
+
+        uint64_t due = (m_wheel.now() + ticks) * TIMER_WHEEL_TICK_MS;
+        return due > m_now ? static_cast<int>(std::min<uint64_t>(due - m_now, INT32_MAX)) : 0;
+    }
+
+  private:
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    uint64_t m_now;
+
+    TimingWheel<Client> m_wheel;
+
+    ConnectionTimeouts m_timeouts{};
+
+    /**
+     * @brief Shortest enabled timeout, the longest a node is scheduled for. 0
+     * if every timeout is disabled.
+     */
+    uint32_t m_check_ms = 0;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    /**
+     * @brief Schedules the node of the client for the first tick not earlier
+     * than deadline.
+     */
+    void schedule(Client &client, uint64_t deadline)
+    {
+        m_wheel.schedule(client.m_timer, (deadline + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS);
+    }
+
+    /**
+     * @brief Earliest deadline of the client, and the name of the timeout it
+     * comes from.
+     */
+    uint64_t getDeadline(const Client &client, const char *&timeout) const
+    {
+        uint64_t deadline = UINT64_MAX;
+        auto check = [&deadline, &timeout](uint64_t since, uint32_t limit, const char *name) {
+            if (limit > 0 && since + limit < deadline)
+            {
+                deadline = since + limit;
+                timeout = name;
+            }
+        };
+
+        uint64_t blocked_since = client.m_send_blocked_since.load(std::memory_order_acquire);
+
+        switch (client.m_read_phase.load(std::memory_order_acquire))
+        {
+        case ReadPhase::IDLE:
+            // A blocked write is bounded by the write timeout alone
+            if (blocked_since == 0)
+            {
+                uint64_t last_send = client.m_last_send_ms.load(std::memory_order_relaxed);
+                check(std::max(client.m_last_receive_ms, last_send), m_timeouts.idle_ms, "idle");
+            }
+            break;
+
+        case ReadPhase::HEADER:
+            check(client.m_read_phase_since.load(std::memory_order_relaxed), m_timeouts.header_ms, "header");
+            break;
+
+        case ReadPhase::BODY:
+            check(client.m_last_receive_ms, m_timeouts.body_ms, "body");
+            break;
+        }
+
+        if (blocked_since > 0)
+        {
+            check(blocked_since, m_timeouts.write_ms, "write");
+        }
+
+        return deadline;
+    }
+};
+
+} // namespace pulse::net
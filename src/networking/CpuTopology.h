@@ -0,0 +1,610 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pulse::net
+{
+
+/**
+ * @brief CPU ids a thread can be placed on are below it: the size of a
+ * cpu_set_t, or the bits of a thread affinity mask on Windows.
+ */
+#ifdef _WIN32
+inline constexpr int CPU_ID_LIMIT = static_cast<int>(sizeof(DWORD_PTR) * 8);
+#else
+inline constexpr int CPU_ID_LIMIT = CPU_SETSIZE;
+#endif
+
+/**
+ * @struct LogicalCpu
+ * @brief A hardware thread, with the physical core, package and NUMA node it
+ * belongs to.
+ */
+struct LogicalCpu
+{
+    int id{0};
+    int core{0};    ///< Index of its physical core, unique across packages
+    int package{0}; ///< Socket
+    int node{0};    ///< NUMA node
+};
+
+/**
+ * @brief How the threads of a pool are spread over the CPUs.
+ */
+enum class PlacementMode
+{
+    NONE,           ///< Threads float, the scheduler places them
+    CPU_LIST,       ///< Thread i runs on the i-th CPU of a list, wrapping around
+    PHYSICAL_CORES, ///< Thread i runs on the hardware threads of the i-th physical core
+    NUMA_NODES      ///< Thread i runs on any CPU of the i-th NUMA node
+};
+
+/**
+ * @struct ThreadPlacement
+ * @brief Placement policy of the threads of a pool.
+ *
+ * Threads are placed by their index in the pool, so two pools with the same
+ * policy share their first CPUs; give them disjoint CPU lists to keep them
+ * apart.
+ */
+struct ThreadPlacement
+{
+    PlacementMode mode{PlacementMode::NONE};
+    std::vector<int> cpus; ///< CPUs of a CPU_LIST placement
+
+    static ThreadPlacement cpuList(std::vector<int> cpus)
+    {
+        return ThreadPlacement{PlacementMode::CPU_LIST, std::move(cpus)};
+    }
+
+    static ThreadPlacement physicalCores()
+    {
+        return ThreadPlacement{PlacementMode::PHYSICAL_CORES, {}};
+    }
+
+    static ThreadPlacement numaNodes()
+    {
+        return ThreadPlacement{PlacementMode::NUMA_NODES, {}};
+    }
+};
+
+/**
+ * @struct PlacedThread
+ * @brief Where a thread of a pool ended up running, for reports.
+ */
+struct PlacedThread
+{
+    int index{-1};
+    std::vector<int> cpus; ///< CPUs the thread may run on, empty if it floats
+    int node{-1};          ///< NUMA node of those CPUs, -1 if it floats or spans several
+    std::string status;    ///< "ok", "floating", or why the affinity was not set
+};
+
+/**
+ * @brief Formats CPU ids in the kernel cpulist format, like "0-3,8".
+ */
+inline std::string formatCpuList(std::vector<int> cpus)
+{
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+    std::string list;
+
+    for (size_t i = 0; i < cpus.size();)
+    {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1)
+        {
+            last++;
+        }
+
+        list += (list.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (last > i)
+        {
+            list += "-" + std::to_string(cpus[last]);
+        }
+
+        i = last + 1;
+    }
+
+    return list;
+}
+
+/**
+ * @brief Parses CPU ids in the kernel cpulist format, like "0-3,8".
+ *
+ * @return false if the list is empty, malformed or names an id at or above
+ * CPU_ID_LIMIT.
+ */
+inline bool parseCpuList(std::string_view list, std::vector<int> &cpus)
+{
+    std::vector<int> parsed;
+
+    auto number = [](std::string_view text, int &value) {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size() && value >= 0 && value < CPU_ID_LIMIT;
+    };
+
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        std::string_view range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        while (!range.empty() && (range.back() == ' ' || range.back() == '\n'))
+        {
+            range.remove_suffix(1);
+        }
+
+        while (!range.empty() && range.front() == ' ')
+        {
+            range.remove_prefix(1);
+        }
+
+        size_t dash = range.find('-');
+        int first = 0;
+        int last = 0;
+
+        if (!number(range.substr(0, dash), first) ||
+            !number(dash == std::string_view::npos ? range : range.substr(dash + 1), last) || last < first)
+        {
+            return false;
+        }
+
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            parsed.push_back(cpu);
+        }
+    }
+
+    if (parsed.empty())
+    {
+        return false;
+    }
+
+    cpus = std::move(parsed);
+    return true;
+}
+
+/**
+ * @brief Spells a placement the way parseThreadPlacement() reads it.
+ */
+inline std::string getThreadPlacementName(const ThreadPlacement &placement)
+{
+    switch (placement.mode)
+    {
+    case PlacementMode::CPU_LIST:
+        return formatCpuList(placement.cpus);
+    case PlacementMode::PHYSICAL_CORES:
+        return "cores";
+    case PlacementMode::NUMA_NODES:
+        return "nodes";
+    default:
+        return "none";
+    }
+}
+
+/**
+ * @brief Parses a placement: "none", "cores", "nodes", or a CPU list.
+ *
+ * @return false if the text is none of them.
+ */
+inline bool parseThreadPlacement(std::string_view text, ThreadPlacement &placement)
+{
+    if (text == "none")
+    {
+        placement = ThreadPlacement{};
+        return true;
+    }
+
+    if (text == "cores")
+    {
+        placement = ThreadPlacement::physicalCores();
+        return true;
+    }
+
+    if (text == "nodes")
+    {
+        placement = ThreadPlacement::numaNodes();
+        return true;
+    }
+
+    std::vector<int> cpus;
+
+    if (!parseCpuList(text, cpus))
+    {
+        return false;
+    }
+
+    placement = ThreadPlacement::cpuList(std::move(cpus));
+    return true;
+}
+
+/**
+ * @class CpuTopology
+ * @brief CPUs the process may run on, grouped in physical cores and NUMA
+ * nodes, and the CPUs a placement gives every thread of a pool.
+ *
+ * On Linux it comes from sysfs, restricted to the affinity of the process.
+ * On Windows it comes from GetLogicalProcessorInformation, which only covers
+ * the processor group of the process (up to 64 CPUs).
+ */
+class CpuTopology
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit CpuTopology(std::vector<LogicalCpu> cpus) : m_cpus(std::move(cpus))
+    {
+        std::sort(m_cpus.begin(), m_cpus.end(),
+                  [](const LogicalCpu &a, const LogicalCpu &b) { return a.id < b.id; });
+
+        // Cores are ordered by node, so the first threads of a pool fill one node before the next
+        std::map<std::pair<int, int>, std::vector<int>> cores;
+        std::map<int, std::vector<int>> nodes;
+
+        for (const LogicalCpu &cpu : m_cpus)
+        {
+            cores[{cpu.node, cpu.core}].push_back(cpu.id);
+            nodes[cpu.node].push_back(cpu.id);
+            m_packages = std::max(m_packages, cpu.package + 1);
+        }
+
+        for (auto &[key, core] : cores)
+        {
+            m_cores.push_back(std::move(core));
+        }
+
+        for (auto &[node, node_cpus] : nodes)
+        {
+            m_nodes.emplace_back(node, std::move(node_cpus));
+        }
+    }
+
+    /**
+     * @brief Topology of the machine, detected on first use.
+     */
+    static const CpuTopology &system()
+    {
+        static const CpuTopology topology(detect());
+        return topology;
+    }
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief CPUs thread index of a pool may run on, empty to let it float.
+     */
+    std::vector<int> cpusFor(const ThreadPlacement &placement, int index) const
+    {
+        switch (placement.mode)
+        {
+        case PlacementMode::CPU_LIST:
+            return placement.cpus.empty() ? std::vector<int>()
+                                          : std::vector<int>{placement.cpus[index % placement.cpus.size()]};
+        case PlacementMode::PHYSICAL_CORES:
+            return m_cores.empty() ? std::vector<int>() : m_cores[index % m_cores.size()];
+        case PlacementMode::NUMA_NODES:
+            return m_nodes.empty() ? std::vector<int>() : m_nodes[index % m_nodes.size()].second;
+        default:
+            return {};
+        }
+    }
+
+    /**
+     * @brief NUMA node of a set of CPUs, or -1 if it is empty or spans
+     * several nodes.
+     */
+    int nodeOf(const std::vector<int> &cpus) const
+    {
+        int node = -1;
+
+        for (int cpu : cpus)
+        {
+            const LogicalCpu *found = find(cpu);
+
+            if (!found || (node >= 0 && found->node != node))
+            {
+                return -1;
+            }
+
+            node = found->node;
+        }
+
+        return node;
+    }
+
+    /**
+     * @brief Throws if a placement names a CPU the process cannot run on.
+     */
+    void validate(const ThreadPlacement &placement) const
+    {
+        if (placement.mode != PlacementMode::CPU_LIST)
+        {
+            return;
+        }
+
+        if (placement.cpus.empty())
+        {
+            throw std::invalid_argument("A CPU list placement needs at least one CPU");
+        }
+
+        for (int cpu : placement.cpus)
+        {
+            if (!find(cpu))
+            {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " is not available to the process");
+            }
+        }
+    }
+
+    const std::vector<LogicalCpu> &getCpus() const
+    {
+        return m_cpus;
+    }
+
+    size_t getCoreCount() const
+    {
+        return m_cores.size();
+    }
+
+    size_t getNodeCount() const
+    {
+        return m_nodes.size();
+    }
+
+    void show(std::ostream &os) const
+    {
+        os << "CPU topology: " << m_nodes.size() << " NUMA node(s), " << m_packages << " package(s), "
+           << m_cores.size() << " physical core(s), " << m_cpus.size() << " logical CPU(s)\n";
+        os << std::left << std::setfill(' ') << std::setw(6) << "Node" << std::setw(3) << "|" << "CPUs\n";
+        os << "---------------------------------------\n";
+
+        for (const auto &[node, cpus] : m_nodes)
+        {
+            os << std::left << std::setw(6) << node << std::setw(3) << "|" << formatCpuList(cpus) << "\n";
+        }
+    }
+
+  private:
+    std::vector<LogicalCpu> m_cpus;
+    std::vector<std::vector<int>> m_cores;
+    std::vector<std::pair<int, std::vector<int>>> m_nodes;
+    int m_packages = 0;
+
+    const LogicalCpu *find(int id) const
+    {
+        auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), id,
+                                   [](const LogicalCpu &cpu, int value) { return cpu.id < value; });
+        return it != m_cpus.end() && it->id == id ? &*it : nullptr;
+    }
+
+#ifdef _WIN32
+    static std::vector<LogicalCpu> detect()
+    {
+        DWORD length = 0;
+        GetLogicalProcessorInformation(nullptr, &length);
+
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> entries(length /
+                                                                  sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        DWORD_PTR process_mask = 0;
+        DWORD_PTR system_mask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+
+        std::vector<LogicalCpu> cpus;
+
+        for (int i = 0; i < static_cast<int>(sizeof(DWORD_PTR) * 8); i++)
+        {
+            if (process_mask & (static_cast<DWORD_PTR>(1) << i))
+            {
+                cpus.push_back(LogicalCpu{i, i, 0, 0});
+            }
+        }
+
+        // Without the relations, every CPU is a core of its own
+        if (entries.empty() || !GetLogicalProcessorInformation(entries.data(), &length))
+        {
+            return cpus;
+        }
+
+        int core = 0;
+        int package = 0;
+
+        for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION &entry : entries)
+        {
+            for (LogicalCpu &cpu : cpus)
+            {
+                if (!(entry.ProcessorMask & (static_cast<ULONG_PTR>(1) << cpu.id)))
+                {
+                    continue;
+                }
+
+                if (entry.Relationship == RelationProcessorCore)
+                {
+                    cpu.core = core;
+                }
+                else if (entry.Relationship == RelationProcessorPackage)
+                {
+                    cpu.package = package;
+                }
+                else if (entry.Relationship == RelationNumaNode)
+                {
+                    cpu.node = static_cast<int>(entry.NumaNode.NodeNumber);
+                }
+            }
+
+            core += entry.Relationship == RelationProcessorCore ? 1 : 0;
+            package += entry.Relationship == RelationProcessorPackage ? 1 : 0;
+        }
+
+        return cpus;
+    }
+#else
+    static int readNumber(const std::filesystem::path &path, int fallback)
+    {
+        std::ifstream file(path);
+        int value = fallback;
+        return file >> value ? value : fallback;
+    }
+
+    static std::vector<LogicalCpu> detect()
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+
+        // Missing on kernels without NUMA support, where every CPU is on node 0
+        std::map<int, int> node_of;
+        std::error_code error;
+
+        for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+        {
+            std::string name = entry.path().filename().string();
+            std::vector<int> node_cpus;
+            std::string list;
+
+            if (name.rfind("node", 0) != 0 || !std::getline(std::ifstream(entry.path() / "cpulist"), list) ||
+                !parseCpuList(list, node_cpus))
+            {
+                continue;
+            }
+
+            int node = 0;
+            std::from_chars(name.data() + 4, name.data() + name.size(), node);
+
+            for (int cpu : node_cpus)
+            {
+                node_of[cpu] = node;
+            }
+        }
+
+        std::vector<LogicalCpu> cpus;
+        std::map<std::pair<int, int>, int> cores;
+        std::filesystem::path root = "/sys/devices/system/cpu";
+
+        for (int id = 0; id < CPU_SETSIZE; id++)
+        {
+            if (!CPU_ISSET(id, &allowed))
+            {
+                continue;
+            }
+
+            std::filesystem::path topology = root / ("cpu" + std::to_string(id)) / "topology";
+            LogicalCpu cpu{id, 0, readNumber(topology / "physical_package_id", 0), node_of[id]};
+
+            // Core ids are only unique within a package
+            auto core = cores.try_emplace({cpu.package, readNumber(topology / "core_id", id)}, cores.size());
+            cpu.core = core.first->second;
+
+            cpus.push_back(cpu);
+        }
+
+        return cpus;
+    }
+#endif
+};
+
+/**
+ * @brief Restricts the calling thread to the CPUs its placement gives it,
+ * before it allocates its own memory.
+ *
+ * Memory is placed on the node of the thread that first touches it, so
+ * queues and buffers a thread allocates once placed stay on its node.
+ */
+inline PlacedThread placeCurrentThread(const ThreadPlacement &placement, int index)
+{
+    const CpuTopology &topology = CpuTopology::system();
+
+    PlacedThread placed{index, topology.cpusFor(placement, index), -1, "ok"};
+    placed.node = topology.nodeOf(placed.cpus);
+
+    if (placed.cpus.empty())
+    {
+        placed.status = "floating";
+        return placed;
+    }
+
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+
+    for (int cpu : placed.cpus)
+    {
+        if (cpu < CPU_ID_LIMIT)
+        {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+    {
+        placed.status = "error " + std::to_string(GetLastError());
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (int cpu : placed.cpus)
+    {
+        if (cpu < CPU_ID_LIMIT)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    if (error != 0)
+    {
+        placed.status = std::strerror(error);
+    }
+#endif
+
+    return placed;
+}
+
+/**
+ * @brief Reports where the threads of a pool run.
+ */
+inline void showPlacedThreads(std::ostream &os, std::string_view pool, const std::vector<PlacedThread> &threads)
+{
+    for (const PlacedThread &thread : threads)
+    {
+        os << std::left << std::setfill(' ') << std::setw(16)
+           << std::string(pool) + " " + std::to_string(thread.index) << std::setw(3) << "|" << std::setw(16)
+           << (thread.cpus.empty() ? "any" : formatCpuList(thread.cpus)) << std::setw(3) << "|" << std::setw(6)
+           << (thread.node < 0 ? "-" : std::to_string(thread.node)) << std::setw(3) << "|" << thread.status << "\n";
+    }
+}
+
+} // namespace pulse::net
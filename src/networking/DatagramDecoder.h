@@ -0,0 +1,43 @@
+#pragma once
+
+#include "LoggerManager.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pulse::net
+{
+
+/**
+ * @class DatagramDecoder
+ * @brief Turns datagrams into messages, the counterpart of a
+ * TCPMessageAssembler for a UdpServer.
+ *
+ * A datagram is a whole unit, so nothing is kept between two of them: there
+ * is no per-source state, and a datagram that does not decode is dropped on
+ * its own. Called concurrently by every receiving thread of the server.
+ */
+template <typename T> class DatagramDecoder
+{
+  public:
+    using MessageType = T;
+
+    virtual ~DatagramDecoder() = default;
+
+    /**
+     * @brief Appends the messages a datagram holds to messages, none or
+     * several.
+     *
+     * @return false if the datagram is malformed, in which case the messages
+     * it appended are dropped with it.
+     */
+    virtual bool decode(const char *data, size_t len, std::vector<std::shared_ptr<MessageType>> &messages) = 0;
+
+    inline void log(SEVERITY severity, std::string_view message) const
+    {
+        LoggerManager::get_logger()->write(severity, message);
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "DatagramDecoder.h"
+
+namespace pulse::net
+{
+
+/**
+ * @brief Decodes every datagram into one message holding its bytes.
+ */
+class DefaultDatagramDecoder : public DatagramDecoder<std::string>
+{
+  public:
+    ~DefaultDatagramDecoder() = default;
+
+    bool decode(const char *data, size_t len, std::vector<std::shared_ptr<std::string>> &messages) override
+    {
+        messages.push_back(std::make_shared<std::string>(data, len));
+        return true;
+    }
+};
+
+} // namespace pulse::net
@@ -10,8 +10,8 @@ class DefaultMessageAssembler : public TCPMessageAssembler<std::string>
   public:
     ~DefaultMessageAssembler() = default;
 
-    virtual AssemblingResult feed(uint64_t id, char *buffer, int &buffer_len, int max_buffer_len,
-                                  int last_tcp_packet_len)
+    virtual AssemblingResult feed(uint64_t /*id*/, AssemblerState * /*state*/, char *buffer, int &buffer_len,
+                                  int /*max_buffer_len*/, int /*last_tcp_packet_len*/)
     {
 
         std::vector<std::shared_ptr<std::string>> messages;
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+
+#include "Client.h"
+#include "ConnectionTimer.h"
+#include "CpuTopology.h"
+#include "NetworkPlatform.h"
+#include "SocketOptions.h"
+#include "constants.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#endif
+
+namespace pulse::net
+{
+
+/**
+ * @struct IoEngineConfig
+ * @brief Listener settings handed to an I/O engine when the server starts.
+ */
+struct IoEngineConfig
+{
+    std::string ip_address;   ///< Listening address, as given to the server (used in error messages)
+    int port{0};              ///< Listening port
+    sockaddr_in address{};    ///< Address the listening socket is bound to
+    size_t client_buffer_len; ///< Size of every client receive buffer
+
+    /**
+     * @brief Length of the accept queue of every listening socket.
+     */
+    int backlog{MAX_CONNECTION_QUEUE};
+
+    /**
+     * @brief Whether every I/O thread gets its own listening socket bound with
+     * SO_REUSEPORT, so the kernel spreads incoming connections across
+     * per-thread accept queues instead of one shared queue.
+     *
+     * @note Only supported by the Linux engines.
+     */
+    bool sharded_accept{false};
+
+    /**
+     * @brief Accept operations kept in flight per listening socket by the
+     * completion based engines (AcceptEx, io_uring accepts). Readiness based
+     * engines drain the whole queue on every wake-up instead.
+     */
+    int accepts_per_listener{1};
+
+    /**
+     * @brief Most bytes and segments (iovec / WSABUF entries) coalesced from
+     * the outbound queue of a client into one vectored write.
+     */
+    size_t send_batch_bytes{SEND_BATCH_BYTES};
+    int send_batch_segments{SEND_BATCH_SEGMENTS};
+
+    /**
+     * @brief When connections without progress are closed.
+     */
+    ConnectionTimeouts timeouts{};
+
+    /**
+     * @brief Options of the listening sockets and of the sockets accepted
+     * from them.
+     */
+    SocketOptions socket_options{};
+
+    /**
+     * @brief Path of a Unix domain socket to listen on as well, for local
+     * clients, and the permissions it is created with. Empty for none.
+     *
+     * @note Only supported by the Linux engines.
+     */
+    std::string unix_path;
+    unsigned unix_mode{UNIX_SOCKET_MODE};
+
+    /**
+     * @brief CPUs the I/O threads run on, the i-th thread placed as the i-th
+     * thread of a pool.
+     */
+    ThreadPlacement placement{};
+};
+
+/**
+ * @brief Requirements of an I/O engine, the platform-specific part of
+ * TCPServer.
+ *
+ * An engine is a class template instantiated with the server that owns it
+ * (the handler), and is constructed with a reference to it. Engines are picked
+ * at compile time, so every call between the server and its engine is resolved
+ * statically.
+ *
+ * The engine accepts connections, reads into the client receive buffers and
+ * writes the outbound queues. The server only does the connection bookkeeping
+ * and the assembling. The handler exposes to its engine:
+ *
+ * - Client *addClient(int port, const std::string &ip, SOCKET_TYPE sock,
+ *   std::optional<PeerCredentials> peer): registers an accepted connection,
+ *   with the credentials of its process for the connections of the Unix
+ *   domain socket (which have no address). The returned client holds one
+ *   reference, owned by the engine until the connection is closed.
+ *   Returns nullptr if the server is full; the engine then closes the socket.
+ * - void queueAssembling(Client &client): hands off the bytes just received
+ *   (already added with Client::addBytesReceived()) to an assembler worker,
+ *   or, in run-to-completion mode, assembles and handles them right away, in
+ *   which case the server posts receives, sends and closes from within it.
+ *   The receive stays disarmed until the server calls postReceive() again.
+ * - void releaseClient(Client &client): releases one reference, terminating
+ *   the client if it was the last one of a disconnecting client.
+ * - void terminateClient(uint64_t id): removes the client right away.
+ *
+ * The server calls, always holding a reference to the client:
+ *
+ * - postReceive(): arms the next receive into the free part of the buffer.
+ *   If the server gave the receive buffer back (nothing left to assemble),
+ *   the engine waits for the connection to be readable and only then attaches
+ *   a buffer from its pool (Client::attachRecvBuffer()).
+ * - postSend(): writes the outbound queue. Called with Client::m_send_mtx held
+ *   and only when the client is not already sending.
+ * - postClose(): the client has been marked as disconnecting, the engine
+ *   must let go of the connection even if nothing is pending on it.
+ * - releaseConnection(): called once, when the client is terminated, to close
+ *   the socket and give back any resource the engine attached to it.
+ * - getAppliedSocketOptions(): the socket options of the configuration as set
+ *   on the listening socket, once started.
+ * - getPlacedThreads(): where the I/O threads run, placed with the placement
+ *   of the configuration before they allocate anything, once started.
+ *
+ * Engines enforce the timeouts of the configuration with a ConnectionTimer,
+ * stamping the receives and writes of their clients, and close the
+ * connections that time out.
+ */
+template <typename E>
+concept ValidIoEngine = requires(E engine, Client &client, const IoEngineConfig &config, int threads) {
+    engine.start(config);
+    engine.stop();
+    engine.setIoThreads(threads);
+    engine.postReceive(client);
+    engine.postSend(client);
+    engine.postClose(client);
+    engine.releaseConnection(client);
+    { engine.getAppliedSocketOptions() } -> std::convertible_to<const std::vector<AppliedSocketOption> &>;
+    { engine.getPlacedThreads() } -> std::convertible_to<const std::vector<PlacedThread> &>;
+};
+
+} // namespace pulse::net
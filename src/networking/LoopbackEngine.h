@@ -0,0 +1,523 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Client.h"
+#include "ConnectionTimer.h"
+#include "IoEngine.h"
+#include "LoggerManager.h"
+#include "NetworkPlatform.h"
+
+namespace pulse::net
+{
+
+/**
+ * @class LoopbackEngine
+ * @brief In-memory I/O engine, without sockets nor I/O threads.
+ *
+ * The peer side of every connection is driven through connect(), write(),
+ * read() and close(). Bytes written by a peer are copied into the client
+ * receive buffer as soon as its receive is armed, and everything the server
+ * sends is appended to the peer's inbound stream synchronously, so the
+ * bytes exchanged do not depend on scheduling. Timeouts are only enforced
+ * when expireTimeouts() is called, with any time. Meant for tests and for
+ * benchmarking the assembling and dispatching path without the kernel.
+ */
+template <typename Handler> class LoopbackEngine
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit LoopbackEngine(Handler &handler) : m_handler(handler)
+    {
+    }
+
+    LoopbackEngine(const LoopbackEngine &engine) = delete;
+    LoopbackEngine(LoopbackEngine &&engine) = delete;
+    LoopbackEngine &operator=(const LoopbackEngine &engine) = delete;
+    LoopbackEngine &operator=(LoopbackEngine &&engine) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Not used: every operation runs on the calling thread.
+     */
+    void setIoThreads(int threads)
+    {
+        if (threads < 1)
+        {
+            throw std::invalid_argument("I/O threads should be at least 1");
+        }
+    }
+
+    void start(const IoEngineConfig &config)
+    {
+        std::lock_guard lock(m_mtx);
+        m_config = config;
+        m_timers.configure(config.timeouts);
+    }
+
+    /**
+     * @brief Closes every connection still open.
+     */
+    void stop()
+    {
+        std::vector<Client *> closed;
+        {
+            std::lock_guard lock(m_mtx);
+            for (auto &[id, connection] : m_connections)
+            {
+                if (connection.client != nullptr)
+                {
+                    closed.push_back(closeConnection(connection));
+                }
+            }
+        }
+
+        for (Client *client : closed)
+        {
+            m_handler.releaseClient(*client);
+        }
+    }
+
+    void postReceive(Client &client)
+    {
+        Delivery delivery;
+        {
+            std::lock_guard lock(m_mtx);
+            Connection *connection = find(client);
+
+            if (connection != nullptr)
+            {
+                connection->recv_armed = true;
+                delivery = deliver(*connection);
+            }
+        }
+
+        complete(delivery);
+    }
+
+    /**
+     * @brief Moves the whole outbound queue to the peer.
+     *
+     * @note Must be called with client.m_send_mtx held.
+     */
+    void postSend(Client &client)
+    {
+        std::lock_guard lock(m_mtx);
+        Connection *connection = find(client);
+
+        size_t written = 0;
+
+        if (connection != nullptr)
+        {
+            auto append = [connection, &written](const char *data, size_t len) {
+                connection->outbound.append(data, len);
+                written += len;
+            };
+
+            // Stops at file ranges, which are copied from the file
+            while (client.hasOutbound())
+            {
+                written = 0;
+                OutboundFileSegment file;
+
+                if (client.frontFile(file))
+                {
+                    std::string bytes(static_cast<size_t>(file.length), '\0');
+                    long read = file.file->read(file.offset, bytes.data(), bytes.size());
+                    append(bytes.data(), static_cast<size_t>(std::max(read, 0L)));
+                }
+                else
+                {
+                    client.gatherOutbound(SIZE_MAX, INT_MAX, append);
+                }
+
+                if (written == 0)
+                {
+                    break;
+                }
+
+                client.consumeOutbound(written);
+            }
+        }
+        else
+        {
+            client.discardOutbound();
+        }
+
+        client.m_last_send_ms.store(ConnectionTimer::clock(), std::memory_order_relaxed);
+    }
+
+    void postClose(Client &client)
+    {
+        Client *closed = nullptr;
+        {
+            std::lock_guard lock(m_mtx);
+            Connection *connection = find(client);
+
+            if (connection != nullptr)
+            {
+                closed = closeConnection(*connection);
+            }
+        }
+
+        release(closed);
+    }
+
+    void releaseConnection(Client & /*client*/)
+    {
+    }
+
+    /**
+     * @brief Always empty: there are no sockets to set options on.
+     */
+    const std::vector<AppliedSocketOption> &getAppliedSocketOptions() const
+    {
+        return m_applied_socket_options;
+    }
+
+    /**
+     * @brief Always empty: the engine has no thread of its own.
+     */
+    const std::vector<PlacedThread> &getPlacedThreads() const
+    {
+        return m_placed_threads;
+    }
+
+    /**
+     * @brief Opens a connection from a peer.
+     *
+     * @return The id of the client created by the server.
+     * @throws std::runtime_error if the server refused the connection.
+     */
+    uint64_t connect(int port = 0, const std::string &ip_address = "127.0.0.1")
+    {
+        return registerConnection(m_handler.addClient(port, ip_address, INVALID_LOOPBACK_SOCKET));
+    }
+
+    /**
+     * @brief Opens a connection from a local peer, as if it had connected to
+     * the Unix domain socket of the server.
+     *
+     * @return The id of the client created by the server.
+     * @throws std::runtime_error if the server refused the connection.
+     */
+    uint64_t connectLocal(const PeerCredentials &peer)
+    {
+        return registerConnection(m_handler.addClient(0, "", INVALID_LOOPBACK_SOCKET, peer));
+    }
+
+    /**
+     * @brief Sends bytes from the peer to the server.
+     *
+     * @return false if the connection is closed.
+     */
+    bool write(uint64_t id, std::string_view data)
+    {
+        Delivery delivery;
+        {
+            std::lock_guard lock(m_mtx);
+            auto it = m_connections.find(id);
+
+            if (it == m_connections.end() || it->second.client == nullptr)
+            {
+                return false;
+            }
+
+            it->second.inbound.append(data);
+            delivery = deliver(it->second);
+        }
+
+        complete(delivery);
+        return true;
+    }
+
+    /**
+     * @brief Takes every byte the server has sent to the peer so far, including
+     * what was sent right before the server closed the connection.
+     */
+    std::string read(uint64_t id)
+    {
+        std::lock_guard lock(m_mtx);
+        auto it = m_connections.find(id);
+
+        if (it == m_connections.end())
+        {
+            return "";
+        }
+
+        return std::exchange(it->second.outbound, std::string());
+    }
+
+    /**
+     * @brief Closes the connection from the peer side. Bytes already written
+     * are still delivered before the server sees the end of the stream.
+     */
+    void close(uint64_t id)
+    {
+        Delivery delivery;
+        {
+            std::lock_guard lock(m_mtx);
+            auto it = m_connections.find(id);
+
+            if (it == m_connections.end())
+            {
+                return;
+            }
+
+            if (it->second.client == nullptr) // Already closed by the server
+            {
+                m_connections.erase(it);
+                return;
+            }
+
+            it->second.peer_closed = true;
+            delivery = deliver(it->second);
+        }
+
+        complete(delivery);
+    }
+
+    /**
+     * @brief Closes the connections timed out as of now, in
+     * ConnectionTimer::clock() milliseconds. Time never goes back, so a later
+     * now stays in effect.
+     */
+    void expireTimeouts(uint64_t now = ConnectionTimer::clock())
+    {
+        std::vector<Client *> closed;
+        {
+            std::lock_guard lock(m_mtx);
+            m_timers.update(now);
+            m_timers.expire([this, &closed](Client &client, const char *timeout) {
+                LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                       " disconnected: " + timeout + " timeout");
+                closed.push_back(closeConnection(*find(client)));
+            });
+        }
+
+        for (Client *client : closed)
+        {
+            release(client);
+        }
+    }
+
+    bool isConnected(uint64_t id) const
+    {
+        std::lock_guard lock(m_mtx);
+        auto it = m_connections.find(id);
+
+        return it != m_connections.end() && it->second.client != nullptr;
+    }
+
+  private:
+#ifdef _WIN32
+    static constexpr SOCKET_TYPE INVALID_LOOPBACK_SOCKET = INVALID_SOCKET;
+#else
+    static constexpr SOCKET_TYPE INVALID_LOOPBACK_SOCKET = -1;
+#endif
+
+    std::vector<AppliedSocketOption> m_applied_socket_options;
+
+    std::vector<PlacedThread> m_placed_threads;
+
+    /**
+     * @struct Connection
+     * @brief Both directions of an in-memory connection. The entry holds one
+     * reference to the client until it is closed, and is kept afterwards so the
+     * peer can still read what was sent.
+     */
+    struct Connection
+    {
+        Client *client = nullptr;
+        std::string inbound;
+        std::string outbound;
+        bool recv_armed = false;
+        bool peer_closed = false;
+    };
+
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    Handler &m_handler;
+
+    IoEngineConfig m_config{};
+
+    std::unordered_map<uint64_t, Connection> m_connections;
+
+    mutable std::mutex m_mtx;
+
+    /**
+     * @brief Receive buffers, only attached while peer bytes are delivered and
+     * assembled.
+     */
+    BufferPool m_buffers;
+
+    ConnectionTimer m_timers;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    /**
+     * @brief Opens the connection of a client the server just added.
+     */
+    uint64_t registerConnection(Client *client)
+    {
+        if (client == nullptr)
+        {
+            throw std::runtime_error("Loopback connection refused by the server");
+        }
+
+        std::lock_guard lock(m_mtx);
+        Connection &connection = m_connections[client->getId()];
+        connection = Connection{};
+        connection.client = client;
+        connection.recv_armed = true;
+
+        m_timers.update();
+        m_timers.add(*client);
+
+        return client->getId();
+    }
+
+    Connection *find(Client &client)
+    {
+        auto it = m_connections.find(client.getId());
+
+        if (it == m_connections.end() || it->second.client != &client)
+        {
+            return nullptr;
+        }
+
+        return &it->second;
+    }
+
+    /**
+     * @struct Delivery
+     * @brief What deliver() leaves to do once m_mtx is unlocked.
+     */
+    struct Delivery
+    {
+        Client *closed = nullptr;   ///< Client to release, as its connection was closed
+        Client *received = nullptr; ///< Client to hand off to the assembler, with a reference held
+    };
+
+    /**
+     * @brief Copies pending peer bytes into the client buffer if its receive is
+     * armed.
+     *
+     * The hand-off to the assembler happens in complete(), outside of the
+     * lock, as a run-to-completion handler sends and re-arms the receive from
+     * within it.
+     *
+     * @note Must be called with m_mtx held.
+     */
+    Delivery deliver(Connection &connection)
+    {
+        if (!connection.recv_armed)
+        {
+            return {};
+        }
+
+        Client &client = *connection.client;
+
+        // Decrypted bytes that did not fit last time are handed over first
+        if (connection.inbound.empty() && !client.hasPendingInput())
+        {
+            return {connection.peer_closed ? closeConnection(connection) : nullptr};
+        }
+
+        if (!client.hasRecvBuffer())
+        {
+            client.attachRecvBuffer(m_buffers);
+        }
+
+        // The assembler needs more room than the buffer has
+        if (client.m_recv_len == static_cast<int>(client.m_recv_capacity))
+        {
+            client.growRecvBuffer(m_buffers);
+        }
+
+        int free_space = static_cast<int>(client.m_recv_capacity) - client.m_recv_len;
+
+        if (free_space <= 0)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: receive buffer is full");
+            return {closeConnection(connection)};
+        }
+
+        int received = std::min(free_space, static_cast<int>(connection.inbound.size()));
+        std::memcpy(client.m_recv_buffer + client.m_recv_len, connection.inbound.data(), received);
+        connection.inbound.erase(0, received);
+
+        connection.recv_armed = false;
+        m_timers.update();
+        m_timers.touch(client);
+        client.addBytesReceived(received);
+        client.increaseReferenceCount();
+
+        return {nullptr, &client};
+    }
+
+    /**
+     * @note Must be called with m_mtx held. The returned client must be
+     * released once it is unlocked, as it may terminate the client.
+     */
+    Client *closeConnection(Connection &connection)
+    {
+        Client *client = connection.client;
+        client->disconnect();
+        m_timers.remove(*client);
+
+        connection.client = nullptr;
+        connection.recv_armed = false;
+        connection.inbound.clear();
+
+        return client;
+    }
+
+    void release(Client *client)
+    {
+        if (client != nullptr)
+        {
+            m_handler.releaseClient(*client);
+        }
+    }
+
+    /**
+     * @note Must be called with m_mtx unlocked.
+     */
+    void complete(const Delivery &delivery)
+    {
+        if (delivery.received != nullptr)
+        {
+            m_handler.queueAssembling(*delivery.received);
+            m_handler.releaseClient(*delivery.received);
+        }
+
+        release(delivery.closed);
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @brief What the bytes reserved against a MemoryBudget are held for.
+ */
+enum class MemoryUse : uint8_t
+{
+    RECV_BUFFERS,   ///< Receive buffers attached to clients
+    REQUEST_BODIES, ///< Bodies an assembler buffers until their request is complete
+    OUTBOUND        ///< Messages queued for writing
+};
+
+/**
+ * @struct MemoryLimits
+ * @brief How much memory the connections of a MemoryBudget may hold. 0
+ * disables a limit.
+ *
+ * Growth that can wait or be refused (larger receive buffers, request bodies,
+ * outbound messages) is only reserved up to limit. New connections are
+ * refused once accept_watermark bytes are reserved, leaving the rest to the
+ * connections already accepted.
+ */
+struct MemoryLimits
+{
+    size_t limit{MEMORY_BUDGET_BYTES};
+    size_t accept_watermark{MEMORY_ACCEPT_WATERMARK};
+};
+
+/**
+ * @struct MemoryStats
+ * @brief Bytes reserved against a MemoryBudget, per use, and what it refused.
+ */
+struct MemoryStats
+{
+    std::atomic<uint64_t> recv_buffers{0};
+    std::atomic<uint64_t> request_bodies{0};
+    std::atomic<uint64_t> outbound{0};
+    std::atomic<uint64_t> refused_connections{0};  ///< Connections closed as soon as accepted
+    std::atomic<uint64_t> refused_reservations{0}; ///< Buffers not grown, bodies rejected, messages held back
+};
+
+/**
+ * @class MemoryBudget
+ * @brief Accountant of the memory held by connections, which receive
+ * buffers, assemblers and outbound queues reserve against before growing.
+ *
+ * Every server has one, and servers of the same process can share one (see
+ * TCPServer::setMemoryBudget()), so that a burst on one of them degrades all
+ * of them before the process runs out of memory. Near the limit new
+ * connections are refused, then reservations fail and each subsystem sheds
+ * load its own way: buffers stop growing, bodies are rejected with a 503, and
+ * outbound queues apply their slow consumer policy.
+ *
+ * Reservations are a single atomic add, and never block.
+ */
+class MemoryBudget
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    MemoryBudget() = default;
+
+    explicit MemoryBudget(const MemoryLimits &limits) : m_limits(limits)
+    {
+    }
+
+    MemoryBudget(const MemoryBudget &budget) = delete;
+    MemoryBudget &operator=(const MemoryBudget &budget) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Sets the limits. Must be called before the connections using the
+     * budget are accepted.
+     */
+    void setLimits(const MemoryLimits &limits)
+    {
+        m_limits = limits;
+    }
+
+    const MemoryLimits &getLimits() const
+    {
+        return m_limits;
+    }
+
+    /**
+     * @brief Reserves bytes unless they would take the budget past its limit.
+     */
+    bool tryReserve(MemoryUse use, size_t bytes)
+    {
+        size_t used = m_used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+        if (m_limits.limit > 0 && used > m_limits.limit)
+        {
+            m_used.fetch_sub(bytes, std::memory_order_relaxed);
+            m_stats.refused_reservations.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        counter(use).fetch_add(bytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Reserves bytes a connection cannot do without, even past the
+     * limit.
+     */
+    void reserve(MemoryUse use, size_t bytes)
+    {
+        m_used.fetch_add(bytes, std::memory_order_relaxed);
+        counter(use).fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void release(MemoryUse use, size_t bytes)
+    {
+        m_used.fetch_sub(bytes, std::memory_order_relaxed);
+        counter(use).fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Whether a new connection may be accepted. Counts a refusal when
+     * it may not.
+     */
+    bool admitConnection()
+    {
+        if (m_limits.accept_watermark > 0 && m_used.load(std::memory_order_relaxed) > m_limits.accept_watermark)
+        {
+            m_stats.refused_connections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    size_t used() const
+    {
+        return m_used.load(std::memory_order_relaxed);
+    }
+
+    const MemoryStats &getStats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    MemoryLimits m_limits{};
+    MemoryStats m_stats{};
+
+    std::atomic<size_t> m_used{0};
+
+    std::atomic<uint64_t> &counter(MemoryUse use)
+    {
+        switch (use)
+        {
+        case MemoryUse::RECV_BUFFERS:
+            return m_stats.recv_buffers;
+        case MemoryUse::REQUEST_BODIES:
+            return m_stats.request_bodies;
+        default:
+            return m_stats.outbound;
+        }
+    }
+};
+
+/**
+ * @class MemoryReservation
+ * @brief Bytes held against a MemoryBudget for one use, given back when
+ * reset or destroyed.
+ *
+ * Meant for state that outlives a single call, like the body an assembler
+ * buffers for a connection. The budget must outlive the reservation.
+ */
+class MemoryReservation
+{
+  public:
+    explicit MemoryReservation(MemoryUse use) : m_use(use)
+    {
+    }
+
+    MemoryReservation(const MemoryReservation &reservation) = delete;
+    MemoryReservation &operator=(const MemoryReservation &reservation) = delete;
+
+    ~MemoryReservation()
+    {
+        reset();
+    }
+
+    /**
+     * @brief Holds bytes in total against budget, reserving or releasing the
+     * difference. Always succeeds without a budget.
+     *
+     * @return false if the budget refused to grow it, in which case the
+     * reservation keeps its size.
+     */
+    bool resize(MemoryBudget *budget, size_t bytes)
+    {
+        if (budget == nullptr)
+        {
+            return true;
+        }
+
+        if (m_budget != budget)
+        {
+            reset();
+            m_budget = budget;
+        }
+
+        if (bytes > m_bytes && !budget->tryReserve(m_use, bytes - m_bytes))
+        {
+            return false;
+        }
+
+        if (bytes < m_bytes)
+        {
+            budget->release(m_use, m_bytes - bytes);
+        }
+
+        m_bytes = bytes;
+        return true;
+    }
+
+    void reset()
+    {
+        if (m_budget != nullptr && m_bytes > 0)
+        {
+            m_budget->release(m_use, m_bytes);
+        }
+
+        m_bytes = 0;
+    }
+
+    size_t size() const
+    {
+        return m_bytes;
+    }
+
+  private:
+    MemoryUse m_use;
+    MemoryBudget *m_budget = nullptr;
+    size_t m_bytes = 0;
+};
+
+} // namespace pulse::net
@@ -3,7 +3,10 @@
 #ifdef _WIN32
 #include <winsock2.h>
 #define SOCKET_TYPE SOCKET
+#define CLOSE_SOCKET closesocket
 #else
 #include <sys/socket.h>
+#include <unistd.h>
 #define SOCKET_TYPE int
+#define CLOSE_SOCKET close
 #endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "SharedFile.h"
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @brief Immutable message body shared by every client it is sent to.
+ *
+ * The bytes are never copied per recipient: each outbound queue holds a
+ * reference, and the body is freed once the last client has written it.
+ */
+using SharedPayload = std::shared_ptr<const std::string>;
+
+/**
+ * @struct OutboundMessage
+ * @brief Message queued for a client: an optional per-client header followed
+ * by a shared payload, written to the socket with a single gather call, and
+ * optionally by a range of a file, written by the kernel from the file.
+ */
+struct OutboundMessage
+{
+    /**
+     * @brief Maximum number of segments a message is split into.
+     */
+    static constexpr int MAX_SEGMENTS = 2;
+
+    std::string header;
+    SharedPayload payload;
+    FileRange file;
+
+    /**
+     * @brief Bytes to write, file included.
+     */
+    size_t size() const
+    {
+        return bufferedSize() + static_cast<size_t>(file.length);
+    }
+
+    /**
+     * @brief Bytes held in memory, which the outbound limits and the memory
+     * budget account for. File bytes are not.
+     */
+    size_t bufferedSize() const
+    {
+        return header.size() + (payload ? payload->size() : 0);
+    }
+
+    /**
+     * @brief Calls fn(const char *data, size_t len) for every non-empty segment
+     * held in memory left after the first offset bytes, in order. The file
+     * range comes after them.
+     */
+    template <typename Fn> void forEachSegment(size_t offset, Fn &&fn) const
+    {
+        if (offset < header.size())
+        {
+            fn(header.data() + offset, header.size() - offset);
+            offset = 0;
+        }
+        else
+        {
+            offset -= header.size();
+        }
+
+        if (payload && offset < payload->size())
+        {
+            fn(payload->data() + offset, payload->size() - offset);
+        }
+    }
+};
+
+/**
+ * @struct OutboundFileSegment
+ * @brief File bytes next to write to a connection, see Client::frontFile().
+ */
+struct OutboundFileSegment
+{
+    const FileHandle *file = nullptr;
+    uint64_t offset = 0; ///< Offset in the file
+    uint64_t length = 0;
+};
+
+/**
+ * @brief What happens to a message sent to a client whose outbound queue is
+ * over its high watermark, or while every queue together is over the global
+ * one.
+ */
+enum class SlowConsumerPolicy
+{
+    DROP_NEWEST, ///< The new message is dropped
+    DROP_OLDEST, ///< Queued messages are dropped, oldest first, to make room for it
+    CONFLATE,    ///< Every queued message is dropped, only the newest one is kept
+    DISCONNECT   ///< The client is disconnected
+};
+
+/**
+ * @brief Outcome of queueing an outbound message.
+ */
+enum class SendStatus
+{
+    QUEUED,       ///< Queued, possibly in place of older messages
+    DROPPED,      ///< Dropped by the slow consumer policy
+    DISCONNECTED, ///< The client is disconnected by the slow consumer policy
+    NOT_CONNECTED ///< No such client
+};
+
+/**
+ * @struct OutboundLimits
+ * @brief High and low watermarks of the bytes queued for writing, per client
+ * and for every client together.
+ *
+ * A queue that would go over its high watermark is congested until it is
+ * written down to its low watermark. Messages sent to a congested client, or,
+ * while the global watermark is congested, to a client with more than its low
+ * watermark queued, are subject to the policy: clients keeping up are still
+ * written to. A message larger than the client high watermark is only queued
+ * once the queue of its client is empty.
+ */
+struct OutboundLimits
+{
+    size_t client_high{OUTBOUND_CLIENT_HIGH_WATERMARK};
+    size_t client_low{OUTBOUND_CLIENT_LOW_WATERMARK};
+    size_t global_high{OUTBOUND_GLOBAL_HIGH_WATERMARK};
+    size_t global_low{OUTBOUND_GLOBAL_LOW_WATERMARK};
+    SlowConsumerPolicy policy{SlowConsumerPolicy::DISCONNECT};
+};
+
+/**
+ * @struct OutboundStats
+ * @brief Bytes queued for writing and what the slow consumer policy did.
+ */
+struct OutboundStats
+{
+    std::atomic<uint64_t> queued_bytes{0};     ///< Bytes in memory queued and not written yet, by every client
+    std::atomic<uint64_t> dropped_messages{0}; ///< Messages dropped, new or queued
+    std::atomic<uint64_t> dropped_bytes{0};    ///< Unwritten bytes of the dropped messages
+    std::atomic<uint64_t> disconnects{0};      ///< Clients disconnected as slow consumers
+};
+
+/**
+ * @struct OutboundBudget
+ * @brief Outbound limits of a server and its counters, shared by its clients.
+ */
+struct OutboundBudget
+{
+    OutboundLimits limits;
+    OutboundStats stats;
+
+    /**
+     * @brief Whether the global high watermark was crossed and the queued
+     * bytes are not back to the global low watermark yet.
+     */
+    std::atomic<bool> congested{false};
+};
+
+} // namespace pulse::net
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Client.h"
+#include "OutboundMessage.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct RequestView
+ * @brief Request handed to a request handler: the assembled message and the
+ * connection it came from.
+ *
+ * Nothing is copied: the view borrows from the connection and the message, and
+ * is only valid during the call of the handler.
+ */
+template <typename MessageType> struct RequestView
+{
+    uint64_t client_id;
+    std::string_view ip_address;
+    int port;
+    MessageType &message;
+
+    /**
+     * @brief Credentials of a local client, none for TCP clients.
+     */
+    const std::optional<PeerCredentials> &peer;
+};
+
+/**
+ * @class ResponseSink
+ * @brief Queues the responses a ResponseWriter writes. Implemented by the
+ * server.
+ */
+class ResponseSink
+{
+  public:
+    virtual ~ResponseSink() = default;
+
+    /**
+     * @brief Appends a message to the outbound queue of the client. It is
+     * written once the handler has handled every request received with it.
+     *
+     * @param client The connection the request came from, or null for a
+     * datagram, answered to the address it came from.
+     */
+    virtual SendStatus queueResponse(Client *client, OutboundMessage &&message) = 0;
+};
+
+/**
+ * @class ResponseWriter
+ * @brief Writes responses to the connection a request came from, without
+ * looking the client up by id, or to the source of a datagram.
+ *
+ * Only valid during the call of the handler it is passed to.
+ */
+class ResponseWriter
+{
+  public:
+    ResponseWriter(Client &client, ResponseSink &sink) : m_client(&client), m_client_id(client.getId()), m_sink(sink)
+    {
+    }
+
+    /**
+     * @brief Writer of the responses to a datagram, which has no connection.
+     */
+    ResponseWriter(uint64_t client_id, ResponseSink &sink) : m_client(nullptr), m_client_id(client_id), m_sink(sink)
+    {
+    }
+
+    ResponseWriter(const ResponseWriter &writer) = delete;
+    ResponseWriter &operator=(const ResponseWriter &writer) = delete;
+
+    /**
+     * @brief Queues a response. The string is moved into the outbound queue,
+     * not copied.
+     */
+    SendStatus write(std::string message)
+    {
+        return m_sink.queueResponse(m_client, OutboundMessage{std::move(message), nullptr, {}});
+    }
+
+    /**
+     * @brief Queues a shared payload preceded by a header specific to this
+     * response, without copying the payload.
+     */
+    SendStatus write(SharedPayload payload, std::string header = "")
+    {
+        return m_sink.queueResponse(m_client, OutboundMessage{std::move(header), std::move(payload), {}});
+    }
+
+    /**
+     * @brief Queues a range of a file preceded by a header specific to this
+     * response, written by the kernel from the file (see TCPServer::send()).
+     * Datagrams cannot be answered with files.
+     */
+    SendStatus write(FileRange file, std::string header = "")
+    {
+        return m_sink.queueResponse(m_client, OutboundMessage{std::move(header), nullptr, std::move(file)});
+    }
+
+    uint64_t getClientId() const
+    {
+        return m_client_id;
+    }
+
+  private:
+    Client *m_client;
+    uint64_t m_client_id;
+    ResponseSink &m_sink;
+};
+
+/**
+ * @brief Requirements of a request handler: called with a RequestView and a
+ * ResponseWriter for every assembled request.
+ */
+template <typename H, typename MessageType>
+concept ValidRequestHandler = requires(H handler, RequestView<MessageType> &request, ResponseWriter &response) {
+    handler(request, response);
+};
+
+/**
+ * @struct NoRequestHandler
+ * @brief Handler of a server without one: requests are queued for next().
+ */
+struct NoRequestHandler
+{
+};
+
+} // namespace pulse::net
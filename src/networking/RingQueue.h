@@ -0,0 +1,384 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace pulse::net
+{
+
+/**
+ * @class RingQueue
+ * @brief Bounded lock-free multi-producer multi-consumer queue, storing its
+ * items inline in a ring of cells.
+ *
+ * Every cell has a sequence number telling whether it is free for the producer
+ * of a position or holds the item of that position for its consumer.
+ * Producers claim positions with a CAS on the tail and consumers with a CAS on
+ * the head, so handing an item over costs a few atomic operations and never
+ * allocates. A batch claims all of its positions with a single CAS.
+ *
+ * Blocking operations spin for a while before parking on a futex (WaitOnAddress
+ * on Windows). The other side only pays for a wake-up when a thread is parked.
+ *
+ * T must be default constructible and move assignable.
+ */
+template <typename T> class RingQueue
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+
+    /**
+     * @param capacity Number of items the queue holds, rounded up to a power
+     * of two.
+     */
+    explicit RingQueue(size_t capacity)
+        : m_capacity(std::bit_ceil(std::max<size_t>(capacity, 2))), m_mask(m_capacity - 1),
+          m_cells(std::make_unique<Cell[]>(m_capacity))
+    {
+        for (size_t i = 0; i < m_capacity; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingQueue(const RingQueue &queue) = delete;
+    RingQueue(RingQueue &&queue) = delete;
+    RingQueue &operator=(const RingQueue &queue) = delete;
+    RingQueue &operator=(RingQueue &&queue) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Moves as many of the count items into the queue as there is
+     * room for, without blocking.
+     *
+     * @return The number of items pushed, from the front of items.
+     */
+    size_t tryPushBatch(T *items, size_t count)
+    {
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        size_t claimed;
+
+        do
+        {
+            // A stale position only makes the CAS fail
+            size_t head = m_head.load(std::memory_order_acquire);
+            size_t used = position > head ? position - head : 0;
+            claimed = std::min(count, m_capacity - std::min(used, m_capacity));
+
+            if (claimed == 0)
+            {
+                return 0;
+            }
+        } while (!m_tail.compare_exchange_weak(position, position + claimed, std::memory_order_relaxed));
+
+        for (size_t i = 0; i < claimed; i++)
+        {
+            Cell &cell = m_cells[(position + i) & m_mask];
+
+            // The consumer of the previous lap may still be moving its item out
+            int spins = 0;
+            while (cell.sequence.load(std::memory_order_acquire) != position + i)
+            {
+                backoff(spins);
+            }
+
+            cell.value = std::move(items[i]);
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+
+        wake(m_not_empty);
+
+        return claimed;
+    }
+
+    /**
+     * @brief Moves up to count items out of the queue, without blocking.
+     *
+     * @return The number of items popped into the front of items.
+     */
+    size_t tryPopBatch(T *items, size_t count)
+    {
+        size_t position = m_head.load(std::memory_order_relaxed);
+        size_t claimed;
+
+        do
+        {
+            size_t tail = m_tail.load(std::memory_order_acquire);
+            claimed = tail > position ? std::min(count, tail - position) : 0;
+
+            if (claimed == 0)
+            {
+                return 0;
+            }
+        } while (!m_head.compare_exchange_weak(position, position + claimed, std::memory_order_relaxed));
+
+        for (size_t i = 0; i < claimed; i++)
+        {
+            Cell &cell = m_cells[(position + i) & m_mask];
+
+            // The producer of this position may still be moving its item in
+            int spins = 0;
+            while (cell.sequence.load(std::memory_order_acquire) != position + i + 1)
+            {
+                backoff(spins);
+            }
+
+            items[i] = std::move(cell.value);
+            cell.sequence.store(position + i + m_capacity, std::memory_order_release);
+        }
+
+        wake(m_not_full);
+
+        return claimed;
+    }
+
+    bool tryPush(T &&item)
+    {
+        return tryPushBatch(&item, 1) == 1;
+    }
+
+    bool tryPop(T &item)
+    {
+        return tryPopBatch(&item, 1) == 1;
+    }
+
+    /**
+     * @brief Moves the count items into the queue, waiting for room as long as
+     * needed.
+     *
+     * @return The number of items pushed, which is less than count only if the
+     * queue was closed meanwhile.
+     */
+    size_t pushBatch(T *items, size_t count)
+    {
+        size_t pushed = 0;
+        int spins = 0;
+
+        while (pushed < count && !m_closed.load(std::memory_order_acquire))
+        {
+            size_t last = tryPushBatch(items + pushed, count - pushed);
+            pushed += last;
+
+            if (last > 0)
+            {
+                spins = 0;
+            }
+            else if (spins < SPIN_LIMIT)
+            {
+                backoff(spins);
+            }
+            else
+            {
+                park(m_not_full, [this]() { return !full(); });
+            }
+        }
+
+        return pushed;
+    }
+
+    /**
+     * @brief Moves up to count items out of the queue, waiting until there is
+     * at least one.
+     *
+     * @return The number of items popped, 0 once the queue is closed and
+     * drained.
+     */
+    size_t popBatch(T *items, size_t count)
+    {
+        int spins = 0;
+
+        while (true)
+        {
+            size_t popped = tryPopBatch(items, count);
+
+            if (popped > 0)
+            {
+                return popped;
+            }
+
+            if (m_closed.load(std::memory_order_acquire))
+            {
+                // Items pushed right before close() are still handed out
+                return tryPopBatch(items, count);
+            }
+
+            if (spins < SPIN_LIMIT)
+            {
+                backoff(spins);
+            }
+            else
+            {
+                park(m_not_empty, [this]() { return !empty(); });
+            }
+        }
+    }
+
+    bool push(T &&item)
+    {
+        return pushBatch(&item, 1) == 1;
+    }
+
+    bool pop(T &item)
+    {
+        return popBatch(&item, 1) == 1;
+    }
+
+    /**
+     * @brief Wakes every blocked caller up. Pushes fail from now on, and pops
+     * once the queue is drained.
+     */
+    void close()
+    {
+        m_closed.store(true, std::memory_order_release);
+
+        for (Waiters *waiters : {&m_not_empty, &m_not_full})
+        {
+            waiters->epoch.fetch_add(1, std::memory_order_release);
+            waiters->epoch.notify_all();
+        }
+    }
+
+    bool isClosed() const
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Whether the queue looked empty, which may already be stale.
+     */
+    bool isEmpty() const
+    {
+        return empty();
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+  private:
+    /* ----------------
+     * Private types
+     * ----------------
+     */
+
+    /**
+     * @brief Busy-wait iterations before a blocking operation parks.
+     */
+    static constexpr int SPIN_LIMIT = 128;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    /**
+     * @struct Waiters
+     * @brief Threads parked until the queue is no longer empty or full. epoch
+     * changes on every wake-up, so a thread cannot miss one between checking
+     * the queue and parking.
+     */
+    struct alignas(64) Waiters
+    {
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<uint32_t> parked{0};
+    };
+
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // Producers and consumers each get their own cache line
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+
+    Waiters m_not_empty;
+    Waiters m_not_full;
+    std::atomic<bool> m_closed{false};
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    bool empty() const
+    {
+        return m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_relaxed);
+    }
+
+    bool full() const
+    {
+        // The head is loaded first, as it never passes the tail
+        size_t head = m_head.load(std::memory_order_relaxed);
+        return m_tail.load(std::memory_order_relaxed) - head >= m_capacity;
+    }
+
+    static void backoff(int &spins)
+    {
+        if (spins++ < SPIN_LIMIT)
+        {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Parks the calling thread until ready() holds, the queue is closed
+     * or the other side made progress.
+     */
+    template <typename Ready> void park(Waiters &waiters, Ready &&ready)
+    {
+        uint32_t epoch = waiters.epoch.load(std::memory_order_acquire);
+        waiters.parked.fetch_add(1, std::memory_order_relaxed);
+
+        // Pairs with the fence in wake(): either the other side sees this thread
+        // parked, or this thread sees its progress
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!ready() && !m_closed.load(std::memory_order_acquire))
+        {
+            waiters.epoch.wait(epoch, std::memory_order_acquire);
+        }
+
+        waiters.parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wake(Waiters &waiters)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiters.parked.load(std::memory_order_relaxed) > 0)
+        {
+            waiters.epoch.fetch_add(1, std::memory_order_release);
+            waiters.epoch.notify_all();
+        }
+    }
+};
+
+} // namespace pulse::net
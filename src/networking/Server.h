@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "OutboundMessage.h"
+
 class Server
 {
   public:
@@ -9,7 +11,7 @@ class Server
     virtual int getPort() const = 0;
 
     virtual void start() = 0;
-    virtual void send(uint64_t id, const std::string &message) = 0;
+    virtual pulse::net::SendStatus send(uint64_t id, const std::string &message) = 0;
 
     void setClientBufferLen(size_t size)
     {
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define FILE_HANDLE_TYPE HANDLE
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FILE_HANDLE_TYPE int
+#endif
+
+namespace pulse::net
+{
+
+/**
+ * @class FileHandle
+ * @brief File opened for reading, whose ranges are written to sockets by the
+ * kernel (sendfile, TransmitFile) without going through user space.
+ *
+ * Reads are positional, so one handle may be written to any number of
+ * connections at once. Closed once the last message referencing it is
+ * written or dropped.
+ */
+class FileHandle
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+
+    /**
+     * @brief Takes ownership of an open handle.
+     */
+    FileHandle(FILE_HANDLE_TYPE handle, uint64_t size) : m_handle(handle), m_size(size)
+    {
+    }
+
+    ~FileHandle()
+    {
+#ifdef _WIN32
+        CloseHandle(m_handle);
+#else
+        close(m_handle);
+#endif
+    }
+
+    FileHandle(const FileHandle &file) = delete;
+    FileHandle &operator=(const FileHandle &file) = delete;
+
+    /**
+     * @brief Opens a file for reading.
+     *
+     * @throws std::runtime_error if it cannot be opened.
+     */
+    static std::shared_ptr<const FileHandle> open(const std::string &path)
+    {
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size{};
+
+        if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size))
+        {
+            DWORD error = GetLastError();
+
+            if (handle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(handle);
+            }
+
+            throw std::runtime_error("Failed to open " + path + ": error " + std::to_string(error));
+        }
+
+        return std::make_shared<const FileHandle>(handle, static_cast<uint64_t>(size.QuadPart));
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info{};
+
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            std::string error = std::strerror(errno);
+
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+
+            throw std::runtime_error("Failed to open " + path + ": " + error);
+        }
+
+#ifdef __linux__
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        return std::make_shared<const FileHandle>(fd, static_cast<uint64_t>(info.st_size));
+#endif
+    }
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    FILE_HANDLE_TYPE native() const
+    {
+        return m_handle;
+    }
+
+    /**
+     * @brief Size of the file when it was opened.
+     */
+    uint64_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * @brief Copies up to len bytes from offset, for the connections whose
+     * bytes do not go straight to a socket (TLS encrypted in user space).
+     *
+     * @return The bytes read, 0 at the end of the file, or -1 on error.
+     */
+    long read(uint64_t offset, char *out, size_t len) const
+    {
+#ifdef _WIN32
+        OVERLAPPED position{};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+
+        if (!ReadFile(m_handle, out, static_cast<DWORD>(len), &read, &position))
+        {
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+
+        return static_cast<long>(read);
+#else
+        return static_cast<long>(pread(m_handle, out, len, static_cast<off_t>(offset)));
+#endif
+    }
+
+  private:
+    FILE_HANDLE_TYPE m_handle;
+    uint64_t m_size;
+};
+
+/**
+ * @brief File shared by every message sending a range of it.
+ */
+using SharedFile = std::shared_ptr<const FileHandle>;
+
+/**
+ * @struct FileRange
+ * @brief Bytes of a file sent as the body of a message.
+ */
+struct FileRange
+{
+    SharedFile file;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+
+    /**
+     * @brief The whole file.
+     */
+    static FileRange of(SharedFile file)
+    {
+        uint64_t size = file ? file->size() : 0;
+        return FileRange{std::move(file), 0, size};
+    }
+
+    /**
+     * @throws std::out_of_range if the range goes past the end of the file.
+     */
+    static FileRange of(SharedFile file, uint64_t offset, uint64_t length)
+    {
+        if (!file || offset > file->size() || length > file->size() - offset)
+        {
+            throw std::out_of_range("File range goes past the end of the file");
+        }
+
+        return FileRange{std::move(file), offset, length};
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NetworkPlatform.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+namespace pulse::net
+{
+
+/**
+ * @brief Named sets of socket options, tuned for a kind of traffic.
+ */
+enum class SocketProfile
+{
+    DEFAULT,   ///< Kernel defaults
+    LATENCY,   ///< Request/response traffic: nothing waits to be batched
+    THROUGHPUT ///< Bulk transfers: large buffers and full segments
+};
+
+/**
+ * @struct SocketOptions
+ * @brief Options set on the listening sockets, which accepted sockets
+ * inherit, and on every accepted socket for the ones that are not inherited.
+ * 0 and false keep the kernel default.
+ */
+struct SocketOptions
+{
+    SocketProfile profile{SocketProfile::DEFAULT}; ///< Profile the options come from, for reports
+
+    bool no_delay{false};  ///< TCP_NODELAY: small writes are not held back by Nagle's algorithm
+    bool quick_ack{false}; ///< TCP_QUICKACK on accepted sockets: ACKs are not delayed (Linux)
+    int busy_poll_us{0};   ///< SO_BUSY_POLL: how long reads poll the device queue (Linux)
+    int send_buffer{0};    ///< SO_SNDBUF, in bytes
+    int recv_buffer{0};    ///< SO_RCVBUF, in bytes
+
+    /**
+     * @brief Writes that leave bytes queued are sent with MSG_MORE, so the
+     * kernel holds partial segments until the rest follows, like TCP_CORK
+     * without its extra system calls (Linux).
+     */
+    bool cork{false};
+
+    static SocketOptions forProfile(SocketProfile profile)
+    {
+        SocketOptions options;
+        options.profile = profile;
+
+        switch (profile)
+        {
+        case SocketProfile::LATENCY:
+            options.no_delay = true;
+            options.quick_ack = true;
+            options.busy_poll_us = 50;
+            options.send_buffer = 64 * 1024;
+            break;
+
+        case SocketProfile::THROUGHPUT:
+            options.send_buffer = 4 * 1024 * 1024;
+            options.recv_buffer = 4 * 1024 * 1024;
+            options.cork = true;
+            break;
+
+        default:
+            break;
+        }
+
+        return options;
+    }
+};
+
+inline std::string_view getSocketProfileName(SocketProfile profile)
+{
+    switch (profile)
+    {
+    case SocketProfile::LATENCY:
+        return "latency";
+    case SocketProfile::THROUGHPUT:
+        return "throughput";
+    default:
+        return "default";
+    }
+}
+
+/**
+ * @brief Parses the name of a profile, as getSocketProfileName() spells it.
+ *
+ * @return false if no profile has that name.
+ */
+inline bool parseSocketProfile(std::string_view name, SocketProfile &profile)
+{
+    for (SocketProfile candidate : {SocketProfile::DEFAULT, SocketProfile::LATENCY, SocketProfile::THROUGHPUT})
+    {
+        if (name == getSocketProfileName(candidate))
+        {
+            profile = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @struct AppliedSocketOption
+ * @brief Outcome of setting one option on a listening socket.
+ */
+struct AppliedSocketOption
+{
+    std::string name;
+    int requested{0};
+    int applied{0};     ///< Value read back from the socket (the kernel may round or double it)
+    std::string status; ///< "ok", or why the option was not applied
+};
+
+/**
+ * @brief Sets the options of a listening socket and reads them back.
+ */
+inline std::vector<AppliedSocketOption> applyListenerOptions(SOCKET_TYPE sock, const SocketOptions &options)
+{
+    std::vector<AppliedSocketOption> applied;
+
+    auto apply = [&applied, sock](const char *name, int level, int option, int value) {
+        AppliedSocketOption result{name, value, 0, "ok"};
+
+        if (setsockopt(sock, level, option, reinterpret_cast<const char *>(&value), sizeof(value)) != 0)
+        {
+#ifdef _WIN32
+            result.status = "error " + std::to_string(WSAGetLastError());
+#else
+            result.status = std::strerror(errno);
+#endif
+        }
+
+        socklen_t length = sizeof(result.applied);
+        getsockopt(sock, level, option, reinterpret_cast<char *>(&result.applied), &length);
+        applied.push_back(std::move(result));
+    };
+
+    auto unsupported = [&applied](const char *name, int value) {
+        applied.push_back(AppliedSocketOption{name, value, 0, "unsupported"});
+    };
+
+    if (options.no_delay)
+    {
+        apply("TCP_NODELAY", IPPROTO_TCP, TCP_NODELAY, 1);
+    }
+
+    if (options.send_buffer > 0)
+    {
+        apply("SO_SNDBUF", SOL_SOCKET, SO_SNDBUF, options.send_buffer);
+    }
+
+    if (options.recv_buffer > 0)
+    {
+        apply("SO_RCVBUF", SOL_SOCKET, SO_RCVBUF, options.recv_buffer);
+    }
+
+#ifdef __linux__
+    if (options.busy_poll_us > 0)
+    {
+        apply("SO_BUSY_POLL", SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_us);
+    }
+
+    if (options.quick_ack)
+    {
+        applied.push_back(AppliedSocketOption{"TCP_QUICKACK", 1, 1, "ok, per connection"});
+    }
+
+    if (options.cork)
+    {
+        applied.push_back(AppliedSocketOption{"MSG_MORE", 1, 1, "ok, per write"});
+    }
+#else
+    if (options.busy_poll_us > 0)
+    {
+        unsupported("SO_BUSY_POLL", options.busy_poll_us);
+    }
+
+    if (options.quick_ack)
+    {
+        unsupported("TCP_QUICKACK", 1);
+    }
+
+    if (options.cork)
+    {
+        unsupported("MSG_MORE", 1);
+    }
+#endif
+
+    (void)unsupported;
+    return applied;
+}
+
+/**
+ * @brief Sets the options accepted sockets do not inherit from their
+ * listening socket.
+ */
+inline void applyConnectionOptions(SOCKET_TYPE sock, const SocketOptions &options)
+{
+#ifdef __linux__
+    // Only lasts until the kernel falls back to delayed ACKs, which covers
+    // the first exchanges of the connection
+    if (options.quick_ack)
+    {
+        int value = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+    }
+#else
+    (void)sock;
+    (void)options;
+#endif
+}
+
+} // namespace pulse::net
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "LoggerManager.h"
+#include "MemoryBudget.h"
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,6 +10,40 @@
 namespace pulse::net
 {
 
+/**
+ * @brief How far a connection is into its next message, which decides the
+ * timeout that applies to it (see ConnectionTimeouts).
+ */
+enum class ReadPhase : uint8_t
+{
+    IDLE,   ///< Between messages
+    HEADER, ///< Reading the head of a message
+    BODY    ///< Reading the body of a message
+};
+
+/**
+ * @class AssemblerState
+ * @brief Parsing state an assembler keeps for one connection, between the
+ * receives of that connection.
+ *
+ * Owned by the client of the connection, so parsing never looks it up in a
+ * shared structure, and it is freed with the connection.
+ */
+class AssemblerState
+{
+  public:
+    virtual ~AssemblerState() = default;
+
+    /**
+     * @brief Phase of the message being assembled. A connection reported
+     * IDLE with unconsumed bytes in its buffer is taken as reading a head.
+     */
+    virtual ReadPhase readPhase() const
+    {
+        return ReadPhase::IDLE;
+    }
+};
+
 template <typename T> class TCPMessageAssembler
 {
   public:
@@ -20,14 +56,53 @@ template <typename T> class TCPMessageAssembler
         std::string error_message;
     };
 
-    ~TCPMessageAssembler() {};
+    virtual ~TCPMessageAssembler() = default;
 
-    virtual AssemblingResult feed(uint64_t id, char *buffer, int &buffer_len, int max_buffer_len,
-                                  int last_tcp_packet_len) = 0;
+    /**
+     * @brief Called when a connection is accepted, before any of its bytes is
+     * fed.
+     *
+     * @return The parsing state of the connection, or nullptr if the assembler
+     * keeps none.
+     */
+    virtual std::unique_ptr<AssemblerState> onConnect(uint64_t /*id*/)
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief Called when a connection is closed, right before its state is
+     * destroyed.
+     */
+    virtual void onDisconnect(uint64_t /*id*/, AssemblerState * /*state*/)
+    {
+    }
+
+    /**
+     * @brief Assembles the messages completed by the last bytes received from
+     * a connection.
+     *
+     * @param state The state onConnect() returned for this connection. Never
+     * used by two feeds at once.
+     */
+    virtual AssemblingResult feed(uint64_t id, AssemblerState *state, char *buffer, int &buffer_len,
+                                  int max_buffer_len, int last_tcp_packet_len) = 0;
+
+    /**
+     * @brief Sets the budget the messages the assembler buffers between feeds
+     * are reserved against. Set by the server when it starts.
+     */
+    void setMemoryBudget(MemoryBudget *budget)
+    {
+        m_memory_budget = budget;
+    }
 
     inline void log(SEVERITY severity, std::string_view message) const
     {
         LoggerManager::get_logger()->write(severity, message);
     }
+
+  protected:
+    MemoryBudget *m_memory_budget = nullptr;
 };
 } // namespace pulse::net
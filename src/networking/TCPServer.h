@@ -11,32 +11,44 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "AddressLimiter.h"
 #include "Client.h"
+#include "ClientTable.h"
 #include "DefaultMessageAssembler.h"
+#include "IoEngine.h"
 #include "LoggerManager.h"
+#include "LoopbackEngine.h"
+#include "MemoryBudget.h"
 #include "NetworkPlatform.h"
+#include "RequestHandler.h"
+#include "RingQueue.h"
 #include "Server.h"
 #include "TCPMessageAssembler.h"
-#include "ThreadPool.h"
-#include "ThreadSafeQueue.h"
+#include "TaskScheduler.h"
 #include "constants.h"
 
-// clang-format off
-
-#include <Wsrm.h>
-
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
-#include <mswsock.h>
+#ifdef PULSENET_TLS
+#include "tls/TlsContext.h"
+#endif
 
-#pragma comment(lib, "Ws2_32.lib")
+#ifdef _WIN32
+#include "windows/IocpEngine.h"
+#else
+#include <arpa/inet.h>
 
-// clang-format on
+#ifdef PULSENET_IO_URING
+#include "unix/IoUringEngine.h"
+#else
+#include "unix/EpollEngine.h"
+#endif
+#endif
 
 namespace pulse::net
 {
@@ -53,8 +65,45 @@ concept ValidAssembler = requires {
     typename T::MessageType;
 } && std::derived_from<T, TCPMessageAssembler<typename T::MessageType>> && std::movable<typename T::MessageType>;
 
-template <ValidAssembler Assembler> class TCPServer : public Server
+/**
+ * @brief I/O engine of the platform: IOCP on Windows, and epoll (or io_uring
+ * when built with PULSENET_IO_URING) elsewhere.
+ */
+#ifdef _WIN32
+template <typename Handler> using DefaultIoEngine = IocpEngine<Handler>;
+#elif defined(PULSENET_IO_URING)
+template <typename Handler> using DefaultIoEngine = IoUringEngine<Handler>;
+#else
+template <typename Handler> using DefaultIoEngine = EpollEngine<Handler>;
+#endif
+
+/**
+ * @tparam Handler Request handler run on the I/O threads (see
+ * setRequestHandler()), or NoRequestHandler to queue requests for next().
+ */
+template <ValidAssembler Assembler, template <typename> typename Engine = DefaultIoEngine,
+          typename Handler = NoRequestHandler>
+class TCPServer : public Server, private ResponseSink
 {
+    using EngineType = Engine<TCPServer>;
+
+    static_assert(ValidIoEngine<EngineType>, "Engine does not satisfy the I/O engine requirements");
+
+    /**
+     * @brief Whether requests are handled on the I/O threads instead of being
+     * queued for next().
+     */
+    static constexpr bool RUN_TO_COMPLETION = !std::same_as<Handler, NoRequestHandler>;
+
+    static_assert(!RUN_TO_COMPLETION || ValidRequestHandler<Handler, typename Assembler::MessageType>,
+                  "Handler must be callable with a RequestView and a ResponseWriter");
+
+    friend EngineType;
+
+#ifndef _WIN32
+    // Common part of the Linux engines, which calls back into the server too
+    template <typename, typename, typename> friend class ReactorEngine;
+#endif
 
   public:
     using MessageType = typename Assembler::MessageType;
@@ -69,11 +118,27 @@ template <ValidAssembler Assembler> class TCPServer : public Server
      * Constructors
      * ----------------
      */
+    /**
+     * @param assembler_workers Workers of the scheduler of the server, only
+     * created if no scheduler is shared with it (see setScheduler()).
+     * @param max_clients Capacity of the client table: connections past it
+     * are refused. Sizes the injection queue of the server's scheduler too.
+     */
     TCPServer(int port, std::string ip_address = ANY_IP, int assembler_workers = 2,
-              std::unique_ptr<Assembler> assembler = nullptr)
-        : m_listening(false), m_assembler_thread_pool(assembler_workers, [this](int id) { this->assemblerWorker(id); }),
-          m_ip_address(ip_address), m_port(port)
+              std::unique_ptr<Assembler> assembler = nullptr, uint32_t max_clients = MAX_CLIENTS)
+        : m_ip_address(ip_address), m_port(port), m_clients(max_clients), m_assembler_workers(assembler_workers),
+          m_engine(*this)
     {
+        if (max_clients < 1)
+        {
+            throw std::invalid_argument("Max clients should be at least 1");
+        }
+
+        if (assembler_workers < 1)
+        {
+            throw std::invalid_argument("Workers should be at least 1");
+        }
+
         m_server_address.sin_family = AF_INET;
         m_server_address.sin_port = htons(m_port);
 
@@ -83,7 +148,11 @@ template <ValidAssembler Assembler> class TCPServer : public Server
         }
         else
         {
+#ifdef _WIN32
             InetPton(AF_INET, m_ip_address.c_str(), &m_server_address.sin_addr);
+#else
+            inet_pton(AF_INET, m_ip_address.c_str(), &m_server_address.sin_addr);
+#endif
         }
 
         if (!assembler)
@@ -94,11 +163,6 @@ template <ValidAssembler Assembler> class TCPServer : public Server
         {
             m_assembler = std::move(assembler);
         }
-
-        for (int i = 0; i < assembler_workers; i++)
-        {
-            m_assembling_queues.push_back(std::make_unique<ThreadSafeQueue<uint64_t>>());
-        }
     }
 
     TCPServer(const TCPServer &nm) = delete;
@@ -111,11 +175,29 @@ template <ValidAssembler Assembler> class TCPServer : public Server
      * ----------------
      */
 
+    ~TCPServer()
+    {
+        stop();
+    }
+
     /**
      *  @brief Stops de listener safely.
      */
     void stop()
     {
+        if (!m_listening.exchange(false))
+        {
+            return;
+        }
+
+        m_engine.stop();
+
+        // Wakes the tasks blocked on a full queue and the callers of next() up
+        m_requests_queue.close();
+
+        waitForTasks();
+
+        stopOwnScheduler();
     }
 
     /**
@@ -123,241 +205,234 @@ template <ValidAssembler Assembler> class TCPServer : public Server
      */
     void start()
     {
-        setupSocket();
-
         if (m_listening)
         {
             return;
         }
 
-        GUID guid = WSAID_ACCEPTEX;
-        DWORD bytes;
-        int res = WSAIoctl(m_server_socket, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), &acceptEx,
-                           sizeof(acceptEx), &bytes, NULL, NULL);
+        m_engine_config.ip_address = m_ip_address;
+        m_engine_config.port = m_port;
+        m_engine_config.address = m_server_address;
+        m_engine_config.client_buffer_len = m_client_buffer_len;
 
-        if (res == SOCKET_ERROR)
+        // Without a sizing policy, every buffer keeps the client buffer length
+        RecvBufferPolicy &policy = m_recv_buffer_sizing.policy;
+        if (policy.max_len == 0)
         {
-            throw std::runtime_error("Error getting acceptEx ptr");
+            policy.min_len = m_client_buffer_len;
+            policy.max_len = m_client_buffer_len;
         }
 
-        if (listen(m_server_socket, MAX_CONNECTION_QUEUE) == SOCKET_ERROR)
+        if constexpr (RUN_TO_COMPLETION)
         {
-            throw std::runtime_error("Error trying to listen the socket! (ip: " + m_ip_address +
-                                     ", port: " + std::to_string(m_port));
+            if (!m_request_handler)
+            {
+                throw std::logic_error("The request handler must be set before starting the server");
+            }
         }
 
-        iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+        m_assembler->setMemoryBudget(m_memory_budget);
 
-        if (iocp == NULL)
+        // In run-to-completion mode the I/O threads assemble themselves
+        if constexpr (!RUN_TO_COMPLETION)
         {
-            throw std::runtime_error("Failed to create IOCP");
+            if (m_scheduler == nullptr)
+            {
+                m_own_scheduler = std::make_unique<TaskScheduler>(m_assembler_workers, m_clients.getCapacity());
+                m_own_scheduler->setPlacement(m_worker_placement);
+                m_own_scheduler->start();
+                m_scheduler = m_own_scheduler.get();
+            }
+            else if (!m_scheduler->isRunning())
+            {
+                throw std::logic_error("A shared scheduler must be started before the server");
+            }
         }
 
-        HANDLE result = CreateIoCompletionPort(reinterpret_cast<HANDLE>(m_server_socket), iocp, 0, 0);
-
-        if (result == NULL)
+        try
+        {
+            m_engine.start(m_engine_config);
+        }
+        catch (...)
         {
-            throw std::runtime_error("Failed to associate server socket with IOCP");
+            stopOwnScheduler();
+            throw;
         }
 
-        m_accept_ctx = new AcceptContext();
-        bool success = postAcceptExEvent(*m_accept_ctx);
         m_listening = true;
-        m_pending_accepts.fetch_add(1);
 
-        if (!success)
+        for (const AppliedSocketOption &option : m_engine.getAppliedSocketOptions())
         {
-            int err = WSAGetLastError();
-
-            if (err != ERROR_IO_PENDING)
-            {
-                closeSocket();
-                throw std::runtime_error("Error executing first acceptEX" + std::to_string(WSAGetLastError()));
-            }
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Socket option " + option.name + ": requested " +
+                                                                   std::to_string(option.requested) + ", applied " +
+                                                                   std::to_string(option.applied) + " (" +
+                                                                   option.status + ")");
         }
+    }
 
-        m_listener_thread = std::thread([this]() {
-            const int MAX_ENTRIES = 64;
-
-            OVERLAPPED_ENTRY overlapped_entries[MAX_ENTRIES];
-
-            ULONG removed = 0;
+    /**
+     * @brief Queues a message for a client. The bytes are copied once into a
+     * payload of their own.
+     */
+    SendStatus send(uint64_t id, const std::string &message)
+    {
+        return send(id, std::make_shared<const std::string>(message));
+    }
 
-            while (m_listening)
-            {
+    /**
+     * @brief Queues a shared payload, preceded by an optional header specific to
+     * this client, without copying the payload.
+     *
+     * Meant for fan-out: the same payload can be sent to any number of clients,
+     * each of them only holding a reference until it is written. Header and
+     * payload are written with a single gather call, however large they are.
+     *
+     * Queues over their limits (see setOutboundLimits()) apply the slow
+     * consumer policy, whose outcome is returned.
+     */
+    SendStatus send(uint64_t id, SharedPayload payload, std::string header = "")
+    {
+        Client *client = getClient(id);
 
-                BOOL ok = GetQueuedCompletionStatusEx(iocp, overlapped_entries, MAX_ENTRIES, &removed, INFINITE, FALSE);
+        if (client)
+        {
+            SendStatus status = sendMessage(*client, OutboundMessage{std::move(header), std::move(payload), {}});
 
-                for (ULONG i = 0; i < removed; i++)
-                {
-                    OVERLAPPED_ENTRY &e = overlapped_entries[i];
-
-                    // New connection case
-                    if (&m_accept_ctx->overlapped == e.lpOverlapped)
-                    {
-                        m_pending_accepts.fetch_sub(1);
-
-                        setsockopt(m_accept_ctx->client_socket, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
-                                   (char *)&m_server_socket, sizeof(m_server_socket));
-
-                        std::pair<int, std::string> address = getRemoteAddressFromAcceptContext(*m_accept_ctx);
-
-                        Client *client = addClient(address.first, address.second, m_accept_ctx->client_socket);
-
-                        CreateIoCompletionPort(reinterpret_cast<HANDLE>(m_accept_ctx->client_socket), iocp,
-                                               reinterpret_cast<ULONG_PTR>(client), 0);
-
-                        client->increaseReferenceCount();
-                        postReceiveEvent(*client);
-                        client->decreaseReferenceCount();
-
-                        client->decreaseReferenceCount();
-
-                        if (client->isDisconnecting() && client->getReferenceCount() == 0)
-                        {
-                            terminateClient(client->getId());
-                        }
-
-                        delete m_accept_ctx;
-                        m_accept_ctx = new AcceptContext();
-
-                        // Keep listening
-                        bool success = postAcceptExEvent(*m_accept_ctx);
-                        if (success)
-                        {
-                            m_pending_accepts.fetch_add(1);
-                        }
-                    }
-                    else // Already existent connection
-                    {
-
-                        Client *client = reinterpret_cast<Client *>(e.lpCompletionKey);
-                        client->decreaseReferenceCount();
-
-                        if (client->isDisconnecting() && client->getReferenceCount() == 0)
-                        {
-                            terminateClient(client->getId());
-                        }
-                        else
-                        {
-
-                            if (e.lpOverlapped == client->getReadOverlapped()) // Read case
-                            {
-
-                                if (e.dwNumberOfBytesTransferred == 0) // Client disconnected
-                                {
-                                    client->disconnect();
-
-                                    if (client->getReferenceCount() == 0)
-                                    {
-                                        terminateClient(client->getId());
-                                    }
-                                }
-                                else
-                                {
-
-                                    client->m_recv_len += e.dwNumberOfBytesTransferred;
-                                    m_assembling_queues[client->getId() % m_assembling_queues.size()]->push(
-                                        std::make_unique<uint64_t>(client->getId()));
-                                }
-                            }
-                            else if (e.lpOverlapped == client->getSendOverlapped())
-                            {
-                                std::lock_guard lock(client->m_send_mtx);
-                                client->m_outbound_message_queue.pop();
-
-                                if (!client->m_outbound_message_queue.empty())
-                                {
-                                    client->increaseReferenceCount();
-                                    postSendEvent(*client, client->m_outbound_message_queue.front());
-                                    client->decreaseReferenceCount();
-
-                                    if (client->isDisconnecting() && client->getReferenceCount() == 0)
-                                    {
-                                        terminateClient(client->getId());
-                                    }
-                                }
-                                else
-                                {
-                                    client->m_is_sending = false;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        });
+            // Released outside of the send lock, as it may destroy the client
+            releaseClient(*client);
+            return status;
+        }
 
-        m_assembler_thread_pool.run();
+        LoggerManager::get_logger()->write(SEVERITY::INFO, "Tried to send a message to client " + std::to_string(id) +
+                                                               " but it's not connected");
+        return SendStatus::NOT_CONNECTED;
     }
 
-    void send(uint64_t id, const std::string &message)
+    /**
+     * @brief Queues a range of a file, preceded by an optional header specific
+     * to this client, without reading the file.
+     *
+     * The header is written first, then the kernel writes the range straight
+     * from the file to the socket (sendfile, or TransmitFile with IOCP), so a
+     * download holds no user space buffer whatever its size. Over TLS, the
+     * range is read and encrypted in records, unless the kernel encrypts. Only
+     * the header counts against the outbound limits and the memory budget.
+     * The file must not shrink until the range is written; if it does, the
+     * connection is closed.
+     */
+    SendStatus send(uint64_t id, FileRange file, std::string header = "")
     {
-
         Client *client = getClient(id);
 
         if (client)
         {
-            std::lock_guard lock(client->m_send_mtx);
-
-            const size_t msg_size = message.size();
-            if (msg_size <= m_client_buffer_len)
-            {
-                client->m_outbound_message_queue.emplace(message.begin(), message.end());
-            }
-            else
-            {
-                size_t offset = 0;
-                while (offset < msg_size)
-                {
-                    const size_t chunk = std::min(m_client_buffer_len, msg_size - offset);
-                    client->m_outbound_message_queue.emplace(message.begin() + offset,
-                                                             message.begin() + offset + chunk);
-                    offset += chunk;
-                }
-            }
+            SendStatus status = sendMessage(*client, OutboundMessage{std::move(header), nullptr, std::move(file)});
+            releaseClient(*client);
+            return status;
+        }
 
-            if (!client->m_is_sending)
-            {
-                client->increaseReferenceCount();
-                postSendEvent(*client, client->m_outbound_message_queue.front());
-                client->decreaseReferenceCount();
-            }
+        LoggerManager::get_logger()->write(SEVERITY::INFO, "Tried to send a file to client " + std::to_string(id) +
+                                                               " but it's not connected");
+        return SendStatus::NOT_CONNECTED;
+    }
 
-            client->decreaseReferenceCount();
+    /**
+     * @brief Whether a message sent to the client now would be subject to the
+     * slow consumer policy, because its queue or every queue together is
+     * congested. Producers can hold back until it is false again.
+     */
+    bool wouldBlock(uint64_t id)
+    {
+        Client *client = getClient(id);
 
-            if (client->isDisconnecting() && client->getReferenceCount() == 0)
-            {
-                terminateClient(client->getId());
-            }
+        if (client == nullptr)
+        {
+            return false;
         }
-        else
+
+        bool congested;
         {
-            LoggerManager::get_logger()->write(SEVERITY::INFO, "Tried to send a message to client " +
-                                                                   std::to_string(id) + " but it's not connected");
+            std::lock_guard lock(client->m_send_mtx);
+            congested = client->isOutboundCongested();
         }
+
+        releaseClient(*client);
+        return congested;
     }
 
     void showClients(std::ostream &os) const
     {
-        std::shared_lock lock(m_mtx);
-
         os << std::left << std::setfill(' ') << std::setw(10) << "Client Id" << std::setw(3) << "|" << std::setw(24)
            << " Ip Address" << std::setw(3) << "|" << std::setw(6) << "Port" << std::setw(3) << "|" << std::setw(5)
            << "Refs" << std::setw(3) << "|" << std::setw(14) << "Disconnecting\n";
         os << "--------------------------------------------------------------------"
               "-\n";
 
-        for (const auto &item : m_client_list)
+        m_clients.forEach([&os](const Client &client) { client.showInfo(os); });
+    }
+
+    /**
+     * @brief Prints the socket options of the listening sockets, as the
+     * kernel applied them.
+     */
+    void showSocketOptions(std::ostream &os) const
+    {
+        os << "Socket profile: " << getSocketProfileName(m_engine_config.socket_options.profile) << "\n";
+        os << std::left << std::setfill(' ') << std::setw(14) << "Option" << std::setw(3) << "|" << std::setw(12)
+           << "Requested" << std::setw(3) << "|" << std::setw(12) << "Applied" << std::setw(3) << "|"
+           << "Status\n";
+        os << "--------------------------------------------------------------------"
+              "-\n";
+
+        for (const AppliedSocketOption &option : m_engine.getAppliedSocketOptions())
+        {
+            os << std::left << std::setfill(' ') << std::setw(14) << option.name << std::setw(3) << "|"
+               << std::setw(12) << option.requested << std::setw(3) << "|" << std::setw(12) << option.applied
+               << std::setw(3) << "|" << option.status << "\n";
+        }
+    }
+
+    /**
+     * @brief Reports the CPU topology of the machine and where the I/O threads
+     * and the workers of the scheduler run.
+     */
+    void showTopology(std::ostream &os) const
+    {
+        CpuTopology::system().show(os);
+
+        // Until the server starts, its own scheduler is not created yet
+        const ThreadPlacement &worker_placement = m_scheduler ? m_scheduler->getPlacement() : m_worker_placement;
+
+        os << "\nI/O placement: " << getThreadPlacementName(m_engine_config.placement)
+           << ", worker placement: " << getThreadPlacementName(worker_placement) << "\n";
+        os << std::left << std::setfill(' ') << std::setw(16) << "Thread" << std::setw(3) << "|" << std::setw(16)
+           << "CPUs" << std::setw(3) << "|" << std::setw(6) << "Node" << std::setw(3) << "|" << "Status\n";
+        os << "--------------------------------------------------------------------"
+              "-\n";
+
+        showPlacedThreads(os, "I/O", m_engine.getPlacedThreads());
+        if (m_scheduler)
         {
-            if (item)
-                item->showInfo(std::cout);
+            showPlacedThreads(os, "Worker", m_scheduler->getPlacedThreads());
         }
     }
 
-    std::unique_ptr<Request> next()
+    /**
+     * @brief Waits for the next assembled request. Requests only get here
+     * without a request callback.
+     *
+     * @return The request, or nothing once the server is stopped.
+     */
+    std::optional<Request> next()
     {
-        return m_requests_queue.pop();
+        Request request;
+
+        if (!m_requests_queue.pop(request))
+        {
+            return std::nullopt;
+        }
+
+        return request;
     }
 
     std::string getIp() const
@@ -370,527 +445,1088 @@ template <ValidAssembler Assembler> class TCPServer : public Server
         return m_port;
     }
 
-  private:
-    /* ----------------
-     * Private attributes
-     * ----------------
-     */
-
     /**
-     * @struct AcceptContext
-     * @brief Context structure for Windows overlapped I/O accept operations.
+     * @brief Listens on a Unix domain socket as well, for the clients running
+     * on the same host, which then skip the TCP loopback stack. Must be
+     * called before start().
      *
-     * This structure encapsulates the necessary data for asynchronous socket
-     * acceptance on Windows platforms using I/O Completion Ports (IOCP).
+     * Its connections go through the same clients, assembler and handler as
+     * the TCP ones. They have no address and carry the credentials of their
+     * process instead (ClientDto::peer, RequestView::peer), so they are not
+     * held to the address limits. Nor are they encrypted when the server
+     * terminates TLS: the permissions of the socket file decide who may
+     * connect. A socket file left at the path by a previous run is replaced,
+     * and the file is removed on stop().
      *
-     * @note Windows-specific: Only compiled when _WIN32 is defined.
+     * @note Only supported by the Linux engines.
      */
-    struct AcceptContext
+    void setUnixSocket(const std::string &path, unsigned mode = UNIX_SOCKET_MODE)
     {
-        OVERLAPPED overlapped;
-        SOCKET client_socket;
-        char rcv_buffer[4096]; // TODO: PARAMETRIZE THIS
-    };
+        if (path.empty())
+        {
+            throw std::invalid_argument("Unix socket path cannot be empty");
+        }
+
+        m_engine_config.unix_path = path;
+        m_engine_config.unix_mode = mode;
+    }
 
     /**
-     * @brief Pointer to the accept context for Windows async operations.
-     *
-     * Maintains the state of pending accept operations when using overlapped
-     * I/O. Must be allocated/deallocated appropriately to prevent memory leaks.
-     *
-     * @note Windows-specific: Only available when _WIN32 is defined.
+     * @brief Gets the path of the Unix domain socket, empty if there is none.
      */
-    AcceptContext *m_accept_ctx = nullptr;
+    const std::string &getUnixSocket() const
+    {
+        return m_engine_config.unix_path;
+    }
 
     /**
-     * @brief Atomic counter tracking the number of pending asynchronous accept
-     * operations.
+     * @brief Sets the number of I/O reactor threads. Must be called before
+     * start().
      *
-     * Maintains a count of AcceptEx calls that have been initiated but not yet
-     * completed. This is used to ensure proper cleanup during shutdown (wait for
-     * pending operations):
+     * Each reactor owns its own epoll or io_uring instance and the connections
+     * it accepted, so accept, receive and send completions are spread across
+     * cores.
      *
-     * The counter is incremented when AcceptEx is called and decremented when:
-     * - An accept operation completes successfully
-     * - An accept operation fails
-     * - An operation is cancelled during shutdown
-     *
-     * @note Atomic to ensure thread-safety when accessed from both the listener
-     *       thread and I/O completion port worker threads.
-     *
-     * @note On Windows with IOCP, multiple AcceptEx operations may be pending
-     *       simultaneously to improve connection acceptance throughput.
+     * @note Only used by the Linux engines. The IOCP engine has a single
+     * listener thread and the loopback engine none.
      */
-    std::atomic<int> m_pending_accepts = 0;
-
-    HANDLE iocp;
-
-    LPFN_ACCEPTEX acceptEx = nullptr;
+    void setIoThreads(int threads)
+    {
+        m_engine.setIoThreads(threads);
+    }
 
     /**
-     * @brief IP address on which the server listens for incoming connections.
+     * @brief Sets the CPUs the I/O threads run on. Must be called before
+     * start().
      *
-     * Stores the network interface address (e.g., "0.0.0.0" for all interfaces,
-     * "127.0.0.1" for localhost, or a specific IP address).
+     * Reactors allocate their receive buffers from their own thread, so once
+     * placed their buffer pools stay on the NUMA node they run on.
      */
-    std::string m_ip_address;
+    void setIoPlacement(const ThreadPlacement &placement)
+    {
+        CpuTopology::system().validate(placement);
+        m_engine_config.placement = placement;
+    }
 
     /**
-     * @brief Socket address structure containing server binding information.
-     *
-     * Contains the address family (AF_INET), IP address, and port number
-     * used to bind the server socket.
+     * @brief Sets the CPUs the workers of the scheduler of the server run on.
+     * Must be called before start(). Each worker allocates its deque on its
+     * own node.
      */
-    sockaddr_in m_server_address;
+    void setWorkerPlacement(const ThreadPlacement &placement)
+    {
+        CpuTopology::system().validate(placement);
+        m_worker_placement = placement;
+    }
 
     /**
-     * @brief Port number on which the server listens for connections.
+     * @brief Assembles on a scheduler shared with other work of the process,
+     * instead of the one of the server. Must be called before start(), with
+     * the scheduler started; it must outlive the server.
      *
-     * Valid range: 1-65535 (typically > 1024 for non-privileged applications).
+     * The scheduler of the server, with the workers given to the constructor,
+     * is then never created. With an injection queue smaller than the client
+     * table, I/O threads may wait for room to submit assembling tasks.
      */
-    int m_port;
+    void setScheduler(TaskScheduler &scheduler)
+    {
+        if (scheduler.getInjectionCapacity() < m_clients.getCapacity())
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                               "The injection queue of the scheduler is smaller than the client table");
+        }
 
-    /**
-     * @brief Background thread that handles incoming connection requests.
-     *
-     * Runs the accept loop, continuously listening for and processing
-     * new client connections. Lifecycle managed by server start/stop
-     * operations.
-     */
-    std::thread m_listener_thread;
+        m_scheduler = &scheduler;
+    }
 
     /**
-     * @brief The main server socket descriptor/handle.
+     * @brief Runs callback for every assembled request, as a task of the
+     * scheduler, instead of queueing it for next(). Must be called before
+     * start().
      *
-     * Platform-specific socket type (SOCKET on Windows, int on Unix-like
-     * systems). Used for binding to the address/port and accepting incoming
-     * connections.
+     * The task goes to the deque of the worker that assembled the request, so
+     * the request is usually handled right after, on the same core, unless an
+     * idle worker steals it. Callbacks may block, only holding their worker.
+     * Requests of a client closed before their task runs are dropped.
      */
-    SOCKET_TYPE m_server_socket = NULL;
+    void setRequestCallback(std::function<void(Request)> callback)
+        requires(!RUN_TO_COMPLETION)
+    {
+        m_request_callback = std::move(callback);
+    }
 
     /**
-     * @brief Atomic counter for generating unique client identifiers.
+     * @brief Sets the length of the accept queue of the listening sockets. Must
+     * be called before start().
      *
+     * The kernel caps it (net.core.somaxconn on Linux).
      */
-    std::atomic<uint64_t> AUTOGENERATED_ID = 1;
+    void setListenBacklog(int backlog)
+    {
+        if (backlog < 1)
+        {
+            throw std::invalid_argument("Listen backlog should be at least 1");
+        }
+
+        m_engine_config.backlog = backlog;
+    }
 
     /**
-     * @brief Atomic flag indicating whether the server is actively listening.
-     *
-     * Used to control the listener thread's execution and signal shutdown.
-     * - true: Server is accepting connections
-     * - false: Server should stop accepting new connections
+     * @brief Enables sharded accept: one SO_REUSEPORT listening socket per I/O
+     * thread, each with its own accept queue, instead of a single socket
+     * shared by every thread. Must be called before start().
      *
-     * @note Atomic to allow safe checking across threads without locks.
+     * @note Only supported by the Linux engines.
      */
-    std::atomic<bool> m_listening = false;
+    void setShardedAccept(bool sharded)
+    {
+        m_engine_config.sharded_accept = sharded;
+    }
 
     /**
-     * @brief Mutex for protecting concurrent access to the client list.
-     *
-     * Synchronizes operations that modify or iterate over m_client_list,
-     * preventing race conditions when multiple threads access client data.
+     * @brief Sets how many accept operations the completion based engines keep
+     * in flight per listening socket. Must be called before start().
      */
-    mutable std::shared_mutex m_mtx;
+    void setAcceptsPerListener(int accepts)
+    {
+        if (accepts < 1 || accepts > MAX_ACCEPTS_PER_LISTENER)
+        {
+            throw std::invalid_argument("Accepts per listener should be between 1 and " +
+                                        std::to_string(MAX_ACCEPTS_PER_LISTENER));
+        }
+
+        m_engine_config.accepts_per_listener = accepts;
+    }
 
     /**
-     * @brief Map of all currently connected clients, indexed by unique ID.
-     *
-     * Stores smart pointers to Client objects, where:
-     * - Key: Unique client ID (generated from AUTOGENERATED_ID)
-     * - Value: Unique pointer to Client instance (automatic cleanup on removal)
-     *
-     * Access must be synchronized using m_mtx to ensure thread-safety.
+     * @brief Sets how much of the outbound queue of a client is coalesced into
+     * one vectored write: at most bytes bytes and segments iovec (WSABUF)
+     * entries. Must be called before start().
      *
+     * Larger batches save syscalls and completions for clients with many small
+     * pending responses; the byte limit bounds how long one client can keep an
+     * I/O thread writing.
      */
-    std::vector<std::unique_ptr<Client>> m_client_list;
-    std::vector<uint64_t> m_free_ids;
-
-    ThreadSafeQueue<Request> m_requests_queue{};
-
-    ThreadSafeQueue<uint64_t> m_assembling_queue{};
-
-    ThreadPool m_assembler_thread_pool;
-
-    std::unique_ptr<Assembler> m_assembler;
-
-    std::vector<std::unique_ptr<ThreadSafeQueue<uint64_t>>> m_assembling_queues{};
-
-    Client *addClient(int port, const std::string &ipAddress, SOCKET sock)
+    void setSendBatchLimits(size_t bytes, int segments)
     {
-        std::unique_lock lock(m_mtx);
-        uint64_t id;
-
-        if (!m_free_ids.empty())
+        if (bytes < 1)
         {
-            id = m_free_ids.back();
-            m_free_ids.pop_back();
+            throw std::invalid_argument("Send batch bytes should be at least 1");
         }
-        else
+
+        if (segments < 1 || segments > MAX_SEND_BATCH_SEGMENTS)
         {
-            id = m_client_list.size();
-            m_client_list.push_back(nullptr);
+            throw std::invalid_argument("Send batch segments should be between 1 and " +
+                                        std::to_string(MAX_SEND_BATCH_SEGMENTS));
         }
 
-        m_client_list[id] = std::make_unique<Client>(id, port, ipAddress, m_client_buffer_len, sock);
-
-        m_client_list[id]->increaseReferenceCount();
-        return m_client_list[id].get();
+        m_engine_config.send_batch_bytes = bytes;
+        m_engine_config.send_batch_segments = segments;
     }
 
-    Client *getClient(uint64_t id)
+    /**
+     * @brief Bounds the bytes queued for writing, per client and for every
+     * client together, and sets what happens to messages sent to slow
+     * consumers. Must be called before start().
+     *
+     * A queue that would go over its high watermark (or every queue, when
+     * they would together go over the global one) is congested until written
+     * down to its low watermark. Meanwhile, messages sent to it are dropped,
+     * replace older ones or disconnect the client, depending on the policy.
+     */
+    void setOutboundLimits(const OutboundLimits &limits)
     {
-        std::shared_lock lock(m_mtx);
-
-        if (id < m_client_list.size() && m_client_list[id] != nullptr)
-        {
-
-            m_client_list[id]->increaseReferenceCount();
-            return m_client_list[id].get();
-        }
-        else
+        if (limits.client_low > limits.client_high || limits.global_low > limits.global_high)
         {
-            return nullptr;
+            throw std::invalid_argument("Outbound low watermarks should not exceed their high watermarks");
         }
+
+        m_outbound_budget.limits = limits;
     }
 
-    void terminateClient(uint64_t id)
+    /**
+     * @brief Gets the bytes queued for writing and what the slow consumer
+     * policy did.
+     */
+    const OutboundStats &getOutboundStats() const
     {
-        std::lock_guard lock(m_mtx);
+        return m_outbound_budget.stats;
+    }
 
-        if (id < m_client_list.size() && m_client_list[id] != nullptr)
+    /**
+     * @brief Sets the options of the listening sockets and of the connections
+     * accepted from them, usually a profile (SocketOptions::forProfile()).
+     * Must be called before start().
+     *
+     * The options the kernel applied are logged on start() and shown by
+     * showSocketOptions().
+     */
+    void setSocketOptions(const SocketOptions &options)
+    {
+        if (options.busy_poll_us < 0 || options.send_buffer < 0 || options.recv_buffer < 0)
         {
-            closesocket(m_client_list[id]->getSocket());
-            m_client_list[id] = nullptr;
-            m_free_ids.push_back(id);
+            throw std::invalid_argument("Socket option values should not be negative");
         }
+
+        m_engine_config.socket_options = options;
     }
 
-    /*
-     * @bried Creates a request after reveiving from client
+    /**
+     * @brief Limits the connections, requests and received bytes of every
+     * source address. Must be called before start().
+     *
+     * Connections over the cap of their address, or from an address out of
+     * tokens, are refused before a client is created for them. A receive
+     * from an address whose byte bucket is empty is not parsed, and a message
+     * assembled without a request token is dropped; either way the
+     * connection is closed. The counts and buckets of every address are kept
+     * in a sharded table, see AddressLimiter.
      */
-    std::unique_ptr<Request> createRequest(Client &client, std::shared_ptr<typename Assembler::MessageType> message)
+    void setAddressLimits(const AddressLimits &limits)
     {
-        ClientDto dto;
-        std::pair<int, std::string> address = client.getAddress();
-        dto.ip_address = std::move(address.second);
-        dto.port = address.first;
-        dto.id = client.getId();
+        if ((limits.requests_per_second > 0 && limits.request_burst < 1) ||
+            (limits.bytes_per_second > 0 && limits.byte_burst < 1))
+        {
+            throw std::invalid_argument("Address rate limits need a burst of at least 1");
+        }
 
-        return std::make_unique<Request>(Request{std::move(dto), message});
+        m_address_limiter.configure(limits);
     }
 
-    /* ----------------
-     * Private methdos
-     * ----------------
+    /**
+     * @brief Gets what the address limits refused.
      */
+    const AddressLimiterStats &getAddressLimiterStats() const
+    {
+        return m_address_limiter.getStats();
+    }
 
-    void assemblerWorker(int id)
+    /**
+     * @brief Bounds the memory held by the connections of the server. Must be
+     * called before start().
+     *
+     * Receive buffers, buffered request bodies and outbound queues reserve
+     * their bytes against the memory budget of the server. Past the accept
+     * watermark, new connections are refused; past the limit, receive
+     * buffers stop growing, requests whose body does not fit are answered
+     * with an error (503 for HTTP) before it is read, and outbound queues
+     * apply their slow consumer policy.
+     */
+    void setMemoryLimits(const MemoryLimits &limits)
     {
-        while (m_listening)
+        if (limits.limit > 0 && limits.accept_watermark > limits.limit)
         {
-            std::unique_ptr<uint64_t> client_id = m_assembling_queues[id]->pop();
-            Client *client = getClient(*client_id);
-            if (client)
-            {
+            throw std::invalid_argument("Memory accept watermark should not exceed the memory limit");
+        }
 
-                typename Assembler::AssemblingResult result =
-                    m_assembler->feed(client->getId(), client->m_recv_buffer, client->m_recv_len, m_client_buffer_len,
-                                      client->getLastBytesReceived());
+        m_memory_budget->setLimits(limits);
+    }
 
-                if (result.error)
-                {
-                    send(client->getId(), result.error_message);
-                    client->disconnect();
-                }
-                else
-                {
-
-                    for (std::shared_ptr<typename Assembler::MessageType> &message : result.messages)
-                    {
-                        std::unique_ptr<Request> r = createRequest(*client, message);
-                        m_requests_queue.push(std::move(r));
-                    }
-
-                    // Then we post the next receive:
-                    client->increaseReferenceCount();
-                    postReceiveEvent(*client);
-                    client->decreaseReferenceCount();
-                }
-
-                client->decreaseReferenceCount();
+    /**
+     * @brief Makes the server reserve against a budget shared with other
+     * servers of the process, instead of its own. Must be called before
+     * start(), and the budget must outlive the server.
+     */
+    void setMemoryBudget(MemoryBudget &budget)
+    {
+        m_memory_budget = &budget;
+    }
 
-                if (client->isDisconnecting() && client->getReferenceCount() == 0)
-                {
-                    terminateClient(client->getId());
-                }
-            }
-        }
+#ifdef PULSENET_TLS
+    /**
+     * @brief Terminates TLS on every connection of the server, with a context
+     * of its own. Must be called before start().
+     *
+     * The engines move ciphertext; the assembler is fed the bytes decrypted in
+     * place of it, and queued messages are sealed into records when they are
+     * written. Clients resume their sessions with tickets, or by id from the
+     * sharded session cache of the context. Where the kernel supports it, it
+     * takes the encryption over once the handshake is done (kTLS), so that
+     * messages are written as they are queued.
+     *
+     * @throws std::runtime_error if the certificate or the key cannot be
+     * loaded.
+     */
+    void setTls(const TlsConfig &config)
+    {
+        m_own_tls_context = std::make_unique<TlsContext>(config);
+        m_tls_context = m_own_tls_context.get();
     }
 
     /**
-     * @brief Creates the network socket
+     * @brief Terminates TLS with a context shared with other servers of the
+     * process, and so their session cache and ticket keys. Must be called
+     * before start(), and the context must outlive the server.
      */
-    void setupSocket()
+    void setTlsContext(TlsContext &context)
     {
-        WSADATA wsaData;
+        m_tls_context = &context;
+    }
 
-        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    /**
+     * @brief Gets the handshakes of the TLS context, and how they went.
+     *
+     * @throws std::logic_error if TLS is not enabled.
+     */
+    const TlsStats &getTlsStats() const
+    {
+        if (m_tls_context == nullptr)
         {
-            throw std::runtime_error("WSAStartup failed!");
+            throw std::logic_error("TLS is not enabled on this server");
         }
 
-        m_server_socket = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+        return m_tls_context->getStats();
+    }
+#endif
+
+    /**
+     * @brief Gets the memory reserved by the connections, per use, and what
+     * the budget refused.
+     */
+    const MemoryStats &getMemoryStats() const
+    {
+        return m_memory_budget->getStats();
+    }
+
+    /**
+     * @brief Sets how long connections may stay without progress before they
+     * are closed. Must be called before start().
+     *
+     * Every I/O thread checks its connections with a timing wheel, whose
+     * ticks of TIMER_WHEEL_TICK_MS bound the precision. The header and write
+     * timeouts start on the assembler and sender threads, and are enforced up
+     * to the shortest enabled timeout late.
+     */
+    void setTimeouts(const ConnectionTimeouts &timeouts)
+    {
+        m_engine_config.timeouts = timeouts;
+    }
 
-        if (m_server_socket == INVALID_SOCKET)
+    /**
+     * @brief Lets client receive buffers grow and shrink with their traffic,
+     * between min_len and max_len bytes, instead of all keeping the client
+     * buffer length. Must be called before start().
+     *
+     * A full buffer is replaced right away by one twice as large, so messages
+     * up to max_len bytes are handed to the assembler whole. The size a client
+     * starts reading with is raised after grow_after reads in a row needed a
+     * larger buffer, and halved after shrink_after reads in a row used at most
+     * a quarter of it. The client buffer length is the initial size.
+     */
+    void setRecvBufferSizing(size_t min_len, size_t max_len, int grow_after = RECV_BUFFER_GROW_AFTER,
+                             int shrink_after = RECV_BUFFER_SHRINK_AFTER)
+    {
+        if (min_len < 1 || min_len > m_client_buffer_len || max_len < m_client_buffer_len)
         {
-            WSACleanup();
-            throw std::runtime_error("Error when creating socket! (ip: " + m_ip_address +
-                                     ", port: " + std::to_string(m_port));
+            throw std::invalid_argument("Receive buffer sizes should satisfy 1 <= min <= client buffer length <= max");
         }
 
-        int bindResult = bind(m_server_socket, (struct sockaddr *)&m_server_address, sizeof(m_server_address));
-        if (bindResult == SOCKET_ERROR)
+        if (grow_after < 1 || shrink_after < 1)
         {
-            closeSocket();
-            throw std::runtime_error("Binding socket failed! (ip: " + m_ip_address +
-                                     ", port: " + std::to_string(m_port) + ")");
+            throw std::invalid_argument("Receive buffer hysteresis windows should be at least 1");
         }
+
+        m_recv_buffer_sizing.policy = RecvBufferPolicy{min_len, max_len, grow_after, shrink_after};
     }
 
     /**
-     * @brief Posts an asynchronous AcceptEx operation to accept incoming client
-     * connections.
+     * @brief Sets the handler of a run-to-completion server. Must be called
+     * before start().
      *
-     * This function initiates an overlapped accept operation using the Windows
-     * AcceptEx API, which allows the server to accept incoming client
-     * connections asynchronously through the I/O Completion Port (IOCP)
-     * associated with the server socket. The AcceptEx function pointer is
-     * retrieved once using a static lambda and cached for subsequent calls to
-     * avoid repeated WSAIoctl overhead.
+     * The I/O thread that received the bytes of a connection assembles them,
+     * calls the handler with a RequestView and a ResponseWriter for every
+     * complete request, and re-arms the receive, without handing anything over
+     * to another thread. The responses written for the requests of one receive
+     * are flushed together, in one vectored write. The scheduler is not
+     * started, and next() only returns once the server is stopped.
      *
-     * @param accept_context Reference to an AcceptContext structure that will
-     * be populated with the client socket and overlapped I/O information. This
-     * context must remain valid until the accept operation completes and is
-     *                       processed by the IOCP worker thread.
+     * Only meant for handlers that never block: while one runs, every other
+     * connection of its I/O thread waits. Handlers that block should use a
+     * server without handler, where next() hands requests over to threads of
+     * their own.
+     */
+    void setRequestHandler(Handler handler)
+        requires RUN_TO_COMPLETION
+    {
+        m_request_handler.emplace(std::move(handler));
+    }
+
+    /**
+     * @brief Gets how often client receive buffers were resized.
+     */
+    const RecvBufferStats &getRecvBufferStats() const
+    {
+        return m_recv_buffer_sizing.stats;
+    }
+
+    /**
+     * @brief Gets the I/O engine of the server, e.g. to drive the peer side of
+     * a LoopbackEngine.
+     */
+    EngineType &getIoEngine()
+    {
+        return m_engine;
+    }
+
+  private:
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+
+    /**
+     * @brief IP address on which the server listens for incoming connections.
      *
-     * @return true if the AcceptEx operation was successfully posted (either
-     * completed immediately or is pending), false otherwise
+     * Stores the network interface address (e.g., "0.0.0.0" for all interfaces,
+     * "127.0.0.1" for localhost, or a specific IP address).
+     */
+    std::string m_ip_address;
+
+    /**
+     * @brief Socket address structure containing server binding information.
      *
-     * @note Prerequisites:
-     *       - m_server_socket must be initialized, valid, and associated with
-     * an IOCP
-     *       - m_accept_ctx must be allocated
-     *       - The accept_context parameter must remain valid until the
-     * operation completes
+     * Contains the address family (AF_INET), IP address, and port number
+     * used to bind the server socket.
+     */
+    sockaddr_in m_server_address;
+
+    /**
+     * @brief Port number on which the server listens for connections.
      *
-     * @note The function creates a new client socket (TCP/IPv4) and stores it
-     * in accept_context. If the operation fails, the client socket is
-     * automatically closed and set to INVALID_SOCKET.
+     * Valid range: 1-65535 (typically > 1024 for non-privileged applications).
+     */
+    int m_port;
+
+    /**
+     * @brief Atomic flag indicating whether the server is actively listening.
      *
-     * @note The AcceptEx call is configured with:
-     *       - No initial receive data (0 bytes)
-     *       - Address buffers sized at sizeof(m_server_address) + 16 bytes each
-     * for local and remote addresses (the +16 is required by AcceptEx for
-     * internal metadata)
-     *       - Overlapped I/O for asynchronous operation
+     * Used to control the listener thread's execution and signal shutdown.
+     * - true: Server is accepting connections
+     * - false: Server should stop accepting new connections
      *
-     * @note Error cases that return false:
-     *       - Server socket is NULL
-     *       - Accept context object (m_accept_ctx) is not created
-     *       - AcceptEx function pointer retrieval fails (SOCKET_ERROR)
-     *       - AcceptEx call fails with an error other than WSA_IO_PENDING
+     * @note Atomic to allow safe checking across threads without locks.
+     */
+    std::atomic<bool> m_listening = false;
+
+    /**
+     * @brief Receive buffer policy shared by every client, and its counters.
+     */
+    RecvBufferSizing m_recv_buffer_sizing{};
+
+    /**
+     * @brief Outbound limits shared by every client, and their counters.
+     */
+    OutboundBudget m_outbound_budget{};
+
+    /**
+     * @brief Memory budget of the server, unless it shares one (see
+     * setMemoryBudget()). Declared before the clients, whose assembler states
+     * may hold reservations against it until they are destroyed.
+     */
+    MemoryBudget m_own_memory_budget{};
+    MemoryBudget *m_memory_budget = &m_own_memory_budget;
+
+    /**
+     * @brief Connection counts and token buckets of the source addresses.
+     */
+    AddressLimiter m_address_limiter{};
+
+#ifdef PULSENET_TLS
+    /**
+     * @brief TLS context of the server, unless it shares one (see
+     * setTlsContext()), null without TLS. Declared before the clients, whose
+     * sessions belong to it.
+     */
+    std::unique_ptr<TlsContext> m_own_tls_context;
+    TlsContext *m_tls_context = nullptr;
+#endif
+
+    /**
+     * @brief When what the address limiter refused was last logged.
+     */
+    std::atomic<uint64_t> m_address_limits_logged_ms{0};
+
+    /**
+     * @brief Currently connected clients, indexed by client id.
      *
-     * @note On success, the completion notification will be posted to the IOCP
-     * associated with m_server_socket, where it should be handled by calling
-     * GetAcceptExSockaddrs to extract the client and server addresses.
+     * Lookups from the I/O and assembler threads never lock (see ClientTable).
+     */
+    ClientTable m_clients;
 
-     * @see MSDN documentation for AcceptEx and overlapped I/O operations
+    /**
+     * @brief Assembled requests, waiting for next().
+     */
+    RingQueue<Request> m_requests_queue{REQUEST_QUEUE_CAPACITY};
+
+    /**
+     * @brief Scheduler the server assembles on: one shared with the rest of
+     * the process (see setScheduler()), or its own one, created by start()
+     * with m_assembler_workers workers. None in run-to-completion mode.
+     */
+    std::unique_ptr<TaskScheduler> m_own_scheduler;
+    TaskScheduler *m_scheduler = nullptr;
+    int m_assembler_workers;
+    ThreadPlacement m_worker_placement;
+
+    /**
+     * @brief Tasks of the server submitted and not finished yet, waited for by
+     * stop() since they reference the server.
+     */
+    std::atomic<uint64_t> m_pending_tasks{0};
+
+    std::function<void(Request)> m_request_callback;
+
+    std::unique_ptr<Assembler> m_assembler;
+
+    /**
+     * @brief Handler of a run-to-completion server.
+     */
+    std::optional<Handler> m_request_handler;
+
+    /**
+     * @brief Listener settings passed to the I/O engine on start().
      */
+    IoEngineConfig m_engine_config{};
 
-    bool postAcceptExEvent(AcceptContext &accept_context)
+    /**
+     * @brief Platform-specific part of the server: accepts connections and
+     * moves bytes between the sockets and the client buffers.
+     */
+    EngineType m_engine;
+
+    /**
+     * @brief Creates a client for an accepted connection.
+     *
+     * @param peer Credentials of a local connection, which has no address and
+     * is neither limited nor encrypted.
+     *
+     * @return The client, holding one reference for the engine, or nullptr if
+     * the client table is full, the memory budget is past
+     * its accept watermark or the address is over its limits.
+     */
+    Client *addClient(int port, const std::string &ipAddress, SOCKET_TYPE sock,
+                      std::optional<PeerCredentials> peer = std::nullopt)
     {
+        std::string source = peer ? peer->toString() : ipAddress;
 
-        if (m_server_socket == NULL)
+        if (!m_memory_budget->admitConnection())
         {
             LoggerManager::get_logger()->write(SEVERITY::WARN,
-                                               "Tried to post an accept event to IOCP, but the server socket "
-                                               "is not set");
-            return false;
+                                               "Connection from " + source + " refused: memory budget is exhausted");
+            return nullptr;
         }
 
-        if (m_accept_ctx == nullptr)
+        uint32_t address = 0;
+
+        if (!peer && m_address_limiter.isEnabled() && AddressLimiter::parseAddress(ipAddress, address) &&
+            !m_address_limiter.acquireConnection(address, ConnectionTimer::clock()))
         {
-            LoggerManager::get_logger()->write(SEVERITY::WARN, "Tried to post an accept event to IOCP, but the accept "
-                                                               "context object "
-                                                               "is not created");
-            return false;
+            logAddressLimits();
+            return nullptr;
         }
 
-        DWORD bytes_accept = 0;
-        SOCKET client_socket = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+        std::unique_ptr<TlsSession> tls;
 
-        accept_context.client_socket = client_socket;
+#ifdef PULSENET_TLS
+        if (!peer && m_tls_context != nullptr && (tls = m_tls_context->createSession()) == nullptr)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "Connection from " + ipAddress +
+                                                                   " refused: TLS session could not be created");
 
-        ZeroMemory(&accept_context.overlapped, sizeof(accept_context.overlapped));
+            if (address != 0)
+            {
+                m_address_limiter.releaseConnection(address, ConnectionTimer::clock());
+            }
 
-        BOOL acceptEx_result =
-            acceptEx(m_server_socket, client_socket, accept_context.rcv_buffer, 0, sizeof(m_server_address) + 16,
-                     sizeof(m_server_address) + 16, &bytes_accept, &accept_context.overlapped);
+            return nullptr;
+        }
+#endif
 
-        if (!acceptEx_result && WSAGetLastError() != WSA_IO_PENDING)
+        Client *client = m_clients.add([&](uint64_t id) {
+            auto *created = new Client(id, port, ipAddress, m_client_buffer_len, sock, &m_recv_buffer_sizing,
+                                       &m_outbound_budget, m_memory_budget);
+            created->m_source_address = address;
+            created->m_peer = peer;
+            created->m_tls = std::move(tls);
+            created->m_assembler_state = m_assembler->onConnect(id);
+            created->increaseReferenceCount();
+            return created;
+        });
+
+        if (client == nullptr)
         {
-            int error_code = WSAGetLastError();
-            LoggerManager::get_logger()->write(SEVERITY::WARN, "AcceptEx failed with error code: " + error_code);
+            LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                               "Connection from " + source + " refused: client table is full");
 
-            closesocket(accept_context.client_socket);
-            accept_context.client_socket = INVALID_SOCKET;
-            return false;
+            if (address != 0)
+            {
+                m_address_limiter.releaseConnection(address, ConnectionTimer::clock());
+            }
+        }
+
+        return client;
+    }
+
+    Client *getClient(uint64_t id)
+    {
+        return m_clients.acquire(id);
+    }
+
+    /**
+     * @brief Closes the connection of a client and frees it, unless a lookup
+     * took a new reference to it meanwhile.
+     */
+    void terminateClient(uint64_t id)
+    {
+        m_clients.remove(id, [this](Client &client) {
+            m_engine.releaseConnection(client);
+            client.releaseRecvBuffer();
+
+            {
+                std::lock_guard lock(client.m_send_mtx);
+                client.discardOutbound();
+            }
+
+            m_assembler->onDisconnect(client.getId(), client.m_assembler_state.get());
+            client.m_assembler_state.reset();
+
+            if (client.m_source_address != 0)
+            {
+                m_address_limiter.releaseConnection(client.m_source_address, ConnectionTimer::clock());
+            }
+        });
+    }
+
+    /**
+     * @brief Releases one reference to the client and terminates it if it was
+     * the last one of a disconnecting client.
+     */
+    void releaseClient(Client &client)
+    {
+        if (client.decreaseReferenceCount() == 0 && client.isDisconnecting())
+        {
+            terminateClient(client.getId());
+        }
+    }
+
+    /**
+     * @brief Marks a client as disconnecting and lets its I/O backend know, so
+     * the connection is released even if no operation is pending on it.
+     */
+    void disconnectClient(Client &client)
+    {
+        client.disconnect();
+        m_engine.postClose(client);
+    }
+
+    /**
+     * @brief Hands off the bytes just received by the I/O engine to a task of
+     * the scheduler, or assembles them right away on the I/O thread in
+     * run-to-completion mode.
+     */
+    void queueAssembling(Client &client)
+    {
+        if constexpr (RUN_TO_COMPLETION)
+        {
+            std::vector<Request> requests; // Stays empty, requests are handled inline
+            assemble(client, requests);
         }
         else
         {
-            return true;
+            // A client has at most one receive waiting to be assembled, so with room for
+            // as many tasks as the client table has slots, an I/O thread never waits on the injection queue
+            uint64_t id = client.getId();
+            submitTask([this, id]() {
+                TaskGuard guard{*this};
+                assembleClient(id);
+            });
         }
     }
 
     /**
-     * @brief Extracts the remote client's IP address and port from an AcceptEx
-     * context
-     *
-     * This function parses the address information stored in the AcceptContext
-     * buffer after an AcceptEx operation completes. It uses
-     * GetAcceptExSockaddrs to retrieve both local and remote socket addresses,
-     * then extracts the client's IP and port.
-     *
-     * @param accept_context Reference to the AcceptContext containing the
-     * address buffer populated by AcceptEx
-     *
-     * @return std::pair<int, std::string> A pair containing:
-     *         - first: The client's port number (in host byte order)
-     *         - second: The client's IP address as a string (IPv4 format)
-     *
-     * @note This function assumes IPv4 addresses (AF_INET)
-     * @note The AcceptContext's rcv_buffer must have been properly initialized
-     *       and filled by a successful AcceptEx call
+     * @brief Appends a message to the outbound queue of a client, and writes
+     * it unless a write is already in progress.
      */
-    std::pair<int, std::string> getRemoteAddressFromAcceptContext(AcceptContext &accept_context)
+    SendStatus sendMessage(Client &client, OutboundMessage &&message)
     {
-        sockaddr_in remote_in{};
+        SendStatus status;
+        {
+            std::lock_guard lock(client.m_send_mtx);
+            status = client.queueOutbound(std::move(message));
 
-        int remote_size = sizeof(remote_in);
+            if (status == SendStatus::QUEUED && !client.m_is_sending && client.hasOutbound())
+            {
+                m_engine.postSend(client);
+            }
+        }
 
-        int r = getpeername(accept_context.client_socket, reinterpret_cast<sockaddr *>(&remote_in), &remote_size);
+        disconnectSlowConsumer(client, status);
+        return status;
+    }
 
-        char client_ip[INET_ADDRSTRLEN];
-        DWORD client_port;
+    /**
+     * @brief Appends a response written by the request handler, which
+     * flushResponses() writes once every request of the receive is handled.
+     */
+    SendStatus queueResponse(Client *client, OutboundMessage &&message) override
+    {
+        SendStatus status;
+        {
+            std::lock_guard lock(client->m_send_mtx);
+            status = client->queueOutbound(std::move(message));
+        }
 
-        inet_ntop(AF_INET, &(remote_in.sin_addr), client_ip, INET_ADDRSTRLEN);
-        client_port = ntohs(remote_in.sin_port);
+        disconnectSlowConsumer(*client, status);
+        return status;
+    }
+
+    void disconnectSlowConsumer(Client &client, SendStatus status)
+    {
+        if (status == SendStatus::DISCONNECTED)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: outbound queue is full");
+            disconnectClient(client);
+        }
+    }
+
+    void flushResponses(Client &client)
+    {
+        std::lock_guard lock(client.m_send_mtx);
 
-        return {client_port, client_ip};
+        if (client.hasOutbound() && !client.m_is_sending)
+        {
+            m_engine.postSend(client);
+        }
     }
 
     /**
-     * @brief Posts an asynchronous receive operation for a connected client
-     *
-     * Initiates an overlapped WSARecv operation to receive data from the client
-     * socket. The operation completes asynchronously and will be handled by the
-     * I/O completion port.
-     *
-     * @param client Reference to the Client object whose socket will receive
-     * data
+     * @brief Drops the messages the address of the client has no request
+     * token left for, closing the connection if there are any.
+     */
+    void limitRequests(Client &client, std::vector<std::shared_ptr<MessageType>> &messages)
+    {
+        uint64_t now = ConnectionTimer::clock();
+        size_t admitted = 0;
+
+        while (admitted < messages.size() && m_address_limiter.admitRequest(client.m_source_address, now))
+        {
+            admitted++;
+        }
+
+        if (admitted < messages.size())
+        {
+            messages.resize(admitted);
+            logAddressLimits();
+            disconnectClient(client);
+        }
+    }
+
+    /**
+     * @brief Logs what the address limiter refused so far, at most once per
+     * ADDRESS_LIMITER_LOG_INTERVAL_MS: refusals are driven by the peers over
+     * their limits, which must not flood the log.
+     */
+    void logAddressLimits()
+    {
+        uint64_t now = ConnectionTimer::clock();
+        uint64_t logged = m_address_limits_logged_ms.load(std::memory_order_relaxed);
+
+        if ((logged != 0 && now - logged < ADDRESS_LIMITER_LOG_INTERVAL_MS) ||
+            !m_address_limits_logged_ms.compare_exchange_strong(logged, now, std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        const AddressLimiterStats &stats = m_address_limiter.getStats();
+        LoggerManager::get_logger()->write(
+            SEVERITY::INFO, "Addresses over their limits: " + std::to_string(stats.refused_connections.load()) +
+                                " connections refused, " + std::to_string(stats.limited_requests.load()) +
+                                " requests and " + std::to_string(stats.limited_receives.load()) +
+                                " receives limited so far");
+    }
+
+    /**
+     * @brief Stamps the phase the assembler left the connection in, when it
+     * changed, for the timeouts of its I/O thread.
+     */
+    void updateReadPhase(Client &client)
+    {
+        ReadPhase phase = client.m_assembler_state ? client.m_assembler_state->readPhase() : ReadPhase::IDLE;
+
+        // Unconsumed bytes are the start of the next message, and a handshake
+        // is bound by the header timeout
+        if (phase == ReadPhase::IDLE && (client.m_recv_len > 0 || (client.m_tls && !client.m_tls->isEstablished())))
+        {
+            phase = ReadPhase::HEADER;
+        }
+
+        if (phase != client.m_read_phase.load(std::memory_order_relaxed))
+        {
+            client.m_read_phase_since.store(ConnectionTimer::clock(), std::memory_order_relaxed);
+            client.m_read_phase.store(phase, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief Replaces the ciphertext just received by the plaintext it
+     * decrypts to, and writes the records the handshake produced.
      *
-     * @return true if the receive operation was successfully posted (or is
-     * pending)
-     * @return false if WSARecv failed with an error other than WSA_IO_PENDING
+     * The ciphertext is handed to the session before being overwritten, so the
+     * plaintext may fill the whole free space of the buffer; what does not
+     * fit stays in the session, see Client::hasPendingInput().
      *
-     * @note The function returns true even when WSA_IO_PENDING is returned by
-     * WSARecv, as this indicates the operation was successfully queued
-     * @note Errors are logged to the Logger instance with NETWORK type and
-     * ERROR severity
-     * @note The client's read overlapped structure is zeroed before use
+     * @return false if the session failed, and the client is disconnecting.
+     */
+    bool decryptReceived(Client &client)
+    {
+        long plaintext;
+        {
+            std::lock_guard lock(client.m_send_mtx);
+
+            int received = client.getLastBytesReceived();
+            client.m_recv_len -= received;
+            client.m_tls->receive(client.m_recv_buffer + client.m_recv_len, static_cast<size_t>(received));
+
+            plaintext = client.m_tls->read(client.m_recv_buffer + client.m_recv_len,
+                                           client.m_recv_capacity - static_cast<size_t>(client.m_recv_len));
+            client.addBytesReceived(static_cast<int>(std::max(plaintext, 0L)));
+
+            if (plaintext >= 0 && !client.m_is_sending && client.hasOutbound())
+            {
+                m_engine.postSend(client);
+            }
+        }
+
+        if (plaintext < 0)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: TLS " + client.m_tls->getError());
+            disconnectClient(client);
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * @bried Creates a request after reveiving from client
+     */
+    Request createRequest(Client &client, std::shared_ptr<typename Assembler::MessageType> message)
+    {
+        ClientDto dto;
+        std::pair<int, std::string> address = client.getAddress();
+        dto.ip_address = std::move(address.second);
+        dto.port = address.first;
+        dto.id = client.getId();
+        dto.peer = client.m_peer;
+
+        return Request{std::move(dto), std::move(message)};
+    }
+
+    /* ----------------
+     * Private methdos
+     * ----------------
      */
-    void postReceiveEvent(Client &client)
+
+    /**
+     * @struct TaskGuard
+     * @brief Counts a task of the server as finished once it returns or
+     * throws.
+     */
+    struct TaskGuard
     {
+        TCPServer &server;
 
-        bool error = false;
+        ~TaskGuard()
+        {
+            server.finishTask();
+        }
+    };
 
-        DWORD flags = 0;
-        DWORD bytes_received = 0;
-        WSABUF wsa_buf;
-        wsa_buf.buf = client.m_recv_buffer + client.m_recv_len;
-        wsa_buf.len = m_client_buffer_len - client.m_recv_len;
+    /**
+     * @brief Submits a task of the server to its scheduler, counted until it
+     * finished. The task starts with a TaskGuard; it is not wrapped here, so
+     * small tasks stay within the inline storage of their node.
+     */
+    template <typename Task> void submitTask(Task &&task)
+    {
+        m_pending_tasks.fetch_add(1, std::memory_order_relaxed);
 
-        OVERLAPPED *read_overlapped = client.getReadOverlapped();
-        ZeroMemory(read_overlapped, sizeof(*read_overlapped));
+        // Only fails once a shared scheduler was stopped before the server
+        if (!m_scheduler->submit(std::forward<Task>(task)))
+        {
+            finishTask();
+        }
+    }
 
-        // TODO: This can end immediately if it already has data, we need to manage
-        // pushing to queue and recursive call.
-        int result = WSARecv(client.getSocket(), &wsa_buf, 1, &bytes_received, &flags, read_overlapped, NULL);
+    /**
+     * @brief Stops the scheduler of the server, if it created one. A shared
+     * scheduler is left running.
+     */
+    void stopOwnScheduler()
+    {
+        if (m_own_scheduler)
+        {
+            m_own_scheduler->stop();
+            m_own_scheduler.reset();
+            m_scheduler = nullptr;
+        }
+    }
 
-        if (result == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING)
+    void finishTask()
+    {
+        if (m_pending_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
         {
-            int error_code = WSAGetLastError();
-            LoggerManager::get_logger()->write(SEVERITY::WARN, "WSARecv failed with error code: " + error_code);
-            error = true;
+            m_pending_tasks.notify_all();
         }
+    }
 
-        else
+    void waitForTasks()
+    {
+        uint64_t pending;
+
+        while ((pending = m_pending_tasks.load(std::memory_order_acquire)) != 0)
         {
-            client.increaseReferenceCount();
+            m_pending_tasks.wait(pending);
         }
+    }
+
+    void assembleClient(uint64_t id)
+    {
+        // Scratch space of the worker, kept between tasks
+        static thread_local std::vector<Request> requests;
 
-        if (error)
+        Client *client = getClient(id);
+        if (client)
         {
-            client.disconnect();
+            assemble(*client, requests);
+            releaseClient(*client);
         }
     }
 
-    void postSendEvent(Client &client, std::vector<char> &data)
+    /**
+     * @brief Runs the request callback for a message of a client, unless the
+     * client was closed since it was assembled.
+     */
+    void handleRequest(uint64_t id, std::shared_ptr<MessageType> message)
     {
+        Client *client = getClient(id);
 
-        if (data.size() > m_client_buffer_len)
+        if (client)
         {
-            LoggerManager::get_logger()->write(SEVERITY::INFO,
-                                               "Cound not send post send event: Message is larger than max lenght.");
-            client.disconnect();
+            Request request = createRequest(*client, std::move(message));
+            releaseClient(*client);
+            m_request_callback(std::move(request));
         }
-        else
+    }
+
+    /**
+     * @brief Feeds the received bytes of a client to the assembler and hands
+     * the complete messages over to next() in one batch, or to the request
+     * handler one by one.
+     *
+     * @param requests Scratch space of the calling worker, unused in
+     * run-to-completion mode.
+     */
+    void assemble(Client &client, std::vector<Request> &requests)
+    {
+        uint32_t address = client.m_source_address;
+
+        // Bytes over the rate of their address are not worth parsing
+        if (address != 0 &&
+            !m_address_limiter.admitBytes(address, client.getLastBytesReceived(), ConnectionTimer::clock()))
         {
+            logAddressLimits();
+            disconnectClient(client);
+            return;
+        }
 
-            DWORD bytesSent = 0;
-            DWORD flags = 0;
+        if (client.m_tls && !decryptReceived(client))
+        {
+            return;
+        }
 
-            WSABUF wsa_buf;
-            wsa_buf.buf = data.data();
-            wsa_buf.len = static_cast<ULONG>(data.size());
+        // Only handshake records, or nothing left to decrypt
+        if (client.getLastBytesReceived() == 0)
+        {
+            updateReadPhase(client);
 
-            OVERLAPPED *send_overlapped = client.getSendOverlapped();
-            ZeroMemory(send_overlapped, sizeof(*send_overlapped));
+            if (client.m_recv_len == 0)
+            {
+                client.releaseRecvBuffer();
+            }
+
+            m_engine.postReceive(client);
+            return;
+        }
 
-            int result = WSASend(client.getSocket(), &wsa_buf, 1, &bytesSent, flags, send_overlapped, NULL);
+        typename Assembler::AssemblingResult result =
+            m_assembler->feed(client.getId(), client.m_assembler_state.get(), client.m_recv_buffer, client.m_recv_len,
+                              static_cast<int>(client.getRecvBufferLimit()), client.getLastBytesReceived());
 
-            if (result == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING)
+        if (result.error)
+        {
+            send(client.getId(), result.error_message);
+            disconnectClient(client);
+            return;
+        }
+
+        updateReadPhase(client);
+
+        if (address != 0)
+        {
+            limitRequests(client, result.messages);
+        }
+
+        if constexpr (RUN_TO_COMPLETION)
+        {
+            ResponseWriter response(client, *this);
+
+            for (std::shared_ptr<MessageType> &message : result.messages)
             {
-                int error_code = WSAGetLastError();
-                LoggerManager::get_logger()->write(SEVERITY::WARN, "WSARecv failed with error code: " + error_code);
-                client.disconnect();
+                RequestView<MessageType> request{client.getId(), client.getIpAddress(), client.getPort(), *message,
+                                                 client.m_peer};
+                (*m_request_handler)(request, response);
+            }
+
+            flushResponses(client);
+        }
+        else
+        {
+            if (m_request_callback)
+            {
+                // The request is created by the task, so that only the id and
+                // the message are stored in it
+                for (std::shared_ptr<MessageType> &message : result.messages)
+                {
+                    submitTask([this, id = client.getId(), message = std::move(message)]() mutable {
+                        TaskGuard guard{*this};
+                        handleRequest(id, std::move(message));
+                    });
+                }
             }
             else
             {
-                client.m_is_sending = true;
-                client.increaseReferenceCount();
+                for (std::shared_ptr<MessageType> &message : result.messages)
+                {
+                    requests.push_back(createRequest(client, std::move(message)));
+                }
+
+                m_requests_queue.pushBatch(requests.data(), requests.size());
+                requests.clear();
             }
         }
-    }
 
-    /**
-     * @brief Closes the socket
-     */
-    void closeSocket()
-    {
-        closesocket(m_server_socket);
-        WSACleanup();
+        // Every byte was consumed, so the buffer goes back to its pool until
+        // the connection is readable again
+        if (client.m_recv_len == 0)
+        {
+            client.releaseRecvBuffer();
+        }
+
+        // Then we post the next receive:
+        m_engine.postReceive(client);
     }
 };
 
@@ -0,0 +1,693 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "CpuTopology.h"
+#include "LoggerManager.h"
+#include "RingQueue.h"
+#include "WorkStealingDeque.h"
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct SchedulerStats
+ * @brief Counters of a TaskScheduler, summed over its workers.
+ */
+struct SchedulerStats
+{
+    uint64_t executed{0}; ///< Tasks run, continuations included
+    uint64_t stolen{0};   ///< Tasks taken from the deque of another worker
+    uint64_t injected{0}; ///< Tasks taken from the injection queue, submitted from outside
+    uint64_t parks{0};    ///< Times a worker found nothing to do and went to sleep
+};
+
+/**
+ * @class TaskScheduler
+ * @brief Work-stealing scheduler shared by the assembler, handler and any
+ * other work of the process.
+ *
+ * Every worker owns a WorkStealingDeque. Tasks submitted from a worker, like
+ * the continuations of its tasks, go to the bottom of its own deque and run
+ * on it depth first, while their data is still in its cache. Tasks submitted
+ * from other threads go to a shared injection queue. A worker out of tasks
+ * takes from the injection queue, then steals from the top of the deques of
+ * the others, so load spreads by itself whatever thread submitted it.
+ *
+ * A worker that finds nothing spins for a while, then parks on a futex
+ * (WaitOnAddress on Windows) until a task is submitted. Submitters only pay
+ * for a wake-up when a worker is parked.
+ *
+ * Tasks up to TASK_INLINE_BYTES are stored in their node, and nodes are
+ * recycled once run, so submitting a small task does not allocate.
+ *
+ * stop() runs every task already submitted before the workers exit, so it
+ * never leaves a task behind, nor blocks forever on a parked worker.
+ */
+class TaskScheduler
+{
+  public:
+    using Task = std::function<void()>;
+
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    /**
+     * @param injection_capacity Tasks submitted from outside the workers that
+     * can wait at once. Beyond it, submitters wait for a worker to take one.
+     */
+    explicit TaskScheduler(int workers, size_t injection_capacity = TASK_INJECTION_CAPACITY)
+        : m_worker_count(workers), m_injected(injection_capacity)
+    {
+        if (workers < 1)
+        {
+            throw std::invalid_argument("Workers should be at least 1");
+        }
+    }
+
+    TaskScheduler(const TaskScheduler &scheduler) = delete;
+    TaskScheduler(TaskScheduler &&scheduler) = delete;
+    TaskScheduler &operator=(const TaskScheduler &scheduler) = delete;
+    TaskScheduler &operator=(TaskScheduler &&scheduler) = delete;
+
+    ~TaskScheduler()
+    {
+        stop();
+
+        TaskNode *node;
+
+        while (m_free_nodes.tryPop(node))
+        {
+            delete node;
+        }
+    }
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Starts the workers, and returns once every one of them is placed
+     * and ran its init.
+     */
+    void start()
+    {
+        if (m_running)
+        {
+            return;
+        }
+
+        m_workers.clear();
+        m_placed_threads.assign(m_worker_count, PlacedThread{});
+
+        for (int i = 0; i < m_worker_count; i++)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        m_running = true;
+        m_ready = std::make_unique<std::latch>(m_worker_count + 1);
+
+        for (int i = 0; i < m_worker_count; i++)
+        {
+            m_workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+        }
+
+        m_ready->arrive_and_wait();
+    }
+
+    /**
+     * @brief Runs the tasks already submitted, then stops the workers.
+     */
+    void stop()
+    {
+        if (!m_running.exchange(false))
+        {
+            return;
+        }
+
+        // Tasks pushed by a submitter that saw the scheduler running must be run too
+        while (m_submitting.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+
+        m_epoch.fetch_add(1, std::memory_order_release);
+        m_epoch.notify_all();
+
+        for (auto &worker : m_workers)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Runs a task, any callable taking no argument, on some worker.
+     *
+     * @return false if the scheduler is not running, in which case the task
+     * is dropped. Tasks submitted by the tasks themselves are always run.
+     */
+    template <typename Fn> bool submit(Fn &&task)
+    {
+        return schedule(createNode(std::forward<Fn>(task)));
+    }
+
+    /**
+     * @brief Runs a task, then its continuation once it finished.
+     *
+     * The continuation goes to the deque of the worker that ran the task, so
+     * it usually runs right after it, on the same core.
+     */
+    bool submit(Task task, Task continuation)
+    {
+        std::vector<Task> tasks;
+        tasks.push_back(std::move(task));
+        return submitAll(std::move(tasks), std::move(continuation));
+    }
+
+    /**
+     * @brief Runs tasks on any workers, then a continuation once all of them
+     * finished.
+     */
+    bool submitAll(std::vector<Task> tasks, Task continuation)
+    {
+        TaskNode *join = createNode(std::move(continuation));
+
+        if (tasks.empty())
+        {
+            return schedule(join);
+        }
+
+        if (!accepting())
+        {
+            discard(join);
+            return false;
+        }
+
+        join->pending.store(static_cast<int>(tasks.size()), std::memory_order_relaxed);
+
+        for (Task &task : tasks)
+        {
+            push(createNode(std::move(task), join));
+        }
+
+        m_submitting.fetch_sub(1);
+        return true;
+    }
+
+    /**
+     * @brief Sets the CPUs the workers run on. Must be called before start().
+     */
+    void setPlacement(const ThreadPlacement &placement)
+    {
+        CpuTopology::system().validate(placement);
+        m_placement = placement;
+    }
+
+    const ThreadPlacement &getPlacement() const
+    {
+        return m_placement;
+    }
+
+    /**
+     * @brief Sets what every worker runs once placed, before its first task:
+     * where it allocates its own state, so it lands on its NUMA node. Must be
+     * called before start().
+     */
+    void setThreadInit(std::function<void(int)> init)
+    {
+        m_init = std::move(init);
+    }
+
+    /**
+     * @brief Where every worker runs, once started.
+     */
+    const std::vector<PlacedThread> &getPlacedThreads() const
+    {
+        return m_placed_threads;
+    }
+
+    int getWorkerCount() const
+    {
+        return m_worker_count;
+    }
+
+    size_t getInjectionCapacity() const
+    {
+        return m_injected.capacity();
+    }
+
+    bool isRunning() const
+    {
+        return m_running;
+    }
+
+    SchedulerStats getStats() const
+    {
+        SchedulerStats stats;
+
+        for (const auto &worker : m_workers)
+        {
+            stats.executed += worker->executed.load(std::memory_order_relaxed);
+            stats.stolen += worker->stolen.load(std::memory_order_relaxed);
+            stats.injected += worker->injected.load(std::memory_order_relaxed);
+            stats.parks += worker->parks.load(std::memory_order_relaxed);
+        }
+
+        return stats;
+    }
+
+    /**
+     * @brief Index of the worker running the calling thread, -1 if it is not
+     * a worker of this scheduler.
+     */
+    int currentWorker() const
+    {
+        return t_scheduler == this ? t_worker : -1;
+    }
+
+  private:
+    /**
+     * @brief Busy-wait iterations before an idle worker parks.
+     */
+    static constexpr int SPIN_LIMIT = 128;
+
+    /**
+     * @struct TaskNode
+     * @brief A submitted task, and the continuation it counts down once run.
+     *
+     * The task is stored in the node when it fits, on the heap otherwise. A
+     * continuation is a node as well, only scheduled once pending, the number
+     * of its tasks not finished yet, drops to zero.
+     */
+    struct TaskNode
+    {
+        alignas(std::max_align_t) unsigned char storage[TASK_INLINE_BYTES];
+
+        /**
+         * @brief Runs the stored task if run is set, then destroys it, even
+         * if it threw.
+         */
+        void (*finish)(TaskNode &node, bool run) = nullptr;
+
+        TaskNode *continuation = nullptr;
+        std::atomic<int> pending{0};
+
+        template <typename Fn> void emplace(Fn &&fn)
+        {
+            using Stored = std::decay_t<Fn>;
+
+            if constexpr (sizeof(Stored) <= TASK_INLINE_BYTES && alignof(Stored) <= alignof(std::max_align_t))
+            {
+                new (storage) Stored(std::forward<Fn>(fn));
+
+                finish = [](TaskNode &node, bool run) {
+                    Stored &stored = *std::launder(reinterpret_cast<Stored *>(node.storage));
+
+                    struct Destroy
+                    {
+                        Stored &stored;
+
+                        ~Destroy()
+                        {
+                            stored.~Stored();
+                        }
+                    } destroy{stored};
+
+                    if (run)
+                    {
+                        stored();
+                    }
+                };
+            }
+            else
+            {
+                new (storage) Stored *(new Stored(std::forward<Fn>(fn)));
+
+                finish = [](TaskNode &node, bool run) {
+                    std::unique_ptr<Stored> stored(*std::launder(reinterpret_cast<Stored **>(node.storage)));
+
+                    if (run)
+                    {
+                        (*stored)();
+                    }
+                };
+            }
+        }
+    };
+
+    /**
+     * @struct Worker
+     * @brief Thread, deque and counters of one worker, each worker on its own
+     * cache lines. The deque is created by the worker itself, on its node.
+     */
+    struct alignas(64) Worker
+    {
+        std::thread thread;
+        std::unique_ptr<WorkStealingDeque<TaskNode *>> deque;
+
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> injected{0};
+        std::atomic<uint64_t> parks{0};
+    };
+
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    const int m_worker_count;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    /**
+     * @brief Tasks submitted from outside the workers.
+     */
+    RingQueue<TaskNode *> m_injected;
+
+    /**
+     * @brief Nodes of the tasks already run, taken again by the next ones.
+     * Shared, as nodes are mostly submitted by I/O threads and run by the
+     * workers.
+     */
+    RingQueue<TaskNode *> m_free_nodes{TASK_FREE_NODES};
+
+    ThreadPlacement m_placement;
+
+    std::vector<PlacedThread> m_placed_threads;
+
+    std::function<void(int)> m_init;
+
+    /**
+     * @brief Workers and start() wait on it until every worker is set up.
+     * Only replaced by the next start(), as workers may still be returning
+     * from it.
+     */
+    std::unique_ptr<std::latch> m_ready;
+
+    std::atomic<bool> m_running{false};
+
+    /**
+     * @brief Threads between checking m_running and pushing their tasks,
+     * waited for by stop().
+     */
+    std::atomic<int> m_submitting{0};
+
+    /**
+     * @brief Parked workers, and the futex they wait on. The epoch changes on
+     * every wake-up, so a worker cannot miss one between looking for tasks and
+     * parking.
+     */
+    alignas(64) std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_parked{0};
+
+    static inline thread_local const TaskScheduler *t_scheduler = nullptr;
+    static inline thread_local int t_worker = -1;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    /**
+     * @brief Whether tasks may be pushed. On success, the submitter must
+     * decrement m_submitting once it pushed them.
+     */
+    bool accepting()
+    {
+        m_submitting.fetch_add(1);
+
+        if (currentWorker() < 0 && !m_running.load())
+        {
+            m_submitting.fetch_sub(1);
+            return false;
+        }
+
+        return true;
+    }
+
+    template <typename Fn> TaskNode *createNode(Fn &&task, TaskNode *continuation = nullptr)
+    {
+        TaskNode *node = nullptr;
+
+        if (!m_free_nodes.tryPop(node))
+        {
+            node = new TaskNode;
+        }
+
+        try
+        {
+            node->emplace(std::forward<Fn>(task));
+        }
+        catch (...)
+        {
+            recycle(node);
+            throw;
+        }
+
+        node->continuation = continuation;
+        node->pending.store(0, std::memory_order_relaxed);
+        return node;
+    }
+
+    void recycle(TaskNode *node)
+    {
+        if (!m_free_nodes.tryPush(std::move(node)))
+        {
+            delete node;
+        }
+    }
+
+    /**
+     * @brief Destroys the task of a node never run.
+     */
+    void discard(TaskNode *node)
+    {
+        node->finish(*node, false);
+        recycle(node);
+    }
+
+    bool schedule(TaskNode *node)
+    {
+        if (!accepting())
+        {
+            discard(node);
+            return false;
+        }
+
+        push(node);
+        m_submitting.fetch_sub(1);
+        return true;
+    }
+
+    void push(TaskNode *node)
+    {
+        int worker = currentWorker();
+
+        if (worker >= 0)
+        {
+            m_workers[worker]->deque->push(node);
+        }
+        else
+        {
+            m_injected.push(std::move(node));
+        }
+
+        wake();
+    }
+
+    void wake()
+    {
+        // Pairs with the fence in park(): either the submitter sees the worker
+        // parked, or the worker sees the task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_parked.load(std::memory_order_relaxed) > 0)
+        {
+            m_epoch.fetch_add(1, std::memory_order_release);
+            m_epoch.notify_one();
+        }
+    }
+
+    void workerLoop(int id)
+    {
+        m_placed_threads[id] = placeCurrentThread(m_placement, id);
+
+        Worker &worker = *m_workers[id];
+        worker.deque = std::make_unique<WorkStealingDeque<TaskNode *>>(TASK_DEQUE_CAPACITY);
+
+        if (m_init)
+        {
+            m_init(id);
+        }
+
+        t_scheduler = this;
+        t_worker = id;
+
+        // Every deque must exist before any worker steals
+        m_ready->arrive_and_wait();
+
+        uint32_t seed = static_cast<uint32_t>(id) * 2654435761u + 1;
+        int spins = 0;
+
+        while (true)
+        {
+            TaskNode *node = findTask(worker, id, seed);
+
+            if (node)
+            {
+                run(worker, node);
+                spins = 0;
+                continue;
+            }
+
+            // Every task was run, continuations included
+            if (!m_running.load() && !hasTask())
+            {
+                break;
+            }
+
+            if (spins++ < SPIN_LIMIT)
+            {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#else
+                std::this_thread::yield();
+#endif
+            }
+            else
+            {
+                park(worker);
+                spins = 0;
+            }
+        }
+
+        t_scheduler = nullptr;
+        t_worker = -1;
+    }
+
+    TaskNode *findTask(Worker &worker, int id, uint32_t &seed)
+    {
+        TaskNode *node = worker.deque->pop();
+
+        if (node)
+        {
+            return node;
+        }
+
+        if (m_injected.tryPop(node))
+        {
+            worker.injected.fetch_add(1, std::memory_order_relaxed);
+            return node;
+        }
+
+        // Victims are tried from a random one on, so thieves spread out
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        for (int i = 0; i < m_worker_count; i++)
+        {
+            int victim = static_cast<int>((seed + static_cast<uint32_t>(i)) % static_cast<uint32_t>(m_worker_count));
+
+            if (victim == id)
+            {
+                continue;
+            }
+
+            node = m_workers[victim]->deque->steal();
+
+            if (node)
+            {
+                worker.stolen.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool hasTask() const
+    {
+        if (!m_injected.isEmpty())
+        {
+            return true;
+        }
+
+        for (const auto &worker : m_workers)
+        {
+            if (!worker->deque->empty())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void run(Worker &worker, TaskNode *node)
+    {
+        try
+        {
+            node->finish(*node, true);
+        }
+        catch (const std::exception &ex)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::S_ERROR, std::string("Task failed: ") + ex.what());
+        }
+        catch (...)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::S_ERROR, "Task failed with an unknown exception");
+        }
+
+        worker.executed.fetch_add(1, std::memory_order_relaxed);
+
+        TaskNode *continuation = node->continuation;
+        recycle(node);
+
+        if (continuation && continuation->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            worker.deque->push(continuation);
+            wake();
+        }
+    }
+
+    void park(Worker &worker)
+    {
+        uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+        m_parked.fetch_add(1, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (!hasTask() && m_running.load())
+        {
+            worker.parks.fetch_add(1, std::memory_order_relaxed);
+            m_epoch.wait(epoch, std::memory_order_acquire);
+        }
+
+        m_parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace pulse::net
+{
+
+/**
+ * @struct TimerNode
+ * @brief Intrusive entry of a TimingWheel, embedded in the object it times.
+ */
+template <typename T> struct TimerNode
+{
+    T *owner = nullptr;
+    TimerNode *prev = nullptr;
+    TimerNode *next = nullptr;
+
+    /**
+     * @brief Tick the node fires at.
+     */
+    uint64_t expiry = 0;
+
+    /**
+     * @brief Level and slot of the list the node is linked in, level -1 while
+     * it is not scheduled.
+     */
+    int level = -1;
+    int slot = 0;
+
+    bool isScheduled() const
+    {
+        return level >= 0;
+    }
+};
+
+/**
+ * @class TimingWheel
+ * @brief Hierarchical timing wheel: LEVELS wheels of SLOTS lists each, every
+ * level SLOTS times coarser than the one below.
+ *
+ * Scheduling and cancelling unlink or link one node, whatever the number of
+ * timers. A node far in the future waits in a coarse level and cascades down
+ * once the wheel gets close to its expiry, so every node moves at most LEVELS
+ * times. Nodes are embedded in their owners, so the wheel never allocates.
+ *
+ * Time is counted in ticks, whose length is up to the caller.
+ *
+ * @note Not thread-safe.
+ */
+template <typename T> class TimingWheel
+{
+  public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    /**
+     * @brief Longest delay a node can be scheduled with. Later expiries are
+     * brought back to it.
+     */
+    static constexpr uint64_t MAX_DELAY = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit TimingWheel(uint64_t now = 0) : m_current(now)
+    {
+    }
+
+    TimingWheel(const TimingWheel &wheel) = delete;
+    TimingWheel &operator=(const TimingWheel &wheel) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Schedules node to fire at the given tick, or at the next one if
+     * it is already due. A scheduled node is moved.
+     */
+    void schedule(TimerNode<T> &node, uint64_t expiry)
+    {
+        cancel(node);
+        link(node, std::clamp(expiry, m_current + 1, m_current + MAX_DELAY));
+        m_size++;
+    }
+
+    void cancel(TimerNode<T> &node)
+    {
+        if (node.isScheduled())
+        {
+            unlink(node);
+            m_size--;
+        }
+    }
+
+    /**
+     * @brief Moves the wheel to tick now, calling fire(T &) for every node due
+     * meanwhile. The node is no longer scheduled when fire is called, which
+     * may schedule it again.
+     */
+    template <typename Fire> void advance(uint64_t now, Fire &&fire)
+    {
+        while (m_current < now)
+        {
+            // Nothing to fire or cascade on the way
+            if (m_size == 0)
+            {
+                m_current = now;
+                return;
+            }
+
+            m_current++;
+
+            // Higher levels first, so nodes cascading twice reach level 0
+            for (int level = LEVELS - 1; level > 0; level--)
+            {
+                if ((m_current & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0)
+                {
+                    cascade(level, slotOf(m_current, level));
+                }
+            }
+
+            TimerNode<T> *&head = m_slots[0][slotOf(m_current, 0)];
+
+            while (head != nullptr)
+            {
+                TimerNode<T> &node = *head;
+                cancel(node);
+                fire(*node.owner);
+            }
+        }
+    }
+
+    /**
+     * @brief Ticks until the wheel has something to fire or to cascade, 0 if
+     * nothing is scheduled.
+     */
+    uint64_t ticksUntilNext() const
+    {
+        if (m_size == 0)
+        {
+            return 0;
+        }
+
+        uint64_t next = MAX_DELAY;
+
+        // Slots of level 0 ahead of the current one, starting with the next one
+        int offset = static_cast<int>((m_current + 1) & (SLOTS - 1));
+        if (m_occupied[0] != 0)
+        {
+            next = std::countr_zero(std::rotr(m_occupied[0], offset)) + 1;
+        }
+
+        for (int level = 1; level < LEVELS; level++)
+        {
+            if (m_occupied[level] != 0)
+            {
+                next = std::min(next, SLOTS - (m_current & (SLOTS - 1)));
+                break;
+            }
+        }
+
+        return next;
+    }
+
+    uint64_t now() const
+    {
+        return m_current;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+  private:
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    uint64_t m_current;
+    size_t m_size = 0;
+
+    TimerNode<T> *m_slots[LEVELS][SLOTS] = {};
+
+    /**
+     * @brief Non-empty slots of every level, one bit per slot.
+     */
+    uint64_t m_occupied[LEVELS] = {};
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+    static int slotOf(uint64_t tick, int level)
+    {
+        return static_cast<int>((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+
+    /**
+     * @brief Links node in the level its distance to the current tick falls
+     * in, at the slot of its expiry in that level.
+     */
+    void link(TimerNode<T> &node, uint64_t expiry)
+    {
+        uint64_t delay = expiry - m_current;
+        int level = 0;
+
+        while (level < LEVELS - 1 && delay >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+
+        int slot = slotOf(expiry, level);
+        TimerNode<T> *&head = m_slots[level][slot];
+
+        node.expiry = expiry;
+        node.level = level;
+        node.slot = slot;
+        node.prev = nullptr;
+        node.next = head;
+
+        if (head != nullptr)
+        {
+            head->prev = &node;
+        }
+
+        head = &node;
+        m_occupied[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(TimerNode<T> &node)
+    {
+        TimerNode<T> *&head = m_slots[node.level][node.slot];
+
+        if (node.prev != nullptr)
+        {
+            node.prev->next = node.next;
+        }
+        else
+        {
+            head = node.next;
+        }
+
+        if (node.next != nullptr)
+        {
+            node.next->prev = node.prev;
+        }
+
+        if (head == nullptr)
+        {
+            m_occupied[node.level] &= ~(uint64_t(1) << node.slot);
+        }
+
+        node.prev = nullptr;
+        node.next = nullptr;
+        node.level = -1;
+    }
+
+    /**
+     * @brief Moves the nodes of a slot down to the levels their remaining
+     * delay falls in.
+     */
+    void cascade(int level, int slot)
+    {
+        TimerNode<T> *&head = m_slots[level][slot];
+
+        while (head != nullptr)
+        {
+            TimerNode<T> &node = *head;
+            unlink(node);
+            link(node, std::max(node.expiry, m_current));
+        }
+    }
+};
+
+} // namespace pulse::net
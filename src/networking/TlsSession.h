@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#include "NetworkPlatform.h"
+#include "constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @class TlsSession
+ * @brief TLS record layer of one connection, between the bytes the engine
+ * moves and the ones the assembler and the outbound queue see.
+ *
+ * Ciphertext received is decrypted in place of itself in the receive buffer,
+ * and messages of the outbound queue are sealed into records right before
+ * they are written, so the slow consumer policies still apply to whole
+ * messages. Once the kernel encrypts for the connection (kTLS, see
+ * offload()), the outbound queue is written as it is.
+ *
+ * Owned by the client of the connection, created by the TlsContext of the
+ * server when it is accepted. Every call is made with Client::m_send_mtx
+ * held, which serializes the receiving and the sending side of the session.
+ */
+class TlsSession
+{
+  public:
+    TlsSession() = default;
+    virtual ~TlsSession() = default;
+
+    TlsSession(const TlsSession &session) = delete;
+    TlsSession &operator=(const TlsSession &session) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Takes ciphertext received from the peer.
+     */
+    virtual void receive(const char *data, size_t len) = 0;
+
+    /**
+     * @brief Decrypts up to len bytes into out, going through the handshake
+     * first. Records the handshake writes are added to the output.
+     *
+     * @return The bytes decrypted, or -1 if the session failed.
+     */
+    virtual long read(char *out, size_t len) = 0;
+
+    /**
+     * @brief Whether the last read() filled its output while more could be
+     * decrypted, so the connection has bytes to assemble before the socket
+     * has any.
+     */
+    virtual bool hasBufferedInput() const = 0;
+
+    /**
+     * @brief Whether the handshake is done, and plaintext may be sealed.
+     */
+    virtual bool isEstablished() const = 0;
+
+    /**
+     * @brief Encrypts plaintext into the output, in records as full as
+     * possible. Only called once established.
+     */
+    virtual void seal(const char *data, size_t len) = 0;
+
+    /**
+     * @brief Encrypts what seal() holds back for a fuller record.
+     */
+    virtual void closeRecord() = 0;
+
+    /**
+     * @brief Hands the encryption of what is written from now on to the
+     * kernel, if it can and it was not tried yet. Only called once every
+     * record of the output was written.
+     *
+     * @return Whether the kernel encrypts for the connection.
+     */
+    virtual bool offload(SOCKET_TYPE sock) = 0;
+
+    virtual bool isOffloaded() const = 0;
+
+    /**
+     * @brief Why the session failed, once read() returned -1.
+     */
+    virtual std::string getError() const = 0;
+
+    /**
+     * @brief Calls fn(const char *data, size_t len) for the records waiting
+     * to be written, in order, until max_bytes or max_segments is reached.
+     *
+     * @return The number of segments gathered.
+     */
+    template <typename Fn> int gatherOutput(size_t max_bytes, int max_segments, Fn &&fn) const
+    {
+        size_t bytes = 0;
+        int segments = 0;
+        size_t offset = m_output_offset;
+
+        for (const std::string &chunk : m_output)
+        {
+            if (segments == max_segments || bytes == max_bytes)
+            {
+                break;
+            }
+
+            size_t len = std::min(chunk.size() - offset, max_bytes - bytes);
+            fn(chunk.data() + offset, len);
+            bytes += len;
+            segments++;
+            offset = 0;
+        }
+
+        return segments;
+    }
+
+    /**
+     * @brief Drops the first bytes of the output once they have been written.
+     */
+    void consumeOutput(size_t bytes)
+    {
+        m_output_bytes -= bytes;
+
+        while (bytes > 0)
+        {
+            size_t left = m_output.front().size() - m_output_offset;
+
+            if (bytes < left)
+            {
+                m_output_offset += bytes;
+                break;
+            }
+
+            bytes -= left;
+            m_output.pop_front();
+            m_output_offset = 0;
+        }
+    }
+
+    /**
+     * @brief Bytes of records waiting to be written.
+     */
+    size_t outputSize() const
+    {
+        return m_output_bytes;
+    }
+
+  protected:
+    /**
+     * @brief Appends records to the output.
+     *
+     * Bytes already in the output never move, as a write in flight (IOCP) may
+     * still point to them: the last chunk is only appended to within its
+     * capacity.
+     */
+    void appendOutput(const char *data, size_t len)
+    {
+        if (m_output.empty() || m_output.back().capacity() - m_output.back().size() < len)
+        {
+            m_output.emplace_back().reserve(std::max(len, TLS_OUTPUT_CHUNK_BYTES));
+        }
+
+        m_output.back().append(data, len);
+        m_output_bytes += len;
+    }
+
+  private:
+    std::deque<std::string> m_output;
+
+    /**
+     * @brief Bytes of the first chunk already written.
+     */
+    size_t m_output_offset = 0;
+
+    size_t m_output_bytes = 0;
+};
+
+} // namespace pulse::net
@@ -0,0 +1,856 @@
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#define NOMINMAX
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Client.h"
+#include "DatagramDecoder.h"
+#include "LoggerManager.h"
+#include "NetworkPlatform.h"
+#include "RequestHandler.h"
+#include "RingQueue.h"
+#include "Server.h"
+#include "constants.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/uio.h>
+#endif
+
+namespace pulse::net
+{
+
+template <typename T>
+concept ValidDecoder = requires {
+    typename T::MessageType;
+} && std::derived_from<T, DatagramDecoder<typename T::MessageType>> && std::movable<typename T::MessageType>;
+
+/**
+ * @struct UdpStats
+ * @brief Datagrams a UdpServer received and sent, and what became of them.
+ */
+struct UdpStats
+{
+    std::atomic<uint64_t> datagrams{0};        ///< Datagrams received, coalesced ones counted one by one
+    std::atomic<uint64_t> batches{0};          ///< Receive calls that returned datagrams
+    std::atomic<uint64_t> messages{0};         ///< Messages decoded
+    std::atomic<uint64_t> malformed{0};        ///< Datagrams the decoder rejected
+    std::atomic<uint64_t> truncated{0};        ///< Datagrams larger than the buffer, dropped
+    std::atomic<uint64_t> dropped_requests{0}; ///< Messages dropped as the request queue was full
+    std::atomic<uint64_t> sent{0};             ///< Datagrams sent
+    std::atomic<uint64_t> send_failures{0};    ///< Datagrams the kernel refused to send
+};
+
+/**
+ * @class UdpServer
+ * @brief Receives datagrams, for fire-and-forget events that need no
+ * connection, and hands the messages decoded from them over to next() or to a
+ * request handler, like TCPServer.
+ *
+ * Every I/O thread receives from a socket of its own, bound to the same
+ * address with SO_REUSEPORT, so the kernel spreads the sources across
+ * threads. A thread receives up to the batch size of datagrams per recvmmsg
+ * call, and, where the kernel supports it, with UDP GRO, which coalesces
+ * consecutive datagrams of a source into one buffer. Datagrams are decoded on
+ * the thread that received them and handed over in one batch per call.
+ *
+ * Datagrams have no connection: the client id of a request is the address and
+ * port of its source, so that send() answers it, and the same source always
+ * has the same id. Responses written by a request handler are sent together
+ * once the whole batch is handled, with sendmmsg.
+ *
+ * @note recvmmsg, sendmmsg and GRO are Linux only. Elsewhere datagrams are
+ * received and sent one per call.
+ *
+ * @tparam Handler Request handler run on the I/O threads (see
+ * setRequestHandler()), or NoRequestHandler to queue requests for next().
+ */
+template <ValidDecoder Decoder, typename Handler = NoRequestHandler> class UdpServer : public Server
+{
+    static constexpr bool RUN_TO_COMPLETION = !std::same_as<Handler, NoRequestHandler>;
+
+    static_assert(!RUN_TO_COMPLETION || ValidRequestHandler<Handler, typename Decoder::MessageType>,
+                  "Handler must be callable with a RequestView and a ResponseWriter");
+
+  public:
+    using MessageType = typename Decoder::MessageType;
+
+    struct Request
+    {
+        ClientDto client;
+        std::shared_ptr<MessageType> message;
+    };
+
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    UdpServer(int port, std::string ip_address = ANY_IP, std::unique_ptr<Decoder> decoder = nullptr)
+        : m_ip_address(ip_address), m_port(port)
+    {
+        m_server_address.sin_family = AF_INET;
+        m_server_address.sin_port = htons(static_cast<uint16_t>(m_port));
+
+        if (m_ip_address == ANY_IP)
+        {
+            m_server_address.sin_addr.s_addr = INADDR_ANY;
+        }
+        else
+        {
+#ifdef _WIN32
+            InetPton(AF_INET, m_ip_address.c_str(), &m_server_address.sin_addr);
+#else
+            inet_pton(AF_INET, m_ip_address.c_str(), &m_server_address.sin_addr);
+#endif
+        }
+
+        if (!decoder)
+        {
+            throw std::invalid_argument("Decoder cannot be null");
+        }
+
+        m_decoder = std::move(decoder);
+    }
+
+    UdpServer(const UdpServer &server) = delete;
+    UdpServer &operator=(const UdpServer &server) = delete;
+
+    ~UdpServer()
+    {
+        stop();
+    }
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Binds the sockets and starts the I/O threads.
+     *
+     * @throws std::runtime_error if a socket cannot be bound.
+     */
+    void start() override
+    {
+        if (m_running)
+        {
+            return;
+        }
+
+        if constexpr (RUN_TO_COMPLETION)
+        {
+            if (!m_request_handler)
+            {
+                throw std::logic_error("The request handler must be set before starting the server");
+            }
+        }
+
+        try
+        {
+            for (int i = 0; i < m_io_threads; i++)
+            {
+                m_receivers.push_back(std::make_unique<Receiver>(*this, createSocket()));
+            }
+        }
+        catch (...)
+        {
+            m_receivers.clear();
+            throw;
+        }
+
+        m_running = true;
+
+        for (auto &receiver : m_receivers)
+        {
+            Receiver *r = receiver.get();
+            r->thread = std::thread([this, r]() { receiveLoop(*r); });
+        }
+    }
+
+    void stop()
+    {
+        if (!m_running.exchange(false))
+        {
+            return;
+        }
+
+        // Wakes up the threads waiting for datagrams
+        for (auto &receiver : m_receivers)
+        {
+#ifdef _WIN32
+            closesocket(receiver->sock);
+            receiver->sock = INVALID_SOCKET;
+#else
+            shutdown(receiver->sock, SHUT_RD);
+#endif
+        }
+
+        for (auto &receiver : m_receivers)
+        {
+            if (receiver->thread.joinable())
+            {
+                receiver->thread.join();
+            }
+        }
+
+        m_requests_queue.close();
+        m_receivers.clear();
+    }
+
+    /**
+     * @brief Sends a datagram to the source with the given id. The bytes are
+     * handed to the kernel right away, without being copied. Must not be
+     * called while the server stops.
+     *
+     * @return QUEUED once the kernel took the datagram, DROPPED if it refused
+     * it, NOT_CONNECTED if the server is not running.
+     */
+    SendStatus send(uint64_t id, const std::string &message) override
+    {
+        return sendDatagram(id, "", message);
+    }
+
+    /**
+     * @brief Sends a shared payload, preceded by an optional header specific
+     * to this source, as one datagram.
+     */
+    SendStatus send(uint64_t id, SharedPayload payload, std::string header = "")
+    {
+        return sendDatagram(id, header, payload ? std::string_view(*payload) : std::string_view());
+    }
+
+    /**
+     * @brief Waits for the next decoded request.
+     *
+     * @return The request, or nothing once the server is stopped.
+     */
+    std::optional<Request> next()
+    {
+        Request request;
+
+        if (!m_requests_queue.pop(request))
+        {
+            return std::nullopt;
+        }
+
+        return request;
+    }
+
+    std::string getIp() const override
+    {
+        return m_ip_address;
+    }
+
+    /**
+     * @brief Gets the port, the one the kernel picked once started if it was
+     * constructed with port 0.
+     */
+    int getPort() const override
+    {
+        return m_port;
+    }
+
+    /**
+     * @brief Sets the number of I/O threads, each receiving from its own
+     * socket. Must be called before start().
+     */
+    void setIoThreads(int threads)
+    {
+        if (threads < 1)
+        {
+            throw std::invalid_argument("I/O threads should be at least 1");
+        }
+
+        m_io_threads = threads;
+    }
+
+    /**
+     * @brief Sets how many datagrams are received per call at most. Must be
+     * called before start().
+     *
+     * Every datagram of a batch has a buffer of the client buffer length (see
+     * setClientBufferLen()), larger datagrams being dropped, or of
+     * UDP_GRO_BUFFER_BYTES with GRO.
+     */
+    void setBatchSize(int datagrams)
+    {
+        if (datagrams < 1 || datagrams > MAX_UDP_BATCH_DATAGRAMS)
+        {
+            throw std::invalid_argument("UDP batch size should be between 1 and " +
+                                        std::to_string(MAX_UDP_BATCH_DATAGRAMS));
+        }
+
+        m_batch_size = datagrams;
+    }
+
+    /**
+     * @brief Enables UDP GRO where the kernel supports it, so that one buffer
+     * of a batch receives many datagrams of a source. Enabled by default.
+     * Must be called before start().
+     */
+    void setGro(bool enabled)
+    {
+        m_gro = enabled;
+    }
+
+    /**
+     * @brief Sets the handler of a run-to-completion server. Must be called
+     * before start().
+     *
+     * The I/O thread that received a batch calls the handler for every message
+     * decoded from it, and sends the responses it wrote once the whole batch
+     * is handled. Only meant for handlers that never block, see
+     * TCPServer::setRequestHandler().
+     */
+    void setRequestHandler(Handler handler)
+        requires RUN_TO_COMPLETION
+    {
+        m_request_handler.emplace(std::move(handler));
+    }
+
+    const UdpStats &getStats() const
+    {
+        return m_stats;
+    }
+
+  private:
+    /**
+     * @struct Reply
+     * @brief Datagram written by the request handler, sent with the rest of
+     * its batch.
+     */
+    struct Reply
+    {
+        sockaddr_in destination;
+        OutboundMessage message;
+    };
+
+    /**
+     * @struct Receiver
+     * @brief Socket of one I/O thread, with the buffers of its batches.
+     *
+     * Also the sink of the responses written while its batch is handled.
+     */
+    struct Receiver : ResponseSink
+    {
+        UdpServer &server;
+        SOCKET_TYPE sock;
+        std::thread thread;
+        bool gro = false;
+
+        size_t slot_len = 0;
+        std::unique_ptr<char[]> buffers;
+        std::vector<sockaddr_in> sources;
+
+#ifndef _WIN32
+        std::vector<mmsghdr> headers;
+        std::vector<iovec> segments;
+        std::vector<char> control;
+
+        /**
+         * @brief Header and payload of every reply of a sendmmsg call.
+         */
+        std::vector<iovec> reply_segments;
+#endif
+
+        /**
+         * @brief Messages of the datagram being decoded.
+         */
+        std::vector<std::shared_ptr<MessageType>> messages;
+
+        /**
+         * @brief Requests decoded from the batch, for next().
+         */
+        std::vector<Request> requests;
+
+        /**
+         * @brief Source of the datagram being handled, and the responses
+         * written for the batch.
+         */
+        sockaddr_in current_source{};
+        std::vector<Reply> replies;
+
+        Receiver(UdpServer &server, SOCKET_TYPE sock) : server(server), sock(sock)
+        {
+        }
+
+        Receiver(const Receiver &receiver) = delete;
+        Receiver &operator=(const Receiver &receiver) = delete;
+
+        ~Receiver()
+        {
+#ifdef _WIN32
+            if (sock != INVALID_SOCKET)
+            {
+                closesocket(sock);
+            }
+#else
+            close(sock);
+#endif
+        }
+
+        SendStatus queueResponse(Client * /*client*/, OutboundMessage &&message) override
+        {
+            // Files cannot be sent as datagrams
+            if (message.file.file)
+            {
+                return SendStatus::DROPPED;
+            }
+
+            replies.push_back(Reply{current_source, std::move(message)});
+            return SendStatus::QUEUED;
+        }
+    };
+
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    std::string m_ip_address;
+    sockaddr_in m_server_address{};
+    int m_port;
+
+    std::atomic<bool> m_running = false;
+
+    int m_io_threads = 1;
+    int m_batch_size = UDP_BATCH_DATAGRAMS;
+    bool m_gro = true;
+
+    UdpStats m_stats{};
+
+    std::unique_ptr<Decoder> m_decoder;
+
+    /**
+     * @brief Handler of a run-to-completion server.
+     */
+    std::optional<Handler> m_request_handler;
+
+    /**
+     * @brief Decoded requests, waiting for next().
+     */
+    RingQueue<Request> m_requests_queue{REQUEST_QUEUE_CAPACITY};
+
+    std::vector<std::unique_ptr<Receiver>> m_receivers;
+
+    /**
+     * @brief Requests have no credentials to view: datagrams only come from
+     * addresses.
+     */
+    static inline const std::optional<PeerCredentials> NO_PEER{};
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    /**
+     * @brief Id of a source: its IPv4 address and port, in host byte order.
+     */
+    static uint64_t sourceId(const sockaddr_in &source)
+    {
+        return (uint64_t(ntohl(source.sin_addr.s_addr)) << 16) | ntohs(source.sin_port);
+    }
+
+    static sockaddr_in sourceAddress(uint64_t id)
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(static_cast<uint32_t>(id >> 16));
+        address.sin_port = htons(static_cast<uint16_t>(id & 0xffff));
+        return address;
+    }
+
+    static ClientDto sourceDto(const sockaddr_in &source)
+    {
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &source.sin_addr, ip, INET_ADDRSTRLEN);
+
+        ClientDto dto;
+        dto.id = sourceId(source);
+        dto.ip_address = ip;
+        dto.port = ntohs(source.sin_port);
+        return dto;
+    }
+
+    /**
+     * @brief Creates a socket bound to the server address. Once the first one
+     * is bound, the address holds the port it got, so that with port 0 every
+     * socket shares the port the kernel picked.
+     */
+    SOCKET_TYPE createSocket()
+    {
+        SOCKET_TYPE sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+#ifdef _WIN32
+        if (sock == INVALID_SOCKET)
+#else
+        if (sock < 0)
+#endif
+        {
+            throw std::runtime_error("Error when creating UDP socket! (ip: " + m_ip_address +
+                                     ", port: " + std::to_string(m_port) + ")");
+        }
+
+#ifndef _WIN32
+        int enable = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+#endif
+
+        if (bind(sock, reinterpret_cast<const sockaddr *>(&m_server_address), sizeof(m_server_address)) != 0)
+        {
+            CLOSE_SOCKET(sock);
+            throw std::runtime_error("Binding UDP socket failed! (ip: " + m_ip_address +
+                                     ", port: " + std::to_string(m_port) + ")");
+        }
+
+        if (m_server_address.sin_port == 0)
+        {
+            sockaddr_in bound{};
+            socklen_t bound_len = sizeof(bound);
+            getsockname(sock, reinterpret_cast<sockaddr *>(&bound), &bound_len);
+
+            m_server_address.sin_port = bound.sin_port;
+            m_port = ntohs(bound.sin_port);
+        }
+
+        return sock;
+    }
+
+    /**
+     * @brief Allocates the buffers of the batches of a receiver, once it is
+     * known whether the kernel coalesces datagrams for its socket.
+     */
+    void prepareBatches(Receiver &receiver)
+    {
+#if defined(__linux__) && defined(UDP_GRO)
+        int enable = 1;
+        receiver.gro = m_gro && setsockopt(receiver.sock, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == 0;
+#endif
+
+        size_t batch = static_cast<size_t>(m_batch_size);
+        receiver.slot_len = receiver.gro ? UDP_GRO_BUFFER_BYTES : m_client_buffer_len;
+        receiver.buffers = std::make_unique<char[]>(batch * receiver.slot_len);
+        receiver.sources.resize(batch);
+
+#ifndef _WIN32
+        receiver.headers.resize(batch);
+        receiver.segments.resize(batch);
+        receiver.control.resize(batch * CMSG_SPACE(sizeof(int)));
+        receiver.reply_segments.resize(2 * batch);
+#endif
+    }
+
+    /**
+     * @brief Receives the next batch, waiting for its first datagram.
+     *
+     * @return The number of datagrams, 0 once the socket is shut down, or -1
+     * on error.
+     */
+    int receiveBatch(Receiver &receiver)
+    {
+#ifdef _WIN32
+        int source_len = sizeof(sockaddr_in);
+        int received = recvfrom(receiver.sock, receiver.buffers.get(), static_cast<int>(receiver.slot_len), 0,
+                                reinterpret_cast<sockaddr *>(&receiver.sources[0]), &source_len);
+
+        if (received == SOCKET_ERROR)
+        {
+            if (WSAGetLastError() == WSAEMSGSIZE)
+            {
+                m_stats.truncated.fetch_add(1, std::memory_order_relaxed);
+                return receiveBatch(receiver);
+            }
+
+            return m_running ? -1 : 0;
+        }
+
+        m_stats.datagrams.fetch_add(1, std::memory_order_relaxed);
+        decodeDatagram(receiver, receiver.sources[0], receiver.buffers.get(), static_cast<size_t>(received));
+        return 1;
+#else
+        size_t control_len = CMSG_SPACE(sizeof(int));
+
+        // The kernel overwrites the lengths of the previous batch
+        for (int i = 0; i < m_batch_size; i++)
+        {
+            receiver.segments[i] = iovec{receiver.buffers.get() + i * receiver.slot_len, receiver.slot_len};
+
+            msghdr &header = receiver.headers[i].msg_hdr;
+            header = msghdr{};
+            header.msg_name = &receiver.sources[i];
+            header.msg_namelen = sizeof(sockaddr_in);
+            header.msg_iov = &receiver.segments[i];
+            header.msg_iovlen = 1;
+            header.msg_control = receiver.gro ? receiver.control.data() + i * control_len : nullptr;
+            header.msg_controllen = receiver.gro ? control_len : 0;
+        }
+
+        int received = recvmmsg(receiver.sock, receiver.headers.data(), static_cast<unsigned>(m_batch_size),
+                                MSG_WAITFORONE, nullptr);
+
+        for (int i = 0; i < received; i++)
+        {
+            const msghdr &header = receiver.headers[i].msg_hdr;
+            const char *data = static_cast<const char *>(receiver.segments[i].iov_base);
+            size_t len = receiver.headers[i].msg_len;
+
+            if (header.msg_flags & MSG_TRUNC)
+            {
+                m_stats.truncated.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            // Datagrams coalesced by GRO all have the segment size, but the last
+            size_t segment_len = len;
+
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr;
+                 cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&header), cmsg))
+            {
+#ifdef UDP_GRO
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+                {
+                    int gso_size;
+                    std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+                    segment_len = gso_size > 0 ? static_cast<size_t>(gso_size) : len;
+                }
+#endif
+            }
+
+            size_t offset = 0;
+
+            do
+            {
+                size_t datagram_len = std::min(segment_len, len - offset);
+                m_stats.datagrams.fetch_add(1, std::memory_order_relaxed);
+                decodeDatagram(receiver, receiver.sources[i], data + offset, datagram_len);
+                offset += datagram_len;
+            } while (offset < len);
+        }
+
+        return received;
+#endif
+    }
+
+    /**
+     * @brief Decodes a datagram and hands its messages to the request handler,
+     * or queues them in requests for next().
+     */
+    void decodeDatagram(Receiver &receiver, const sockaddr_in &source, const char *data, size_t len)
+    {
+        std::vector<std::shared_ptr<MessageType>> &messages = receiver.messages;
+        messages.clear();
+
+        if (!m_decoder->decode(data, len, messages))
+        {
+            m_stats.malformed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_stats.messages.fetch_add(messages.size(), std::memory_order_relaxed);
+
+        if (messages.empty())
+        {
+            return;
+        }
+
+        ClientDto dto = sourceDto(source);
+
+        if constexpr (RUN_TO_COMPLETION)
+        {
+            receiver.current_source = source;
+            ResponseWriter response(dto.id, receiver);
+
+            for (std::shared_ptr<MessageType> &message : messages)
+            {
+                RequestView<MessageType> request{dto.id, dto.ip_address, dto.port, *message, NO_PEER};
+                (*m_request_handler)(request, response);
+            }
+        }
+        else
+        {
+            for (std::shared_ptr<MessageType> &message : messages)
+            {
+                receiver.requests.push_back(Request{dto, std::move(message)});
+            }
+        }
+    }
+
+    void receiveLoop(Receiver &receiver)
+    {
+        prepareBatches(receiver);
+
+        while (m_running)
+        {
+            int received = receiveBatch(receiver);
+
+            if (received < 0)
+            {
+#ifndef _WIN32
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+#endif
+                LoggerManager::get_logger()->write(SEVERITY::S_ERROR,
+                                                   "UDP receive failed: " + std::string(std::strerror(errno)));
+                break;
+            }
+
+            if (received == 0)
+            {
+                continue;
+            }
+
+            m_stats.batches.fetch_add(1, std::memory_order_relaxed);
+
+            if constexpr (RUN_TO_COMPLETION)
+            {
+                flushReplies(receiver);
+            }
+            else if (!receiver.requests.empty())
+            {
+                // Blocking would only move the drops to the socket buffer
+                std::vector<Request> &requests = receiver.requests;
+                size_t pushed = m_requests_queue.tryPushBatch(requests.data(), requests.size());
+                m_stats.dropped_requests.fetch_add(requests.size() - pushed, std::memory_order_relaxed);
+                requests.clear();
+            }
+        }
+    }
+
+    /**
+     * @brief Sends the responses written for a batch, as many per call as the
+     * batch size. A datagram the kernel refuses is counted and skipped.
+     */
+    void flushReplies(Receiver &receiver)
+    {
+        std::vector<Reply> &replies = receiver.replies;
+
+#ifdef _WIN32
+        for (Reply &reply : replies)
+        {
+            sendTo(receiver.sock, reply.destination, reply.message.header,
+                   reply.message.payload ? std::string_view(*reply.message.payload) : std::string_view());
+        }
+#else
+        size_t first = 0;
+        std::vector<iovec> &segments = receiver.reply_segments;
+
+        while (first < replies.size())
+        {
+            size_t count = std::min(replies.size() - first, static_cast<size_t>(m_batch_size));
+
+            for (size_t i = 0; i < count; i++)
+            {
+                Reply &reply = replies[first + i];
+                size_t segment_count = 0;
+
+                if (!reply.message.header.empty())
+                {
+                    segments[2 * i + segment_count++] =
+                        iovec{reply.message.header.data(), reply.message.header.size()};
+                }
+
+                if (reply.message.payload && !reply.message.payload->empty())
+                {
+                    segments[2 * i + segment_count++] = iovec{const_cast<char *>(reply.message.payload->data()),
+                                                              reply.message.payload->size()};
+                }
+
+                msghdr &header = receiver.headers[i].msg_hdr;
+                header = msghdr{};
+                header.msg_name = &reply.destination;
+                header.msg_namelen = sizeof(sockaddr_in);
+                header.msg_iov = &segments[2 * i];
+                header.msg_iovlen = segment_count;
+            }
+
+            int sent = sendmmsg(receiver.sock, receiver.headers.data(), static_cast<unsigned>(count), 0);
+
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                // The first datagram was refused, the next ones are tried again
+                m_stats.send_failures.fetch_add(1, std::memory_order_relaxed);
+                first++;
+                continue;
+            }
+
+            m_stats.sent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+            first += static_cast<size_t>(sent);
+        }
+#endif
+
+        replies.clear();
+    }
+
+    SendStatus sendDatagram(uint64_t id, std::string_view header, std::string_view payload)
+    {
+        if (!m_running || m_receivers.empty())
+        {
+            return SendStatus::NOT_CONNECTED;
+        }
+
+        return sendTo(m_receivers.front()->sock, sourceAddress(id), header, payload) ? SendStatus::QUEUED
+                                                                                      : SendStatus::DROPPED;
+    }
+
+    /**
+     * @brief Sends a header and a payload as one datagram, with one call.
+     */
+    bool sendTo(SOCKET_TYPE sock, const sockaddr_in &destination, std::string_view header, std::string_view payload)
+    {
+#ifdef _WIN32
+        WSABUF buffers[2] = {{static_cast<ULONG>(header.size()), const_cast<char *>(header.data())},
+                             {static_cast<ULONG>(payload.size()), const_cast<char *>(payload.data())}};
+        DWORD sent = 0;
+        bool success = WSASendTo(sock, buffers, 2, &sent, 0, reinterpret_cast<const sockaddr *>(&destination),
+                                 sizeof(destination), nullptr, nullptr) == 0;
+#else
+        iovec segments[2] = {iovec{const_cast<char *>(header.data()), header.size()},
+                             iovec{const_cast<char *>(payload.data()), payload.size()}};
+        msghdr message{};
+        message.msg_name = const_cast<sockaddr_in *>(&destination);
+        message.msg_namelen = sizeof(destination);
+        message.msg_iov = segments;
+        message.msg_iovlen = 2;
+
+        bool success = sendmsg(sock, &message, 0) >= 0;
+#endif
+
+        if (success)
+        {
+            m_stats.sent.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            m_stats.send_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return success;
+    }
+};
+
+} // namespace pulse::net
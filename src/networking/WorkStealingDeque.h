@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pulse::net
+{
+
+/**
+ * @class WorkStealingDeque
+ * @brief Chase-Lev deque of pointers: its owner pushes and pops at the
+ * bottom, any other thread steals from the top.
+ *
+ * The owner works depth first on what it pushed last, while thieves take the
+ * oldest items, usually the largest pieces of work. Only the owner and a
+ * thief racing for the last item ever contend, on a single CAS. The memory
+ * orders follow Lê et al., "Correct and Efficient Work-Stealing for Weak
+ * Memory Models".
+ *
+ * The ring grows when full and never shrinks. Replaced rings are kept until
+ * the deque is destroyed, as a thief may still be reading one.
+ *
+ * @tparam T Pointer type; nullptr means the deque was empty.
+ */
+template <typename T> class WorkStealingDeque
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+
+    /**
+     * @param capacity Initial number of items, rounded up to a power of two.
+     */
+    explicit WorkStealingDeque(size_t capacity)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+        {
+            rounded *= 2;
+        }
+
+        m_rings.push_back(std::make_unique<Ring>(rounded));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &deque) = delete;
+    WorkStealingDeque(WorkStealingDeque &&deque) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &deque) = delete;
+    WorkStealingDeque &operator=(WorkStealingDeque &&deque) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Pushes an item at the bottom. Owner only.
+     */
+    void push(T item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        Ring *ring = m_ring.load(std::memory_order_relaxed);
+
+        if (bottom - top >= static_cast<int64_t>(ring->capacity))
+        {
+            ring = grow(ring, top, bottom);
+        }
+
+        ring->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Pops the item pushed last. Owner only.
+     *
+     * @return The item, or nullptr if the deque is empty or a thief took the
+     * last one.
+     */
+    T pop()
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring *ring = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T item = ring->get(bottom);
+
+        // Last item: thieves may be after it too, the CAS on top decides
+        if (top == bottom)
+        {
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                item = nullptr;
+            }
+
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    /**
+     * @brief Takes the oldest item. Any thread.
+     *
+     * @return The item, or nullptr if the deque is empty or another thread
+     * took it first.
+     */
+    T steal()
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+        {
+            return nullptr;
+        }
+
+        Ring *ring = m_ring.load(std::memory_order_acquire);
+        T item = ring->get(top);
+
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        return item;
+    }
+
+    /**
+     * @brief Whether the deque looked empty, which may already be stale.
+     */
+    bool empty() const
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return m_ring.load(std::memory_order_relaxed)->capacity;
+    }
+
+  private:
+    /**
+     * @struct Ring
+     * @brief Items of the deque, indexed by their position modulo the
+     * capacity.
+     */
+    struct Ring
+    {
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Ring(size_t ring_capacity)
+            : capacity(ring_capacity), mask(ring_capacity - 1), items(std::make_unique<std::atomic<T>[]>(ring_capacity))
+        {
+        }
+
+        T get(int64_t position) const
+        {
+            return items[static_cast<size_t>(position) & mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t position, T item)
+        {
+            items[static_cast<size_t>(position) & mask].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    // The owner and the thieves each get their own cache line
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    alignas(64) std::atomic<int64_t> m_top{0};
+    std::atomic<Ring *> m_ring;
+
+    /**
+     * @brief Every ring the deque had, the current one last. Owner only.
+     */
+    std::vector<std::unique_ptr<Ring>> m_rings;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    Ring *grow(Ring *ring, int64_t top, int64_t bottom)
+    {
+        m_rings.push_back(std::make_unique<Ring>(ring->capacity * 2));
+        Ring *grown = m_rings.back().get();
+
+        for (int64_t position = top; position < bottom; position++)
+        {
+            grown->put(position, ring->get(position));
+        }
+
+        m_ring.store(grown, std::memory_order_release);
+        return grown;
+    }
+};
+
+} // namespace pulse::net
@@ -1,12 +1,58 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace pulse::net
 {
 const std::string ANY_IP = "ANY";
 const int MAX_BUFFER_LENGHT_FOR_REQUESTS = 8192;
-const int MAX_CONNECTION_QUEUE = 5;
+const int MAX_CONNECTION_QUEUE = 1024;
+const int MAX_ACCEPTS_PER_LISTENER = 64;
+const uint32_t MAX_CLIENTS = 65536;
+const size_t SEND_BATCH_BYTES = 256 * 1024;
+const int SEND_BATCH_SEGMENTS = 64;
+const int MAX_SEND_BATCH_SEGMENTS = 1024;
+const size_t BUFFER_POOL_MIN_CLASS = 1024;
+const size_t BUFFER_POOL_MAX_CLASS = 1024 * 1024;
+const size_t BUFFER_POOL_SLAB_BYTES = 64 * 1024;
+const int RECV_BUFFER_GROW_AFTER = 2;
+const int RECV_BUFFER_SHRINK_AFTER = 16;
+const size_t TASK_INJECTION_CAPACITY = MAX_CLIENTS;
+const size_t TASK_DEQUE_CAPACITY = 1024;
+const size_t TASK_INLINE_BYTES = 48;
+const size_t TASK_FREE_NODES = 4096;
+const size_t REQUEST_QUEUE_CAPACITY = 16384;
+const unsigned IO_URING_ENTRIES = 4096;
+const int IO_URING_REGISTERED_BUFFERS = 1024;
+const int IO_URING_REARM_RETRY_MS = 1;
+const int IO_URING_DRAIN_TIMEOUT_MS = 1000;
+const unsigned long IOCP_DRAIN_TIMEOUT_MS = 100;
+const uint64_t TIMER_WHEEL_TICK_MS = 100;
+const uint32_t IDLE_TIMEOUT_MS = 60000;
+const uint32_t HEADER_TIMEOUT_MS = 10000;
+const uint32_t BODY_TIMEOUT_MS = 30000;
+const uint32_t WRITE_TIMEOUT_MS = 30000;
+const size_t OUTBOUND_CLIENT_HIGH_WATERMARK = 16 * 1024 * 1024;
+const size_t OUTBOUND_CLIENT_LOW_WATERMARK = 4 * 1024 * 1024;
+const size_t OUTBOUND_GLOBAL_HIGH_WATERMARK = 1024 * 1024 * 1024;
+const size_t OUTBOUND_GLOBAL_LOW_WATERMARK = 768 * 1024 * 1024;
+const size_t MEMORY_BUDGET_BYTES = size_t(2) * 1024 * 1024 * 1024;
+const size_t MEMORY_ACCEPT_WATERMARK = size_t(1536) * 1024 * 1024;
+const size_t ADDRESS_LIMITER_SHARDS = 64;
+const size_t ADDRESS_LIMITER_SHARD_SLOTS = 16;
+const uint64_t ADDRESS_LIMITER_LOG_INTERVAL_MS = 10000;
+const size_t TLS_SESSION_CACHE_SIZE = 65536;
+const size_t TLS_SESSION_CACHE_SHARDS = 16;
+const uint32_t TLS_SESSION_TIMEOUT_S = 7200;
+const size_t TLS_RECORD_PLAINTEXT_BYTES = 16384;
+const size_t TLS_OUTPUT_CHUNK_BYTES = 64 * 1024;
+const size_t FILE_SEND_CHUNK_BYTES = size_t(1) << 30;
+const unsigned UNIX_SOCKET_MODE = 0660;
+const int UDP_BATCH_DATAGRAMS = 64;
+const int MAX_UDP_BATCH_DATAGRAMS = 1024;
+const size_t UDP_GRO_BUFFER_BYTES = 65535;
 } // namespace pulse::net
 #endif
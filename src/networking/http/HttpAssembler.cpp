@@ -4,6 +4,7 @@
 #include "../Utils.h"
 #include <algorithm>
 #include <charconv>
+#include <cstring>
 
 namespace pulse::net
 {
@@ -12,34 +13,19 @@ HttpAssembler::HttpAssembler(bool assemble_chunked_requests) : m_assemble_chunke
 {
 }
 
-HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, int &buffer_len, int max_buffer_len,
-                                                    int last_tcp_packet_len)
+std::unique_ptr<AssemblerState> HttpAssembler::onConnect(uint64_t /*id*/)
 {
+    return std::make_unique<HttpStreamState>();
+}
 
-    std::shared_lock lock(m_mtx);
-
-    HttpStreamState *client_state_ptr;
-
-    auto it = m_client_states.find(id);
-    if (it != m_client_states.end())
-    {
-        client_state_ptr = &it->second;
-        lock.unlock();
-    }
-    else
-    {
-        lock.unlock();
-        std::unique_lock u_lock(m_mtx);
-
-        client_state_ptr = &m_client_states[id];
-
-        u_lock.unlock();
-    }
-
-    HttpStreamState &client_state = m_client_states[id]; // For convenience
+HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, AssemblerState *state, char *buffer,
+                                                    int &buffer_len, int max_buffer_len, int /*last_tcp_packet_len*/)
+{
+    HttpStreamState &client_state = *static_cast<HttpStreamState *>(state);
 
     bool finished = false;
 
+    HttpStatus error_status = HttpStatus::BAD_REQUEST;
     std::string error_message = "Error: malformed request syntax";
     std::string error_details;
 
@@ -119,7 +105,8 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                 }
                 else
                 {
-                    client_state.http_code = (buffer[0] - '0') * 100 + (buffer[1] - '0') * 10 + (buffer[2] - '0');
+                    const char *code = buffer + client_state.i_start;
+                    client_state.http_code = (code[0] - '0') * 100 + (code[1] - '0') * 10 + (code[2] - '0');
                     client_state.state = HttpState::STATE_PARSE_RESPONSE_HEDAERS_START;
                     client_state.i_start = i + 1;
                     client_state.i_end = i + 1;
@@ -285,11 +272,24 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                         int length = 0;
                         if (parseNumber(it->second, length) && length <= m_max_body_size)
                         {
-                            client_state.state = HttpState::STATE_PARSE_BODY;
-                            client_state.body_lenght = length;
-                            client_state.i_start = i + 1;
-                            client_state.i_end = i + 1;
-                            client_state.length_counter = 0;
+                            // Rejected before any of its bytes is read if it may not be buffered
+                            if (client_state.body_memory.resize(m_memory_budget, std::max(length, 0)))
+                            {
+                                client_state.state = HttpState::STATE_PARSE_BODY;
+                                client_state.body_lenght = length;
+                                client_state.i_start = i + 1;
+                                client_state.i_end = i + 1;
+                                client_state.length_counter = 0;
+                            }
+                            else
+                            {
+                                log(SEVERITY::INFO, "Rejected http request of connection " + std::to_string(id) +
+                                                        ": No memory left for a body of " + std::to_string(length) +
+                                                        " bytes");
+                                error_status = HttpStatus::SERVICE_UNAVAILABLE;
+                                error_message = "Error: not enough memory to receive the request";
+                                client_state.state = HttpState::STATE_ERROR;
+                            }
                         }
                         else if (length > m_max_body_size)
                         {
@@ -313,17 +313,7 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                                                                                 client_state.method, client_state.uri,
                                                                                 std::move(client_state.headers)));
 
-                        if (client_state.pos == buffer_len - 1)
-                        {
-                            buffer_len = 0;
-                        }
-                        else
-                        {
-                            std::memmove(buffer, buffer + client_state.pos + 1, buffer_len - client_state.pos);
-                            buffer_len = buffer_len - client_state.pos - 1;
-                        }
-
-                        resetState(client_state);
+                        consumeMessage(client_state);
                         continue;
                     }
                 }
@@ -417,24 +407,15 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                 }
                 else
                 {
-                    client_state.body.append(buffer + client_state.i_start, client_state.pos + 1);
+                    client_state.body.append(buffer + client_state.i_start,
+                                             client_state.pos + 1 - client_state.i_start);
 
                     result.messages.push_back(std::make_shared<HttpMessage>(
                         client_state.http_version, client_state.method, std::move(client_state.uri),
                         std::move(client_state.headers), std::move(client_state.body)));
                 }
 
-                if (client_state.pos == buffer_len - 1)
-                {
-                    buffer_len = 0;
-                }
-                else
-                {
-                    std::memmove(buffer, buffer + client_state.pos + 1, buffer_len - client_state.pos);
-                    buffer_len = buffer_len - client_state.pos - 1;
-                }
-
-                resetState(client_state);
+                consumeMessage(client_state);
                 continue;
             }
             break;
@@ -453,6 +434,15 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                             "Rejected http request of connection " + std::to_string(id) + ": Chunk size too large");
                         client_state.state = HttpState::STATE_ERROR;
                     }
+                    else if (length > 0 && !client_state.body_memory.resize(m_memory_budget, length))
+                    {
+                        log(SEVERITY::INFO, "Rejected http request of connection " + std::to_string(id) +
+                                                ": No memory left for a chunk of " + std::to_string(length) +
+                                                " bytes");
+                        error_status = HttpStatus::SERVICE_UNAVAILABLE;
+                        error_message = "Error: not enough memory to receive the request";
+                        client_state.state = HttpState::STATE_ERROR;
+                    }
                     else if (length > 0)
                     {
                         client_state.current_chunk_length = length;
@@ -514,7 +504,8 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                     }
                     else
                     {
-                        client_state.body.append(buffer + client_state.i_start, client_state.pos + 1);
+                        client_state.body.append(buffer + client_state.i_start,
+                                             client_state.pos + 1 - client_state.i_start);
 
                         result.messages.push_back(std::make_shared<HttpMessage>(
                             client_state.http_version, client_state.method, client_state.uri,
@@ -523,20 +514,13 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                         client_state.body.clear();
                     }
 
-                    if (client_state.pos == buffer_len - 1)
-                    {
-                        buffer_len = 0;
-                    }
-                    else
-                    {
-                        std::memmove(buffer, buffer + client_state.pos + 1, buffer_len - client_state.pos);
-                        buffer_len = buffer_len - client_state.pos - 1;
-                    }
-
-                    client_state.pos = 0;
-                    client_state.i_start = 0;
-                    client_state.i_end = 0;
+                    // The next chunk starts the unconsumed part of the window
+                    client_state.pos++;
+                    client_state.base = client_state.pos;
+                    client_state.i_start = client_state.pos;
+                    client_state.i_end = client_state.pos;
                     client_state.current_chunk_length = 0;
+                    client_state.body_memory.reset();
                     client_state.state = HttpState::STATE_PARSE_CHUNK_SKIP_LINE;
                     continue;
                 }
@@ -578,17 +562,7 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
                                                                         std::move(client_state.uri),
                                                                         std::move(client_state.headers), ""));
 
-                if (client_state.pos == buffer_len - 1)
-                {
-                    buffer_len = 0;
-                }
-                else
-                {
-                    std::memmove(buffer, buffer + client_state.pos + 1, buffer_len - client_state.pos);
-                    buffer_len = buffer_len - client_state.pos - 1;
-                }
-
-                resetState(client_state);
+                consumeMessage(client_state);
                 continue;
             }
             else if (size < 2 && (c == '\n' || c == '\r'))
@@ -631,10 +605,7 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
             }
 
             client_state.body.append(buffer + client_state.i_start, client_state.pos - client_state.i_start);
-            buffer_len = 0;
-            client_state.i_start = 0;
-            client_state.i_end = 0;
-            client_state.pos = 0;
+            client_state.base = client_state.pos;
         }
         else if (client_state.state == HttpState::STATE_PARSE_CHUNK)
         {
@@ -644,31 +615,24 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
             }
 
             client_state.body.append(buffer + client_state.i_start, client_state.pos - client_state.i_start);
-            buffer_len = 0;
-            client_state.i_start = 0;
-            client_state.i_end = 0;
-            client_state.pos = 0;
+            client_state.base = client_state.pos;
         }
-        else if (client_state.last_checkpoint == -1)
+        else if (client_state.last_checkpoint != -1)
+        {
+            // The headers parsed so far are kept in the state, so their bytes can go
+            client_state.base = client_state.last_checkpoint;
+            client_state.last_checkpoint = -1;
+        }
+        else if (client_state.base == 0)
         {
             client_state.state = HttpState::STATE_ERROR;
             log(SEVERITY::INFO, "Rejected http request of connection " + std::to_string(id) + ": Out of buffer memory");
         }
-        else
-        {
+    }
 
-            std::memmove(buffer, buffer + client_state.last_checkpoint, client_state.last_checkpoint);
-            client_state.i_start = std::max(client_state.i_start - client_state.last_checkpoint, 0);
-            client_state.i_end = std::max(client_state.i_end - client_state.last_checkpoint, 0);
-            client_state.header_name_start = std::max(client_state.header_name_start - client_state.last_checkpoint, 0);
-            client_state.header_name_end = std::max(client_state.header_name_end - client_state.last_checkpoint, 0);
-            client_state.header_value_start =
-                std::max(client_state.header_value_start - client_state.last_checkpoint, 0);
-            client_state.header_value_end = std::max(client_state.header_value_end - client_state.last_checkpoint, 0);
-            buffer_len -= client_state.last_checkpoint;
-            client_state.pos -= client_state.last_checkpoint;
-            client_state.last_checkpoint = -1;
-        }
+    if (client_state.state != HttpState::STATE_ERROR && client_state.base > 0)
+    {
+        compact(client_state, buffer, buffer_len);
     }
 
     if (client_state.state == HttpState::STATE_ERROR)
@@ -683,8 +647,9 @@ HttpAssembler::AssemblingResult HttpAssembler::feed(uint64_t id, char *buffer, i
         std::string json_body = oss.str();
         size_t size = json_body.size();
 
-        HttpMessage response(client_state.http_version, HttpStatus::BAD_REQUEST, std::move(json_body));
+        HttpMessage response(client_state.http_version, error_status, std::move(json_body));
 
+        client_state.base = 0;
         resetState(client_state);
         buffer_len = 0;
 
@@ -744,8 +709,8 @@ void HttpAssembler::resetState(HttpStreamState &state) const
     state.http_code = -1;
 
     state.uri = "";
-    state.i_start = 0;
-    state.i_end = 0;
+    state.i_start = state.base;
+    state.i_end = state.base;
     state.header_name_start = 0;
     state.header_name_end = 0;
     state.header_value_start = 0;
@@ -755,8 +720,41 @@ void HttpAssembler::resetState(HttpStreamState &state) const
     state.current_chunk_length = 0;
     state.last_checkpoint = -1;
     state.body.clear();
+    state.body_memory.reset();
+
+    state.pos = state.base;
+}
+
+void HttpAssembler::consumeMessage(HttpStreamState &state) const
+{
+    state.base = state.pos + 1;
+    resetState(state);
+}
+
+void HttpAssembler::compact(HttpStreamState &state, char *buffer, int &buffer_len) const
+{
+    int consumed = state.base;
+
+    if (consumed < buffer_len)
+    {
+        std::memmove(buffer, buffer + consumed, buffer_len - consumed);
+    }
+
+    buffer_len -= consumed;
+    state.pos -= consumed;
+    state.i_start = std::max(state.i_start - consumed, 0);
+    state.i_end = std::max(state.i_end - consumed, 0);
+    state.header_name_start = std::max(state.header_name_start - consumed, 0);
+    state.header_name_end = std::max(state.header_name_end - consumed, 0);
+    state.header_value_start = std::max(state.header_value_start - consumed, 0);
+    state.header_value_end = std::max(state.header_value_end - consumed, 0);
+
+    if (state.last_checkpoint != -1)
+    {
+        state.last_checkpoint -= consumed;
+    }
 
-    state.pos = 0;
+    state.base = 0;
 }
 
 HttpMethod HttpAssembler::parseMethod(std::string_view part) const
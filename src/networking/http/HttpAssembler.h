@@ -1,10 +1,11 @@
 #pragma once
 #include "../LoggerManager.h"
+#include "../MemoryBudget.h"
 #include "../TCPMessageAssembler.h"
 #include "../constants.h"
 #include "HttpHelpers.h"
 #include "HttpMessage.h"
-#include <shared_mutex>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -16,8 +17,10 @@ class HttpAssembler : public TCPMessageAssembler<HttpMessage>
   public:
     HttpAssembler(bool assemble_chunked_requests = false);
 
-    virtual AssemblingResult feed(uint64_t id, char *buffer, int &buffer_len, int max_buffer_len,
-                                  int last_tcp_packet_len);
+    virtual std::unique_ptr<AssemblerState> onConnect(uint64_t id);
+
+    virtual AssemblingResult feed(uint64_t id, AssemblerState *state, char *buffer, int &buffer_len,
+                                  int max_buffer_len, int last_tcp_packet_len);
 
     void setMaxRequestLineLength(int length);
     void setMaxRequestHeaderBytes(int length);
@@ -51,9 +54,14 @@ class HttpAssembler : public TCPMessageAssembler<HttpMessage>
         STATE_ERROR
     };
 
-    struct HttpStreamState
+    /**
+     * @brief Parsing state of a connection. Offsets index the receive buffer,
+     * whose bytes before base belong to messages already consumed.
+     */
+    struct HttpStreamState : AssemblerState
     {
         int pos = 0;
+        int base = 0;
 
         int i_start = 0, i_end = 0;
         int header_name_start = 0, header_name_end = 0;
@@ -73,19 +81,53 @@ class HttpAssembler : public TCPMessageAssembler<HttpMessage>
         std::unordered_map<std::string, std::string> headers;
         std::string body;
 
+        /**
+         * @brief Memory held for the body being received, from its headers
+         * (or chunk size) until it is handed over.
+         */
+        MemoryReservation body_memory{MemoryUse::REQUEST_BODIES};
+
         HttpState state = HttpState::STATE_PARSE_RESPONSE_OR_REQUEST;
         HttpMethod method = HttpMethod::UNKNOWN;
         HttpType type = HttpType::UNKNOWN;
         int http_code = -1;
 
         std::string uri;
+
+        ReadPhase readPhase() const override
+        {
+            switch (state)
+            {
+            case HttpState::STATE_START:
+            case HttpState::STATE_PARSE_RESPONSE_OR_REQUEST:
+                return ReadPhase::IDLE;
+            case HttpState::STATE_PARSE_BODY:
+            case HttpState::STATE_PARSE_CHUNK_SIZE:
+            case HttpState::STATE_PARSE_CHUNK_SKIP_LINE:
+            case HttpState::STATE_PARSE_CHUNK:
+            case HttpState::STATE_PARSE_END_OF_CHUNKED_REQUEST:
+                return ReadPhase::BODY;
+            default:
+                return ReadPhase::HEADER;
+            }
+        }
     };
 
-    std::unordered_map<uint64_t, HttpStreamState> m_client_states;
-    std::shared_mutex m_mtx;
     bool m_assemble_chunked_requests = false;
 
     void resetState(HttpStreamState &state) const;
+
+    /**
+     * @brief Moves the read cursor past the message ending at pos and gets
+     * ready for the next one.
+     */
+    void consumeMessage(HttpStreamState &state) const;
+
+    /**
+     * @brief Drops the consumed bytes from the front of the buffer, moving
+     * only the ones not parsed into a message yet.
+     */
+    void compact(HttpStreamState &state, char *buffer, int &buffer_len) const;
     HttpMethod parseMethod(std::string_view part) const;
     bool parseNumber(const std::string &s, int &result) const;
 
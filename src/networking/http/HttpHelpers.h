@@ -12,7 +12,8 @@ enum class HttpStatus
     BAD_REQUEST = 400,
     UNAUTHORIZED = 401,
     FORBIDDEN = 403,
-    NOT_FOUND = 404
+    NOT_FOUND = 404,
+    SERVICE_UNAVAILABLE = 503
 };
 
 enum class HttpType
@@ -89,6 +90,8 @@ constexpr std::string getStatusName(HttpStatus status)
         return "Forbidden";
     case HttpStatus::NOT_FOUND:
         return "Not Found";
+    case HttpStatus::SERVICE_UNAVAILABLE:
+        return "Service Unavailable";
     default:
         return "Unknown Status";
     }
@@ -0,0 +1,716 @@
+#include "TlsContext.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+
+#include "../ConnectionTimer.h"
+#include "../LoggerManager.h"
+
+// The keys are taken from OpenSSL the way it hands them to kTLS, which is
+// internal to it, so only the versions known to hand them that way offload
+#if defined(__linux__) && !defined(OPENSSL_NO_KTLS) && OPENSSL_VERSION_NUMBER >= 0x30000000L &&                  \
+    OPENSSL_VERSION_NUMBER < 0x30200000L
+#define PULSENET_KTLS
+#include <cstddef>
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+namespace pulse::net
+{
+
+namespace
+{
+
+#ifdef PULSENET_KTLS
+/**
+ * @brief Control OpenSSL 3.0 and 3.1 hand the keys of a direction to their BIO
+ * with, when SSL_OP_ENABLE_KTLS is set (BIO_set_ktls(), internal to OpenSSL).
+ */
+constexpr int BIO_CTRL_SET_KTLS_KEYS = 72;
+
+/**
+ * @brief Size of the sequence number of a record, the same for every cipher.
+ */
+constexpr size_t TLS_RECORD_SEQUENCE_BYTES = 8;
+
+/**
+ * @brief Keys handed with BIO_CTRL_SET_KTLS_KEYS: the crypto info of the
+ * cipher setsockopt(TLS_TX) takes, which starts with the cipher.
+ *
+ * OpenSSL follows it with its length, at an offset that depends on the kernel
+ * headers OpenSSL was built with, so only the crypto info of the cipher is
+ * read (see cryptoInfoSize()).
+ */
+struct KernelCryptoInfo
+{
+    union {
+        tls_crypto_info info;
+        tls12_crypto_info_aes_gcm_128 aes_gcm_128;
+        tls12_crypto_info_aes_gcm_256 aes_gcm_256;
+#ifdef TLS_CIPHER_AES_CCM_128
+        tls12_crypto_info_aes_ccm_128 aes_ccm_128;
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        tls12_crypto_info_chacha20_poly1305 chacha20_poly1305;
+#endif
+    };
+
+    /**
+     * @return Size of the crypto info of a cipher, or 0 for a cipher the
+     * kernel headers do not know.
+     */
+    static size_t cryptoInfoSize(const tls_crypto_info &header)
+    {
+        switch (header.cipher_type)
+        {
+        case TLS_CIPHER_AES_GCM_128:
+            return sizeof(tls12_crypto_info_aes_gcm_128);
+        case TLS_CIPHER_AES_GCM_256:
+            return sizeof(tls12_crypto_info_aes_gcm_256);
+#ifdef TLS_CIPHER_AES_CCM_128
+        case TLS_CIPHER_AES_CCM_128:
+            return sizeof(tls12_crypto_info_aes_ccm_128);
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case TLS_CIPHER_CHACHA20_POLY1305:
+            return sizeof(tls12_crypto_info_chacha20_poly1305);
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Sequence number of the next record, big endian.
+     */
+    unsigned char *recordSequence()
+    {
+        switch (info.cipher_type)
+        {
+        case TLS_CIPHER_AES_GCM_256:
+            return aes_gcm_256.rec_seq;
+#ifdef TLS_CIPHER_AES_CCM_128
+        case TLS_CIPHER_AES_CCM_128:
+            return aes_ccm_128.rec_seq;
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case TLS_CIPHER_CHACHA20_POLY1305:
+            return chacha20_poly1305.rec_seq;
+#endif
+        default:
+            return aes_gcm_128.rec_seq;
+        }
+    }
+};
+
+// The header of the keys is read before their cipher is known, and the
+// sequence numbers are advanced the same way for every cipher
+static_assert(offsetof(tls12_crypto_info_aes_gcm_128, info) == 0 &&
+                  offsetof(tls12_crypto_info_aes_gcm_256, info) == 0,
+              "crypto info must start with its header");
+static_assert(TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE == TLS_RECORD_SEQUENCE_BYTES &&
+                  TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE == TLS_RECORD_SEQUENCE_BYTES,
+              "record sequence numbers must be 8 bytes");
+#ifdef TLS_CIPHER_AES_CCM_128
+static_assert(offsetof(tls12_crypto_info_aes_ccm_128, info) == 0 &&
+                  TLS_CIPHER_AES_CCM_128_REC_SEQ_SIZE == TLS_RECORD_SEQUENCE_BYTES,
+              "unexpected AES-CCM crypto info");
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+static_assert(offsetof(tls12_crypto_info_chacha20_poly1305, info) == 0 &&
+                  TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE == TLS_RECORD_SEQUENCE_BYTES,
+              "unexpected ChaCha20-Poly1305 crypto info");
+#endif
+#endif
+
+std::string lastSslError()
+{
+    unsigned long code = ERR_get_error();
+
+    if (code == 0)
+    {
+        return "unknown error";
+    }
+
+    char message[256];
+    ERR_error_string_n(code, message, sizeof(message));
+    ERR_clear_error();
+    return message;
+}
+
+/**
+ * @brief Size of the header of a TLS record, whose last two bytes are the
+ * length of the rest.
+ */
+constexpr size_t TLS_RECORD_HEADER_BYTES = 5;
+
+} // namespace
+
+/* ----------------
+ * OpenSslSession
+ * ----------------
+ */
+
+/**
+ * @class OpenSslSession
+ * @brief TlsSession of an OpenSSL server connection.
+ *
+ * Ciphertext received goes through a memory BIO. Records OpenSSL writes go
+ * through a BIO of the session into the output, which also captures the keys
+ * OpenSSL would hand to kTLS and counts the records written with them, so the
+ * kernel can take the sending direction over once the output is written.
+ */
+class OpenSslSession : public TlsSession
+{
+  public:
+    OpenSslSession(TlsContext &context, SSL *ssl) : m_context(context), m_ssl(ssl)
+    {
+        BIO *rbio = BIO_new(BIO_s_mem());
+        BIO *wbio = BIO_new(outputMethod());
+
+        BIO_set_data(wbio, this);
+        BIO_set_init(wbio, 1);
+
+        // End of the memory BIO means more ciphertext is needed, not EOF
+        BIO_set_mem_eof_return(rbio, -1);
+
+        SSL_set_bio(m_ssl, rbio, wbio);
+        SSL_set_accept_state(m_ssl);
+    }
+
+    ~OpenSslSession() override
+    {
+#ifdef PULSENET_KTLS
+        OPENSSL_cleanse(&m_keys, sizeof(m_keys));
+#endif
+        // Connections are mostly closed without close_notify, which would
+        // otherwise remove their session from the cache
+        if (m_established && (!m_failed || (SSL_get_shutdown(m_ssl) & SSL_RECEIVED_SHUTDOWN) != 0))
+        {
+            SSL_set_shutdown(m_ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+
+        SSL_free(m_ssl);
+    }
+
+    void receive(const char *data, size_t len) override
+    {
+        if (len > 0)
+        {
+            BIO_write(SSL_get_rbio(m_ssl), data, static_cast<int>(len));
+        }
+    }
+
+    long read(char *out, size_t len) override
+    {
+        if (m_failed)
+        {
+            return -1;
+        }
+
+        ERR_clear_error();
+
+        size_t total = 0;
+        bool closed = false;
+
+        while (total < len)
+        {
+            size_t read = 0;
+
+            if (SSL_read_ex(m_ssl, out + total, len - total, &read) == 1)
+            {
+                total += read;
+                continue;
+            }
+
+            int error = SSL_get_error(m_ssl, 0);
+
+            if (error == SSL_ERROR_WANT_READ)
+            {
+                break;
+            }
+
+            if (error == SSL_ERROR_ZERO_RETURN)
+            {
+                m_error = "connection closed by the peer";
+                closed = true;
+            }
+            else
+            {
+                m_error = lastSslError();
+                m_context.stats().failed_sessions.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            m_failed = true;
+            break;
+        }
+
+        if (!m_established && SSL_is_init_finished(m_ssl))
+        {
+            m_established = true;
+            m_context.stats().handshakes.fetch_add(1, std::memory_order_relaxed);
+
+            if (SSL_session_reused(m_ssl))
+            {
+                m_context.stats().resumed_handshakes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // What the peer sent before closing is still delivered
+        if (m_failed && !(closed && total > 0))
+        {
+            return -1;
+        }
+
+        m_buffered_input = total == len && (SSL_pending(m_ssl) > 0 || BIO_ctrl_pending(SSL_get_rbio(m_ssl)) > 0);
+        return static_cast<long>(total);
+    }
+
+    bool hasBufferedInput() const override
+    {
+        return m_buffered_input;
+    }
+
+    bool isEstablished() const override
+    {
+        return m_established;
+    }
+
+    void seal(const char *data, size_t len) override
+    {
+        // Full records are written right away, the rest waits for the next
+        // call or closeRecord()
+        while (len > 0)
+        {
+            if (m_plaintext.empty() && len >= TLS_RECORD_PLAINTEXT_BYTES)
+            {
+                size_t full = len - len % TLS_RECORD_PLAINTEXT_BYTES;
+                write(data, full);
+                data += full;
+                len -= full;
+                continue;
+            }
+
+            size_t taken = std::min(len, TLS_RECORD_PLAINTEXT_BYTES - m_plaintext.size());
+            m_plaintext.append(data, taken);
+            data += taken;
+            len -= taken;
+
+            if (m_plaintext.size() == TLS_RECORD_PLAINTEXT_BYTES)
+            {
+                closeRecord();
+            }
+        }
+    }
+
+    void closeRecord() override
+    {
+        if (!m_plaintext.empty())
+        {
+            write(m_plaintext.data(), m_plaintext.size());
+            m_plaintext.clear();
+        }
+    }
+
+    bool offload(SOCKET_TYPE sock) override
+    {
+        if (m_offloaded)
+        {
+            return true;
+        }
+
+#ifdef PULSENET_KTLS
+        if (!m_established || !m_keys_captured || m_offload_tried)
+        {
+            return false;
+        }
+
+        m_offload_tried = true;
+
+        // Records sealed since the keys were captured advanced the sequence
+        unsigned char *sequence = m_keys.recordSequence();
+        uint64_t records = m_records_since_keys;
+
+        for (size_t i = TLS_RECORD_SEQUENCE_BYTES; i > 0 && records > 0; i--)
+        {
+            records += sequence[i - 1];
+            sequence[i - 1] = static_cast<unsigned char>(records & 0xFF);
+            records >>= 8;
+        }
+
+        if (setsockopt(sock, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) == 0 &&
+            setsockopt(sock, SOL_TLS, TLS_TX, &m_keys, static_cast<socklen_t>(m_keys_len)) == 0)
+        {
+            m_offloaded = true;
+            m_context.stats().offloaded_sessions.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            m_context.reportOffloadFailure(std::strerror(errno));
+        }
+
+        OPENSSL_cleanse(&m_keys, sizeof(m_keys));
+        return m_offloaded;
+#else
+        (void)sock;
+        return false;
+#endif
+    }
+
+    bool isOffloaded() const override
+    {
+        return m_offloaded;
+    }
+
+    std::string getError() const override
+    {
+        return m_error;
+    }
+
+  private:
+    TlsContext &m_context;
+    SSL *m_ssl;
+
+    bool m_established = false;
+    bool m_failed = false;
+    bool m_buffered_input = false;
+    bool m_offloaded = false;
+    std::string m_error;
+
+    /**
+     * @brief Plaintext waiting for a fuller record.
+     */
+    std::string m_plaintext;
+
+#ifdef PULSENET_KTLS
+    KernelCryptoInfo m_keys{};
+    size_t m_keys_len = 0;
+    bool m_keys_captured = false;
+    bool m_offload_tried = false;
+
+    /**
+     * @brief Records written since the keys were captured, counted from
+     * their headers: bytes left of the current record, and of its header.
+     */
+    uint64_t m_records_since_keys = 0;
+    size_t m_record_left = 0;
+    size_t m_header_len = 0;
+    unsigned char m_header[TLS_RECORD_HEADER_BYTES]{};
+#endif
+
+    void write(const char *data, size_t len)
+    {
+        size_t written = 0;
+
+        if (SSL_write_ex(m_ssl, data, len, &written) != 1 && !m_failed)
+        {
+            m_error = lastSslError();
+            m_failed = true;
+            m_context.stats().failed_sessions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Appends records OpenSSL wrote to the output.
+     *
+     * @return false once the kernel encrypts, as OpenSSL may not write
+     * records anymore (e.g. a key update).
+     */
+    bool output(const char *data, size_t len)
+    {
+        if (m_offloaded)
+        {
+            return false;
+        }
+
+#ifdef PULSENET_KTLS
+        if (m_keys_captured)
+        {
+            countRecords(reinterpret_cast<const unsigned char *>(data), len);
+        }
+#endif
+
+        appendOutput(data, len);
+        return true;
+    }
+
+#ifdef PULSENET_KTLS
+    void countRecords(const unsigned char *data, size_t len)
+    {
+        while (len > 0)
+        {
+            if (m_record_left > 0)
+            {
+                size_t skipped = std::min(len, m_record_left);
+                m_record_left -= skipped;
+                data += skipped;
+                len -= skipped;
+                continue;
+            }
+
+            m_header[m_header_len++] = *data++;
+            len--;
+
+            if (m_header_len == TLS_RECORD_HEADER_BYTES)
+            {
+                m_record_left = static_cast<size_t>(m_header[3]) << 8 | m_header[4];
+                m_header_len = 0;
+                m_records_since_keys++;
+            }
+        }
+    }
+
+    /**
+     * @brief Keeps the keys OpenSSL would hand to kTLS for the sending
+     * direction, refusing them so that it goes on encrypting the records of
+     * the handshake, which are still to be written.
+     */
+    void captureKeys(int is_tx, const void *keys)
+    {
+        if (is_tx == 0 || keys == nullptr)
+        {
+            return;
+        }
+
+        tls_crypto_info header;
+        std::memcpy(&header, keys, sizeof(header));
+        m_keys_len = KernelCryptoInfo::cryptoInfoSize(header);
+
+        if (m_keys_len == 0 || (header.version != TLS_1_2_VERSION && header.version != TLS_1_3_VERSION))
+        {
+            OPENSSL_cleanse(&m_keys, sizeof(m_keys));
+            m_keys_captured = false;
+            return;
+        }
+
+        std::memcpy(&m_keys, keys, m_keys_len);
+        m_keys_captured = true;
+        m_records_since_keys = 0;
+        m_record_left = 0;
+        m_header_len = 0;
+    }
+#endif
+
+    static BIO_METHOD *outputMethod()
+    {
+        static BIO_METHOD *method = [] {
+            BIO_METHOD *created = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "pulsenet tls output");
+
+            BIO_meth_set_write(created, [](BIO *bio, const char *data, int len) -> int {
+                auto *session = static_cast<OpenSslSession *>(BIO_get_data(bio));
+                return session->output(data, static_cast<size_t>(len)) ? len : -1;
+            });
+
+            BIO_meth_set_ctrl(created, [](BIO *bio, int cmd, long num, void *ptr) -> long {
+                switch (cmd)
+                {
+                case BIO_CTRL_FLUSH:
+                    return 1;
+#ifdef PULSENET_KTLS
+                case BIO_CTRL_SET_KTLS_KEYS:
+                    static_cast<OpenSslSession *>(BIO_get_data(bio))->captureKeys(static_cast<int>(num), ptr);
+                    return 0;
+#endif
+                default:
+                    (void)bio;
+                    (void)num;
+                    (void)ptr;
+                    return 0;
+                }
+            });
+
+            return created;
+        }();
+
+        return method;
+    }
+};
+
+/* ----------------
+ * Session cache
+ * ----------------
+ */
+
+/**
+ * @struct TlsCacheCallbacks
+ * @brief Stores the sessions OpenSSL hands over in the TlsSessionCache of the
+ * context, serialized, and looks them up when a client resumes by id.
+ */
+struct TlsCacheCallbacks
+{
+    static TlsContext &contextOf(SSL *ssl)
+    {
+        return *static_cast<TlsContext *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    }
+
+    static int onNew(SSL *ssl, SSL_SESSION *session)
+    {
+        unsigned int id_len = 0;
+        const unsigned char *id = SSL_SESSION_get_id(session, &id_len);
+        int len = i2d_SSL_SESSION(session, nullptr);
+
+        if (len <= 0)
+        {
+            return 0;
+        }
+
+        std::string serialized(static_cast<size_t>(len), '\0');
+        auto *out = reinterpret_cast<unsigned char *>(serialized.data());
+        i2d_SSL_SESSION(session, &out);
+
+        contextOf(ssl).m_cache->put(std::string(reinterpret_cast<const char *>(id), id_len), std::move(serialized),
+                                    ConnectionTimer::clock());
+
+        // The session is not kept, only its serialization
+        return 0;
+    }
+
+    static SSL_SESSION *onGet(SSL *ssl, const unsigned char *id, int id_len, int *copy)
+    {
+        TlsContext &context = contextOf(ssl);
+        std::string serialized;
+        *copy = 0;
+
+        if (!context.m_cache->get(std::string(reinterpret_cast<const char *>(id), static_cast<size_t>(id_len)),
+                                  serialized, ConnectionTimer::clock()))
+        {
+            context.m_stats.cache_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        context.m_stats.cache_hits.fetch_add(1, std::memory_order_relaxed);
+
+        const auto *in = reinterpret_cast<const unsigned char *>(serialized.data());
+        return d2i_SSL_SESSION(nullptr, &in, static_cast<long>(serialized.size()));
+    }
+
+    static void onRemove(SSL_CTX *ctx, SSL_SESSION *session)
+    {
+        unsigned int id_len = 0;
+        const unsigned char *id = SSL_SESSION_get_id(session, &id_len);
+
+        static_cast<TlsContext *>(SSL_CTX_get_app_data(ctx))
+            ->m_cache->remove(std::string(reinterpret_cast<const char *>(id), id_len));
+    }
+};
+
+/* ----------------
+ * TlsContext
+ * ----------------
+ */
+
+TlsContext::TlsContext(const TlsConfig &config) : m_config(config)
+{
+    m_ctx = SSL_CTX_new(TLS_server_method());
+
+    if (m_ctx == nullptr)
+    {
+        throw std::runtime_error("Failed to create the TLS context: " + lastSslError());
+    }
+
+    SSL_CTX_set_min_proto_version(m_ctx, TLS1_2_VERSION);
+
+    if (SSL_CTX_use_certificate_chain_file(m_ctx, config.certificate_file.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(m_ctx, config.private_key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(m_ctx) != 1)
+    {
+        std::string error = lastSslError();
+        SSL_CTX_free(m_ctx);
+        throw std::runtime_error("Failed to load the TLS certificate " + config.certificate_file + ": " + error);
+    }
+
+    uint64_t options = SSL_OP_NO_RENEGOTIATION | SSL_OP_NO_COMPRESSION;
+
+    if (!config.session_tickets)
+    {
+        options |= SSL_OP_NO_TICKET;
+    }
+
+#ifndef PULSENET_KTLS
+    if (m_config.kernel_offload)
+    {
+        LoggerManager::get_logger()->write(SEVERITY::WARN, std::string("TLS kernel offload is not supported with ") +
+                                                               OPENSSL_VERSION_TEXT + ", encrypting in userspace");
+        m_config.kernel_offload = false;
+    }
+#endif
+
+    if (m_config.kernel_offload)
+    {
+        options |= SSL_OP_ENABLE_KTLS;
+    }
+    else
+    {
+        // Idle connections give their record buffers back
+        SSL_CTX_set_mode(m_ctx, SSL_MODE_RELEASE_BUFFERS);
+    }
+
+    SSL_CTX_set_options(m_ctx, options);
+    SSL_CTX_set_timeout(m_ctx, static_cast<long>(config.session_timeout_s));
+
+    static const unsigned char SESSION_ID_CONTEXT[] = "PulseNet";
+    SSL_CTX_set_session_id_context(m_ctx, SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_set_app_data(m_ctx, this);
+
+    if (config.session_cache_size > 0)
+    {
+        m_cache = std::make_unique<TlsSessionCache>(config.session_cache_size, config.session_timeout_s);
+
+        SSL_CTX_set_session_cache_mode(m_ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(m_ctx, TlsCacheCallbacks::onNew);
+        SSL_CTX_sess_set_get_cb(m_ctx, TlsCacheCallbacks::onGet);
+        SSL_CTX_sess_set_remove_cb(m_ctx, TlsCacheCallbacks::onRemove);
+    }
+    else
+    {
+        SSL_CTX_set_session_cache_mode(m_ctx, SSL_SESS_CACHE_OFF);
+    }
+}
+
+TlsContext::~TlsContext()
+{
+    SSL_CTX_free(m_ctx);
+}
+
+std::unique_ptr<TlsSession> TlsContext::createSession()
+{
+    SSL *ssl = SSL_new(m_ctx);
+
+    if (ssl == nullptr)
+    {
+        LoggerManager::get_logger()->write(SEVERITY::S_ERROR, "Failed to create a TLS session: " + lastSslError());
+        return nullptr;
+    }
+
+    return std::make_unique<OpenSslSession>(*this, ssl);
+}
+
+void TlsContext::reportOffloadFailure(const std::string &reason)
+{
+    m_stats.offload_failures.fetch_add(1, std::memory_order_relaxed);
+
+    if (!m_offload_failure_logged.exchange(true))
+    {
+        LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                           "TLS kernel offload unavailable, encrypting in userspace: " + reason);
+    }
+}
+
+} // namespace pulse::net
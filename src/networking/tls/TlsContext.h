@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../TlsSession.h"
+#include "../constants.h"
+#include "TlsSessionCache.h"
+
+struct ssl_ctx_st;
+
+namespace pulse::net
+{
+
+/**
+ * @struct TlsConfig
+ * @brief Certificate and resumption settings of a TlsContext.
+ */
+struct TlsConfig
+{
+    std::string certificate_file; ///< PEM certificate chain presented to clients
+    std::string private_key_file; ///< PEM private key of the certificate
+
+    /**
+     * @brief Whether sessions are resumed with tickets, sealed with keys of the
+     * context, so that no state is kept for them.
+     */
+    bool session_tickets{true};
+
+    /**
+     * @brief Sessions kept for the clients that resume by session id. 0
+     * disables the cache.
+     */
+    size_t session_cache_size{TLS_SESSION_CACHE_SIZE};
+
+    uint32_t session_timeout_s{TLS_SESSION_TIMEOUT_S}; ///< How long a session, or a ticket, may be resumed
+
+    /**
+     * @brief Whether the kernel takes the encryption over once the handshake
+     * is done (kTLS), where it supports the cipher. Linux with OpenSSL 3.0 or
+     * 3.1 only, as the keys are taken from OpenSSL the way it hands them to
+     * kTLS, which is internal to it.
+     */
+    bool kernel_offload{false};
+};
+
+/**
+ * @struct TlsStats
+ * @brief Handshakes of the sessions of a TlsContext, and how they went.
+ */
+struct TlsStats
+{
+    std::atomic<uint64_t> handshakes{0};         ///< Completed handshakes, full or resumed
+    std::atomic<uint64_t> resumed_handshakes{0}; ///< Completed by resuming a session or a ticket
+    std::atomic<uint64_t> failed_sessions{0};    ///< Connections closed on a TLS error
+    std::atomic<uint64_t> cache_hits{0};         ///< Sessions found in the cache by their id
+    std::atomic<uint64_t> cache_misses{0};       ///< Session ids not in the cache, or expired
+    std::atomic<uint64_t> offloaded_sessions{0}; ///< Sessions the kernel encrypts for
+    std::atomic<uint64_t> offload_failures{0};   ///< Sessions the kernel refused to encrypt for
+};
+
+/**
+ * @class TlsContext
+ * @brief Certificate, session cache and ticket keys shared by every TLS
+ * connection of one or several servers (see TCPServer::setTlsContext()), on
+ * top of OpenSSL.
+ *
+ * Sessions decrypt and encrypt in memory, fed by the engines like plaintext
+ * connections, so every engine supports TLS. When kernel offload is enabled,
+ * the keys of the sending direction are handed to the kernel once the
+ * handshake is done, and every byte sent from then on is written in
+ * plaintext, to be encrypted by the kernel.
+ */
+class TlsContext
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+
+    /**
+     * @throws std::runtime_error if the certificate or the key cannot be
+     * loaded.
+     */
+    explicit TlsContext(const TlsConfig &config);
+    ~TlsContext();
+
+    TlsContext(const TlsContext &context) = delete;
+    TlsContext &operator=(const TlsContext &context) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Creates the server side session of a connection just accepted.
+     */
+    std::unique_ptr<TlsSession> createSession();
+
+    const TlsConfig &getConfig() const
+    {
+        return m_config;
+    }
+
+    const TlsStats &getStats() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * @brief Counters of the sessions of the context. Updated by them.
+     */
+    TlsStats &stats()
+    {
+        return m_stats;
+    }
+
+    /**
+     * @brief Counts a session the kernel refused to encrypt for. Only the first
+     * refusal is logged, as the next ones likely have the same reason.
+     */
+    void reportOffloadFailure(const std::string &reason);
+
+  private:
+    TlsConfig m_config;
+    TlsStats m_stats{};
+
+    std::atomic<bool> m_offload_failure_logged{false};
+
+    std::unique_ptr<TlsSessionCache> m_cache;
+
+    ssl_ctx_st *m_ctx = nullptr;
+
+    /**
+     * @brief OpenSSL callbacks of the session cache, which find the context
+     * in the application data of the SSL_CTX.
+     */
+    friend struct TlsCacheCallbacks;
+};
+
+} // namespace pulse::net
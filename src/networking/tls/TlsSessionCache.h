@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "../constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @class TlsSessionCache
+ * @brief Sessions kept for resumption by their id, for the clients that do
+ * not resume with tickets.
+ *
+ * Sessions are stored serialized, keyed by their id, in TLS_SESSION_CACHE_SHARDS
+ * shards picked by the hash of the id, each behind its own lock, so that a
+ * storm of reconnections only contends per shard. Every shard holds up to
+ * its share of the capacity and evicts its oldest session to make room.
+ * Expired sessions are dropped when looked up or evicted.
+ *
+ * The caller passes the time, in milliseconds of any monotonic clock.
+ */
+class TlsSessionCache
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    TlsSessionCache(size_t capacity, uint32_t timeout_s) : m_timeout_ms(uint64_t(timeout_s) * 1000)
+    {
+        m_shard_capacity = std::max<size_t>(1, (capacity + TLS_SESSION_CACHE_SHARDS - 1) / TLS_SESSION_CACHE_SHARDS);
+    }
+
+    TlsSessionCache(const TlsSessionCache &cache) = delete;
+    TlsSessionCache &operator=(const TlsSessionCache &cache) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    void put(const std::string &id, std::string session, uint64_t now)
+    {
+        Shard &shard = shardOf(id);
+        std::lock_guard lock(shard.mtx);
+
+        uint64_t sequence = ++shard.sequence;
+        shard.sessions[id] = Entry{std::move(session), now + m_timeout_ms, sequence};
+        shard.order.emplace_back(id, sequence);
+
+        while (shard.sessions.size() > m_shard_capacity)
+        {
+            evictOldest(shard);
+        }
+
+        if (shard.order.size() > 2 * m_shard_capacity)
+        {
+            dropStaleOrder(shard);
+        }
+    }
+
+    /**
+     * @brief Copies the session stored under id.
+     *
+     * @return false if there is none, or it expired.
+     */
+    bool get(const std::string &id, std::string &session, uint64_t now)
+    {
+        Shard &shard = shardOf(id);
+        std::lock_guard lock(shard.mtx);
+
+        auto it = shard.sessions.find(id);
+
+        if (it == shard.sessions.end())
+        {
+            return false;
+        }
+
+        if (it->second.expires_ms <= now)
+        {
+            shard.sessions.erase(it);
+            return false;
+        }
+
+        session = it->second.session;
+        return true;
+    }
+
+    void remove(const std::string &id)
+    {
+        Shard &shard = shardOf(id);
+        std::lock_guard lock(shard.mtx);
+
+        shard.sessions.erase(id);
+    }
+
+    /**
+     * @brief Number of sessions stored, expired or not.
+     */
+    size_t size()
+    {
+        size_t total = 0;
+
+        for (Shard &shard : m_shards)
+        {
+            std::lock_guard lock(shard.mtx);
+            total += shard.sessions.size();
+        }
+
+        return total;
+    }
+
+  private:
+    struct Entry
+    {
+        std::string session;
+        uint64_t expires_ms = 0;
+
+        /**
+         * @brief Insertion the entry comes from, telling it apart from the
+         * older insertions of the same id still in the order.
+         */
+        uint64_t sequence = 0;
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> sessions;
+
+        /**
+         * @brief Ids in insertion order, with the sequence of their insertion.
+         * Ids removed or inserted again since stay until they reach the front.
+         */
+        std::deque<std::pair<std::string, uint64_t>> order;
+        uint64_t sequence = 0;
+    };
+
+    size_t m_shard_capacity = 1;
+    uint64_t m_timeout_ms;
+
+    Shard m_shards[TLS_SESSION_CACHE_SHARDS];
+
+    Shard &shardOf(const std::string &id)
+    {
+        return m_shards[std::hash<std::string>{}(id) % TLS_SESSION_CACHE_SHARDS];
+    }
+
+    void evictOldest(Shard &shard)
+    {
+        while (!shard.order.empty())
+        {
+            auto [id, sequence] = std::move(shard.order.front());
+            shard.order.pop_front();
+
+            auto it = shard.sessions.find(id);
+
+            if (it != shard.sessions.end() && it->second.sequence == sequence)
+            {
+                shard.sessions.erase(it);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Removes the ids of the order no longer stored with that
+     * sequence, so that removals do not make it grow without bound.
+     */
+    void dropStaleOrder(Shard &shard)
+    {
+        std::deque<std::pair<std::string, uint64_t>> order;
+
+        for (auto &[id, sequence] : shard.order)
+        {
+            auto it = shard.sessions.find(id);
+
+            if (it != shard.sessions.end() && it->second.sequence == sequence)
+            {
+                order.emplace_back(std::move(id), sequence);
+            }
+        }
+
+        shard.order.swap(order);
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <sys/epoll.h>
+
+#include "ReactorEngine.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct EpollReactor
+ * @brief Reactor waiting on its own epoll instance, where its listening sockets,
+ * its wake-up eventfd and the connections it accepted are registered.
+ */
+struct EpollReactor : Reactor
+{
+    int epoll_fd = -1;
+
+    /**
+     * @brief Connections removed from epoll during the current batch of
+     * events.
+     *
+     * Their reactor reference is released once the whole batch has been
+     * processed, since later events of the same batch may still point to
+     * them.
+     */
+    std::vector<Client *> closed;
+
+    ~EpollReactor()
+    {
+        if (epoll_fd >= 0)
+        {
+            close(epoll_fd);
+        }
+    }
+};
+
+/**
+ * @class EpollEngine
+ * @brief Readiness based I/O engine: every reactor thread runs an
+ * edge-triggered epoll loop.
+ */
+template <typename Handler>
+class EpollEngine : public ReactorEngine<Handler, EpollEngine<Handler>, EpollReactor>
+{
+    using Base = ReactorEngine<Handler, EpollEngine<Handler>, EpollReactor>;
+    friend Base;
+
+  public:
+    using Base::Base;
+
+  private:
+    using Base::m_config;
+    using Base::m_handler;
+    using Base::m_running;
+
+    /**
+     * @brief Creates a reactor with its epoll instance and wake-up eventfd, and
+     * registers the listening sockets and the eventfd in it.
+     *
+     * A listening socket shared by every reactor is registered with
+     * EPOLLEXCLUSIVE, so only one reactor is woken per connection.
+     */
+    std::unique_ptr<EpollReactor> createReactor(int id, int listen_fd, int unix_listen_fd)
+    {
+        auto reactor = std::make_unique<EpollReactor>();
+        reactor->id = id;
+        reactor->listen_fd = listen_fd;
+        reactor->unix_listen_fd = unix_listen_fd;
+        reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (reactor->epoll_fd < 0)
+        {
+            throw std::runtime_error("Failed to create epoll reactor: " + std::string(std::strerror(errno)));
+        }
+
+        Base::createWakeFd(*reactor);
+
+        epoll_event listener_event{};
+        listener_event.events = m_config.sharded_accept ? EPOLLIN : EPOLLIN | EPOLLEXCLUSIVE;
+        listener_event.data.ptr = nullptr;
+
+        epoll_event wake_event{};
+        wake_event.events = EPOLLIN;
+        wake_event.data.ptr = reactor.get();
+
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->listen_fd, &listener_event) < 0 ||
+            epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wake_fd, &wake_event) < 0)
+        {
+            throw std::runtime_error("Failed to register reactor descriptors: " + std::string(std::strerror(errno)));
+        }
+
+        if (unix_listen_fd >= 0)
+        {
+            epoll_event unix_event{};
+            unix_event.events = EPOLLIN | EPOLLEXCLUSIVE;
+            unix_event.data.ptr = &reactor->unix_listen_fd;
+
+            if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, unix_listen_fd, &unix_event) < 0)
+            {
+                throw std::runtime_error("Failed to register Unix socket: " + std::string(std::strerror(errno)));
+            }
+        }
+
+        return reactor;
+    }
+
+    /**
+     * @brief Event loop of a reactor thread.
+     *
+     * Connections are registered edge-triggered for both directions. Readable
+     * events are only acted upon while the client's receive is armed; the
+     * assembler worker re-arms it through postReceive(), and the reactor then
+     * reads immediately, so an edge missed while disarmed is never lost.
+     */
+    void reactorLoop(EpollReactor &reactor)
+    {
+        const int MAX_ENTRIES = 64;
+
+        epoll_event events[MAX_ENTRIES];
+
+        while (m_running)
+        {
+            // Requests posted by the reactor to itself are due without waiting
+            int timeout = reactor.local_pending.empty() ? reactor.timers.nextTimeout() : 0;
+            int ready = epoll_wait(reactor.epoll_fd, events, MAX_ENTRIES, timeout);
+            reactor.timers.update();
+
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                LoggerManager::get_logger()->write(SEVERITY::S_ERROR,
+                                                   "epoll_wait failed: " + std::string(std::strerror(errno)));
+                break;
+            }
+
+            for (int i = 0; i < ready; i++)
+            {
+                epoll_event &e = events[i];
+
+                if (e.data.ptr == nullptr) // New connection case
+                {
+                    acceptConnections(reactor, false);
+                }
+                else if (e.data.ptr == &reactor.unix_listen_fd) // New local connection
+                {
+                    acceptConnections(reactor, true);
+                }
+                else if (e.data.ptr == &reactor) // Requests posted by other threads
+                {
+                    Base::processPendingRequests(reactor);
+                }
+                else // Already existent connection
+                {
+                    Client *client = static_cast<Client *>(e.data.ptr);
+
+                    if (e.events & (EPOLLHUP | EPOLLERR))
+                    {
+                        closeConnection(reactor, *client);
+                        continue;
+                    }
+
+                    if (e.events & EPOLLOUT)
+                    {
+                        std::lock_guard lock(client->m_send_mtx);
+                        if (client->m_is_sending)
+                        {
+                            Base::flushOutboundQueue(*client);
+                        }
+                    }
+
+                    if (client->isDisconnecting())
+                    {
+                        closeConnection(reactor, *client);
+                    }
+                    else if ((e.events & (EPOLLIN | EPOLLRDHUP)) && client->m_recv_armed)
+                    {
+                        receive(reactor, *client);
+                    }
+                }
+            }
+
+            Base::processLocalRequests(reactor);
+            Base::expireConnections(reactor);
+
+            for (Client *client : reactor.closed)
+            {
+                m_handler.releaseClient(*client);
+            }
+
+            reactor.closed.clear();
+        }
+    }
+
+    /**
+     * @brief Accepts every pending connection of the TCP listening socket, or
+     * of the Unix domain socket, and registers it in the reactor.
+     *
+     * The reference taken by addClient() is kept by the reactor until the
+     * connection is removed from epoll.
+     */
+    void acceptConnections(EpollReactor &reactor, bool local)
+    {
+        while (m_running)
+        {
+            sockaddr_in remote_in{};
+            socklen_t remote_size = sizeof(remote_in);
+
+            int client_socket =
+                local ? accept4(reactor.unix_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)
+                      : accept4(reactor.listen_fd, reinterpret_cast<sockaddr *>(&remote_in), &remote_size,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (client_socket < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                                       "accept failed: " + std::string(std::strerror(errno)));
+                }
+                break;
+            }
+
+            Client *client;
+
+            if (local)
+            {
+                if ((client = Base::addLocalClient(client_socket)) == nullptr)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                std::pair<int, std::string> address = Base::getRemoteAddress(remote_in);
+
+                if ((client = m_handler.addClient(address.first, address.second, client_socket)) == nullptr)
+                {
+                    close(client_socket);
+                    continue;
+                }
+
+                applyConnectionOptions(client_socket, m_config.socket_options);
+            }
+
+            client->m_reactor = reactor.id;
+            client->m_recv_armed = true;
+
+            epoll_event client_event{};
+            client_event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            client_event.data.ptr = client;
+
+            reactor.clients.insert(client);
+            reactor.timers.add(*client);
+
+            if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, client_socket, &client_event) < 0)
+            {
+                LoggerManager::get_logger()->write(SEVERITY::WARN, "Failed to register client in epoll: " +
+                                                                       std::string(std::strerror(errno)));
+                reactor.clients.erase(client);
+                reactor.timers.remove(*client);
+                client->disconnect();
+                m_handler.releaseClient(*client);
+            }
+        }
+    }
+
+    /**
+     * @brief Reads available bytes into the client's receive buffer and hands
+     * them off to be assembled.
+     *
+     * A buffer is only attached for the read, and given back right away if
+     * there was nothing to read and nothing is left to assemble. After a
+     * successful read the receive stays disarmed, so the buffer is owned by the
+     * assembler until it posts the next receive.
+     */
+    void receive(EpollReactor &reactor, Client &client)
+    {
+        if (!client.hasRecvBuffer())
+        {
+            client.attachRecvBuffer(reactor.buffers);
+        }
+
+        // The assembler needs more room than the buffer has
+        if (client.m_recv_len == static_cast<int>(client.m_recv_capacity))
+        {
+            client.growRecvBuffer(reactor.buffers);
+        }
+
+        int free_space = static_cast<int>(client.m_recv_capacity) - client.m_recv_len;
+
+        if (free_space <= 0)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: receive buffer is full");
+            closeConnection(reactor, client);
+            return;
+        }
+
+        // Decrypted bytes that did not fit last time come before the socket
+        if (client.hasPendingInput())
+        {
+            client.m_recv_armed = false;
+            client.addBytesReceived(0);
+            m_handler.queueAssembling(client);
+            return;
+        }
+
+        ssize_t received = recv(client.getSocket(), client.m_recv_buffer + client.m_recv_len, free_space, 0);
+
+        if (received > 0)
+        {
+            reactor.timers.touch(client);
+            client.m_recv_armed = false;
+            client.addBytesReceived(static_cast<int>(received));
+            m_handler.queueAssembling(client);
+        }
+        else if (received == 0) // Client disconnected
+        {
+            closeConnection(reactor, client);
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "recv failed: " + std::string(std::strerror(errno)));
+            closeConnection(reactor, client);
+        }
+        else if (client.m_recv_len == 0)
+        {
+            client.releaseRecvBuffer();
+        }
+    }
+
+    void armReceive(EpollReactor &reactor, Client &client)
+    {
+        client.m_recv_armed = true;
+        receive(reactor, client);
+    }
+
+    /**
+     * @brief Nothing to do: edge-triggered EPOLLOUT already reports when a
+     * blocked socket becomes writable again.
+     */
+    void armWritable(EpollReactor & /*reactor*/, Client & /*client*/)
+    {
+    }
+
+    /**
+     * @brief Removes a connection from the reactor. The reactor's reference to
+     * it is released at the end of the current batch of events.
+     */
+    void closeConnection(EpollReactor &reactor, Client &client)
+    {
+        if (reactor.clients.erase(&client) == 0)
+        {
+            return;
+        }
+
+        epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, client.getSocket(), nullptr);
+        reactor.timers.remove(client);
+        client.disconnect();
+        reactor.closed.push_back(&client);
+    }
+
+    void closeConnections(EpollReactor &reactor)
+    {
+        Base::closeReactorConnections(reactor);
+
+        for (Client *client : reactor.closed)
+        {
+            m_handler.releaseClient(*client);
+        }
+
+        reactor.closed.clear();
+    }
+
+    void releaseResources(Client & /*client*/)
+    {
+    }
+};
+
+} // namespace pulse::net
@@ -0,0 +1,191 @@
+#include "IoUring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace pulse::net
+{
+
+IoUring::IoUring(unsigned entries)
+{
+    io_uring_params params{};
+
+    m_ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+    if (m_ring_fd < 0)
+    {
+        throw std::runtime_error("io_uring_setup failed: " + std::string(std::strerror(errno)));
+    }
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        m_cq_ring_size = m_sq_ring_size;
+    }
+
+    m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd,
+                     IORING_OFF_SQ_RING);
+
+    if (m_sq_ring == MAP_FAILED)
+    {
+        close(m_ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission queue");
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        m_cq_ring = m_sq_ring;
+    }
+    else
+    {
+        m_cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd,
+                         IORING_OFF_CQ_RING);
+
+        if (m_cq_ring == MAP_FAILED)
+        {
+            munmap(m_sq_ring, m_sq_ring_size);
+            close(m_ring_fd);
+            throw std::runtime_error("Failed to map io_uring completion queue");
+        }
+    }
+
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = static_cast<io_uring_sqe *>(
+        mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES));
+
+    if (m_sqes == MAP_FAILED)
+    {
+        if (m_cq_ring != m_sq_ring)
+        {
+            munmap(m_cq_ring, m_cq_ring_size);
+        }
+        munmap(m_sq_ring, m_sq_ring_size);
+        close(m_ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission entries");
+    }
+
+    char *sq = static_cast<char *>(m_sq_ring);
+    m_sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    m_sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sqe_tail = *m_sq_tail;
+
+    char *cq = static_cast<char *>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring()
+{
+    munmap(m_sqes, m_sqes_size);
+
+    if (m_cq_ring != m_sq_ring)
+    {
+        munmap(m_cq_ring, m_cq_ring_size);
+    }
+
+    munmap(m_sq_ring, m_sq_ring_size);
+    close(m_ring_fd);
+}
+
+io_uring_sqe *IoUring::getSqe()
+{
+    unsigned head = std::atomic_ref<unsigned>(*m_sq_head).load(std::memory_order_acquire);
+
+    if (m_sqe_tail - head >= m_sq_entries)
+    {
+        submitAndWait(0);
+        head = std::atomic_ref<unsigned>(*m_sq_head).load(std::memory_order_acquire);
+
+        if (m_sqe_tail - head >= m_sq_entries)
+        {
+            return nullptr;
+        }
+    }
+
+    unsigned index = m_sqe_tail & m_sq_mask;
+    m_sq_array[index] = index;
+    m_sqe_tail++;
+
+    io_uring_sqe *sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::submitAndWait(unsigned wait_nr, int timeout_ms)
+{
+    unsigned to_submit = flushSubmissions();
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    // The timeout is passed along with the wait, without a timeout operation
+    __kernel_timespec timeout{timeout_ms / 1000, static_cast<long long>(timeout_ms % 1000) * 1000000};
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<uint64_t>(&timeout);
+
+    void *enter_arg = nullptr;
+    size_t enter_arg_size = 0;
+
+    if (wait_nr > 0 && timeout_ms >= 0)
+    {
+        flags |= IORING_ENTER_EXT_ARG;
+        enter_arg = &arg;
+        enter_arg_size = sizeof(arg);
+    }
+
+    while (true)
+    {
+        int result = static_cast<int>(
+            syscall(__NR_io_uring_enter, m_ring_fd, to_submit, wait_nr, flags, enter_arg, enter_arg_size));
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        return result < 0 ? -errno : result;
+    }
+}
+
+bool IoUring::registerBuffer(void *address, size_t length)
+{
+    iovec buffer{address, length};
+
+    return syscall(__NR_io_uring_register, m_ring_fd, IORING_REGISTER_BUFFERS, &buffer, 1) == 0;
+}
+
+int IoUring::getFd() const
+{
+    return m_ring_fd;
+}
+
+unsigned IoUring::flushSubmissions()
+{
+    unsigned tail = *m_sq_tail;
+    unsigned pending = m_sqe_tail - tail;
+
+    if (pending > 0)
+    {
+        std::atomic_ref<unsigned>(*m_sq_tail).store(m_sqe_tail, std::memory_order_release);
+    }
+
+    // Entries published earlier but not consumed yet are submitted again
+    unsigned head = std::atomic_ref<unsigned>(*m_sq_head).load(std::memory_order_acquire);
+    return m_sqe_tail - head;
+}
+
+} // namespace pulse::net
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace pulse::net
+{
+
+/**
+ * @class IoUring
+ * @brief Minimal io_uring instance built directly on the kernel ABI.
+ *
+ * Owns the ring file descriptor and the mapped submission and completion
+ * queues. Only the operations needed by the server are exposed: getting a
+ * submission entry, submitting while waiting for completions, reaping every
+ * available completion in one batch and registering fixed buffers.
+ *
+ * @note Not thread-safe. A ring must only be used by the thread that owns it.
+ */
+class IoUring
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    IoUring(const IoUring &ring) = delete;
+    IoUring(IoUring &&ring) = delete;
+    IoUring &operator=(const IoUring &ring) = delete;
+    IoUring &operator=(IoUring &&ring) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Returns a zeroed submission entry, flushing the submission queue
+     * to the kernel first if it is full.
+     */
+    io_uring_sqe *getSqe();
+
+    /**
+     * @brief Submits every queued entry and waits until at least wait_nr
+     * completions are available, in a single io_uring_enter call.
+     *
+     * @param timeout_ms Longest wait in milliseconds, -1 for no limit.
+     *
+     * @return The number of submitted entries, or -errno on failure (-ETIME
+     * when the wait timed out).
+     */
+    int submitAndWait(unsigned wait_nr, int timeout_ms = -1);
+
+    /**
+     * @brief Calls handler for every completion currently in the completion
+     * queue and marks them as seen.
+     *
+     * @return The number of reaped completions.
+     */
+    template <typename Handler> unsigned forEachCompletion(Handler &&handler)
+    {
+        unsigned head = *m_cq_head;
+        unsigned tail = std::atomic_ref<unsigned>(*m_cq_tail).load(std::memory_order_acquire);
+        unsigned count = 0;
+
+        while (head != tail)
+        {
+            handler(m_cqes[head & m_cq_mask]);
+            head++;
+            count++;
+        }
+
+        std::atomic_ref<unsigned>(*m_cq_head).store(head, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Registers a single memory region as fixed buffer 0, so reads into
+     * it skip the per-operation page pinning.
+     *
+     * @return true on success. On failure the region can still be used with
+     * regular (non fixed) operations.
+     */
+    bool registerBuffer(void *address, size_t length);
+
+    int getFd() const;
+
+  private:
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    int m_ring_fd = -1;
+
+    void *m_sq_ring = nullptr;
+    void *m_cq_ring = nullptr;
+    size_t m_sq_ring_size = 0;
+    size_t m_cq_ring_size = 0;
+
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqes_size = 0;
+
+    unsigned *m_sq_head = nullptr;
+    unsigned *m_sq_tail = nullptr;
+    unsigned *m_sq_array = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned m_sq_entries = 0;
+
+    /**
+     * @brief Local tail of the submission queue. Entries between the shared
+     * tail and this one have been filled but not yet published to the kernel.
+     */
+    unsigned m_sqe_tail = 0;
+
+    unsigned *m_cq_head = nullptr;
+    unsigned *m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe *m_cqes = nullptr;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+    unsigned flushSubmissions();
+};
+
+} // namespace pulse::net
@@ -0,0 +1,609 @@
+#pragma once
+
+#include <poll.h>
+
+#include "IoUring.h"
+#include "ReactorEngine.h"
+
+namespace pulse::net
+{
+
+/**
+ * @struct IoUringReactor
+ * @brief Reactor owning a ring with multishot accepts on its listening sockets
+ * and a multishot poll on its wake-up eventfd.
+ *
+ * Also the source of the receive buffers carved from its registered region.
+ */
+struct IoUringReactor : Reactor, BufferSource
+{
+    std::unique_ptr<IoUring> ring;
+
+    /**
+     * @brief Region registered as fixed buffer 0 of the ring, split into
+     * IO_URING_REGISTERED_BUFFERS receive buffers of the client buffer length.
+     *
+     * Reads that start when every slot is taken get a buffer from the reactor
+     * pool instead, and are done with a regular recv.
+     */
+    std::unique_ptr<char[]> buffer_region;
+    size_t buffer_len = 0;
+    bool buffers_registered = false;
+
+    /**
+     * @brief Free slots of buffer_region. Slots are taken by the reactor thread
+     * and given back by the assembler worker that consumed their bytes, or by
+     * whichever thread terminates the client.
+     */
+    std::vector<int> free_buffers;
+    std::mutex buffers_mtx;
+
+    /**
+     * @brief Client operations in flight, each holding a reference to its
+     * client until it completes.
+     */
+    int client_operations = 0;
+
+    /**
+     * @brief Multishot accepts and wake-up poll that could not be submitted
+     * again, the submission queue being full. Retried on every loop iteration.
+     */
+    int accepts_to_rearm = 0;
+    int local_accepts_to_rearm = 0;
+    bool wake_poll_to_rearm = false;
+
+    bool ownsBuffer(const char *buffer) const
+    {
+        const char *region = buffer_region.get();
+        return buffer >= region && buffer < region + IO_URING_REGISTERED_BUFFERS * buffer_len;
+    }
+
+    void release(char *buffer, size_t /*size*/) override
+    {
+        std::lock_guard lock(buffers_mtx);
+        free_buffers.push_back(static_cast<int>((buffer - buffer_region.get()) / buffer_len));
+    }
+};
+
+/**
+ * @class IoUringEngine
+ * @brief Completion based I/O engine: every reactor thread submits and reaps
+ * operations on its own io_uring instance.
+ */
+template <typename Handler>
+class IoUringEngine : public ReactorEngine<Handler, IoUringEngine<Handler>, IoUringReactor>
+{
+    using Base = ReactorEngine<Handler, IoUringEngine<Handler>, IoUringReactor>;
+    friend Base;
+
+  public:
+    using Base::Base;
+
+  private:
+    using Base::m_config;
+    using Base::m_handler;
+    using Base::m_reactors;
+    using Base::m_running;
+
+    /**
+     * @brief Tags stored in the low bits of the io_uring user_data, next to the
+     * Client pointer (the completion key), to tell operations apart.
+     */
+    enum Operation : uint64_t
+    {
+        OP_ACCEPT = 1,
+        OP_WAKE = 2,
+        OP_RECEIVE = 3,
+        OP_WRITABLE = 4,
+        OP_CANCEL = 5,
+        OP_READABLE = 6,
+        OP_ACCEPT_LOCAL = 7
+    };
+
+    static constexpr uint64_t OPERATION_MASK = 7;
+
+    /**
+     * @brief Creates a reactor with its io_uring instance, wake-up eventfd and
+     * registered receive buffer region.
+     */
+    std::unique_ptr<IoUringReactor> createReactor(int id, int listen_fd, int unix_listen_fd)
+    {
+        auto reactor = std::make_unique<IoUringReactor>();
+        reactor->id = id;
+        reactor->listen_fd = listen_fd;
+        reactor->unix_listen_fd = unix_listen_fd;
+        reactor->ring = std::make_unique<IoUring>(IO_URING_ENTRIES);
+        Base::createWakeFd(*reactor);
+
+        reactor->buffer_len = m_config.client_buffer_len;
+        reactor->buffer_region = std::make_unique<char[]>(IO_URING_REGISTERED_BUFFERS * reactor->buffer_len);
+        reactor->buffers_registered = reactor->ring->registerBuffer(reactor->buffer_region.get(),
+                                                                    IO_URING_REGISTERED_BUFFERS * reactor->buffer_len);
+
+        if (!reactor->buffers_registered)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "Could not register io_uring receive buffers: " +
+                                                                   std::string(std::strerror(errno)));
+        }
+
+        reactor->free_buffers.reserve(IO_URING_REGISTERED_BUFFERS);
+        for (int i = IO_URING_REGISTERED_BUFFERS - 1; i >= 0; i--)
+        {
+            reactor->free_buffers.push_back(i);
+        }
+
+        for (int i = 0; i < m_config.accepts_per_listener; i++)
+        {
+            submitAccept(*reactor, false);
+
+            if (unix_listen_fd >= 0)
+            {
+                submitAccept(*reactor, true);
+            }
+        }
+
+        submitWakePoll(*reactor);
+
+        return reactor;
+    }
+
+    /**
+     * @brief Event loop of a reactor thread.
+     *
+     * Queued submissions are flushed in the same io_uring_enter call that waits
+     * for completions, and every available completion is then reaped in one
+     * batch and dispatched on the Client* completion key.
+     */
+    void reactorLoop(IoUringReactor &reactor)
+    {
+        while (m_running)
+        {
+            bool armed = rearmListeners(reactor);
+
+            // Requests posted by the reactor to itself are due without waiting
+            bool wait = reactor.local_pending.empty();
+            int timeout = wait ? reactor.timers.nextTimeout() : -1;
+
+            // Until its accepts and wake-up poll are back, the reactor does not sleep for long
+            if (!armed && (timeout < 0 || timeout > IO_URING_REARM_RETRY_MS))
+            {
+                timeout = IO_URING_REARM_RETRY_MS;
+            }
+
+            int result = reactor.ring->submitAndWait(wait ? 1 : 0, timeout);
+            reactor.timers.update();
+
+            if (result < 0 && result != -EBUSY && result != -ETIME)
+            {
+                LoggerManager::get_logger()->write(SEVERITY::S_ERROR,
+                                                   "io_uring_enter failed: " + std::string(std::strerror(-result)));
+                break;
+            }
+
+            reactor.ring->forEachCompletion([this, &reactor](io_uring_cqe &cqe) { handleCompletion(reactor, cqe); });
+            Base::processLocalRequests(reactor);
+            Base::expireConnections(reactor);
+        }
+    }
+
+    void handleCompletion(IoUringReactor &reactor, io_uring_cqe &cqe)
+    {
+        Operation operation = static_cast<Operation>(cqe.user_data & OPERATION_MASK);
+        Client *client = reinterpret_cast<Client *>(cqe.user_data & ~OPERATION_MASK);
+
+        switch (operation)
+        {
+        case OP_ACCEPT: // New connection case
+        case OP_ACCEPT_LOCAL:
+            if (cqe.res >= 0 && !m_running) // Accepted while the engine stops
+            {
+                close(cqe.res);
+            }
+            else if (cqe.res >= 0)
+            {
+                registerConnection(reactor, cqe.res, operation == OP_ACCEPT_LOCAL);
+            }
+            else if (cqe.res != -ECANCELED)
+            {
+                LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                                   "accept failed: " + std::string(std::strerror(-cqe.res)));
+            }
+
+            if (!(cqe.flags & IORING_CQE_F_MORE) && m_running)
+            {
+                submitAccept(reactor, operation == OP_ACCEPT_LOCAL);
+            }
+            break;
+
+        case OP_WAKE:
+            Base::processPendingRequests(reactor);
+
+            if (!(cqe.flags & IORING_CQE_F_MORE) && m_running)
+            {
+                submitWakePoll(reactor);
+            }
+            break;
+
+        case OP_READABLE:
+            reactor.client_operations--;
+            client->m_recv_armed = false;
+
+            if (cqe.res >= 0 && reactor.clients.contains(client))
+            {
+                attachRecvBuffer(reactor, *client);
+                armReceive(reactor, *client);
+            }
+            else if (cqe.res < 0 && cqe.res != -ECANCELED)
+            {
+                closeConnection(reactor, *client);
+            }
+
+            m_handler.releaseClient(*client);
+            break;
+
+        case OP_RECEIVE:
+            reactor.client_operations--;
+            client->m_recv_armed = false;
+
+            if (cqe.res > 0)
+            {
+                reactor.timers.touch(*client);
+                client->addBytesReceived(cqe.res);
+                m_handler.queueAssembling(*client);
+            }
+            else if ((cqe.res == -EAGAIN || cqe.res == -EINTR) && reactor.clients.contains(client))
+            {
+                if (client->m_recv_len == 0)
+                {
+                    client->releaseRecvBuffer();
+                }
+
+                armReceive(reactor, *client);
+            }
+            else if (cqe.res != -ECANCELED) // Client disconnected or failed
+            {
+                closeConnection(reactor, *client);
+            }
+
+            m_handler.releaseClient(*client);
+            break;
+
+        case OP_WRITABLE: {
+            reactor.client_operations--;
+            bool would_block = false;
+            if (cqe.res >= 0)
+            {
+                std::lock_guard lock(client->m_send_mtx);
+                if (client->m_is_sending)
+                {
+                    would_block = Base::flushOutboundQueue(*client);
+                }
+            }
+
+            if (would_block && reactor.clients.contains(client))
+            {
+                armWritable(reactor, *client);
+            }
+
+            m_handler.releaseClient(*client);
+            break;
+        }
+
+        case OP_CANCEL:
+            break;
+        }
+    }
+
+    /**
+     * @brief Registers a socket accepted from the TCP listening socket, or from
+     * the Unix domain socket, as a client of the reactor and arms its first
+     * receive.
+     *
+     * The reference taken by addClient() is kept by the reactor until the
+     * connection is closed.
+     */
+    void registerConnection(IoUringReactor &reactor, int client_socket, bool local)
+    {
+        Client *client;
+
+        if (local)
+        {
+            if ((client = Base::addLocalClient(client_socket)) == nullptr)
+            {
+                return;
+            }
+        }
+        else
+        {
+            sockaddr_in remote_in{};
+            socklen_t remote_size = sizeof(remote_in);
+            getpeername(client_socket, reinterpret_cast<sockaddr *>(&remote_in), &remote_size);
+
+            std::pair<int, std::string> address = Base::getRemoteAddress(remote_in);
+
+            if ((client = m_handler.addClient(address.first, address.second, client_socket)) == nullptr)
+            {
+                close(client_socket);
+                return;
+            }
+
+            applyConnectionOptions(client_socket, m_config.socket_options);
+        }
+
+        client->m_reactor = reactor.id;
+
+        reactor.clients.insert(client);
+        reactor.timers.add(*client);
+        armReceive(reactor, *client);
+    }
+
+    /**
+     * @brief Submits a read into the free part of the client's buffer.
+     *
+     * A client without a buffer (nothing left to assemble) gets a one-shot
+     * POLLIN instead, and a buffer is only attached once the socket is
+     * readable, so idle connections hold no buffer.
+     *
+     * Buffers carved from the registered region are read with READ_FIXED, so the
+     * kernel copies straight into the assembler buffer without pinning pages
+     * for every operation. A reference is held until the completion.
+     */
+    void armReceive(IoUringReactor &reactor, Client &client)
+    {
+        if (!client.hasRecvBuffer())
+        {
+            armReadable(reactor, client);
+            return;
+        }
+
+        // The assembler needs more room than the buffer has
+        if (client.m_recv_len == static_cast<int>(client.m_recv_capacity))
+        {
+            client.growRecvBuffer(reactor.buffers);
+        }
+
+        int free_space = static_cast<int>(client.m_recv_capacity) - client.m_recv_len;
+
+        if (free_space <= 0)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: receive buffer is full");
+            closeConnection(reactor, client);
+            return;
+        }
+
+        // Decrypted bytes that did not fit last time come before the socket
+        if (client.hasPendingInput())
+        {
+            client.m_recv_armed = false;
+            client.addBytesReceived(0);
+            m_handler.queueAssembling(client);
+            return;
+        }
+
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe == nullptr)
+        {
+            closeConnection(reactor, client);
+            return;
+        }
+
+        bool fixed = reactor.buffers_registered && reactor.ownsBuffer(client.m_recv_buffer);
+
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_RECV;
+        sqe->fd = client.getSocket();
+        sqe->addr = reinterpret_cast<uint64_t>(client.m_recv_buffer + client.m_recv_len);
+        sqe->len = static_cast<uint32_t>(free_space);
+        sqe->buf_index = 0;
+        sqe->user_data = reinterpret_cast<uint64_t>(&client) | OP_RECEIVE;
+
+        client.m_recv_armed = true;
+        client.increaseReferenceCount();
+        reactor.client_operations++;
+    }
+
+    void armReadable(IoUringReactor &reactor, Client &client)
+    {
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe == nullptr)
+        {
+            closeConnection(reactor, client);
+            return;
+        }
+
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = client.getSocket();
+        sqe->poll32_events = POLLIN | POLLRDHUP;
+        sqe->user_data = reinterpret_cast<uint64_t>(&client) | OP_READABLE;
+
+        client.m_recv_armed = true;
+        client.increaseReferenceCount();
+        reactor.client_operations++;
+    }
+
+    /**
+     * @brief Lends a slot of the registered region to a client about to read,
+     * or a buffer of the reactor pool if every slot is taken or the client
+     * reads with a resized buffer.
+     */
+    void attachRecvBuffer(IoUringReactor &reactor, Client &client)
+    {
+        std::unique_lock lock(reactor.buffers_mtx);
+
+        if (reactor.free_buffers.empty() || client.m_recv_buffer_len != reactor.buffer_len)
+        {
+            lock.unlock();
+            client.attachRecvBuffer(reactor.buffers);
+            return;
+        }
+
+        char *buffer = reactor.buffer_region.get() + reactor.free_buffers.back() * reactor.buffer_len;
+        reactor.free_buffers.pop_back();
+
+        client.attachRecvBuffer(buffer, reactor.buffer_len, reactor);
+    }
+
+    /**
+     * @brief Submits a one-shot POLLOUT, so a blocked outbound queue is flushed
+     * once the socket has room again.
+     */
+    void armWritable(IoUringReactor &reactor, Client &client)
+    {
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe == nullptr)
+        {
+            closeConnection(reactor, client);
+            return;
+        }
+
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = client.getSocket();
+        sqe->poll32_events = POLLOUT;
+        sqe->user_data = reinterpret_cast<uint64_t>(&client) | OP_WRITABLE;
+
+        client.increaseReferenceCount();
+        reactor.client_operations++;
+    }
+
+    /**
+     * @brief Submits a multishot accept on the TCP listening socket, or on the
+     * Unix domain socket. It keeps producing one completion per connection
+     * until the kernel terminates it, and is then submitted again, so
+     * accepts_per_listener stay in flight on each of them.
+     */
+    void submitAccept(IoUringReactor &reactor, bool local)
+    {
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe == nullptr)
+        {
+            (local ? reactor.local_accepts_to_rearm : reactor.accepts_to_rearm)++;
+            return;
+        }
+
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = local ? reactor.unix_listen_fd : reactor.listen_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        sqe->user_data = local ? OP_ACCEPT_LOCAL : OP_ACCEPT;
+    }
+
+    /**
+     * @brief Submits a multishot poll on the wake-up eventfd.
+     */
+    void submitWakePoll(IoUringReactor &reactor)
+    {
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe == nullptr)
+        {
+            reactor.wake_poll_to_rearm = true;
+            return;
+        }
+
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = reactor.wake_fd;
+        sqe->poll32_events = POLLIN;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->user_data = OP_WAKE;
+    }
+
+    /**
+     * @brief Submits again the accepts and the wake-up poll that did not fit
+     * in the submission queue.
+     *
+     * Without a wake-up poll, the requests posted by other threads are
+     * processed here instead, on every loop iteration.
+     *
+     * @return true if every accept and the wake-up poll are in flight.
+     */
+    bool rearmListeners(IoUringReactor &reactor)
+    {
+        for (int pending = std::exchange(reactor.accepts_to_rearm, 0); pending > 0; pending--)
+        {
+            submitAccept(reactor, false);
+        }
+
+        for (int pending = std::exchange(reactor.local_accepts_to_rearm, 0); pending > 0; pending--)
+        {
+            submitAccept(reactor, true);
+        }
+
+        if (std::exchange(reactor.wake_poll_to_rearm, false))
+        {
+            Base::processPendingRequests(reactor);
+            submitWakePoll(reactor);
+        }
+
+        return reactor.accepts_to_rearm == 0 && reactor.local_accepts_to_rearm == 0 && !reactor.wake_poll_to_rearm;
+    }
+
+    /**
+     * @brief Removes a connection from the reactor, cancels its in-flight
+     * operations and releases the reactor's reference to it.
+     *
+     * Cancelled operations still complete and release their own references, so
+     * the client is only terminated once nothing in the ring points to it.
+     */
+    void closeConnection(IoUringReactor &reactor, Client &client)
+    {
+        if (reactor.clients.erase(&client) == 0)
+        {
+            return;
+        }
+
+        reactor.timers.remove(client);
+
+        io_uring_sqe *sqe = reactor.ring->getSqe();
+
+        if (sqe != nullptr)
+        {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = client.getSocket();
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = OP_CANCEL;
+        }
+
+        client.disconnect();
+        m_handler.releaseClient(client);
+    }
+
+    /**
+     * @brief Closes the connections of a reactor whose thread has exited, then
+     * reaps the completions of their cancelled operations, so every reference
+     * they held is released.
+     */
+    void closeConnections(IoUringReactor &reactor)
+    {
+        Base::closeReactorConnections(reactor);
+
+        while (reactor.client_operations > 0)
+        {
+            int result = reactor.ring->submitAndWait(1, IO_URING_DRAIN_TIMEOUT_MS);
+
+            if (result < 0 && result != -EBUSY && result != -EINTR)
+            {
+                LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                                   std::to_string(reactor.client_operations) +
+                                                       " io_uring operations did not complete on stop: " +
+                                                       std::string(std::strerror(-result)));
+                break;
+            }
+
+            reactor.ring->forEachCompletion([this, &reactor](io_uring_cqe &cqe) { handleCompletion(reactor, cqe); });
+        }
+    }
+
+    /**
+     * @brief Nothing to do: the receive buffer goes back to its source
+     * through the client.
+     */
+    void releaseResources(Client & /*client*/)
+    {
+    }
+};
+
+} // namespace pulse::net
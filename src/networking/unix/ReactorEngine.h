@@ -0,0 +1,823 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <csignal>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "../BufferPool.h"
+#include "../Client.h"
+#include "../ConnectionTimer.h"
+#include "../IoEngine.h"
+#include "../LoggerManager.h"
+#include "../constants.h"
+
+namespace pulse::net
+{
+
+/**
+ * @brief Requests other threads post to the reactor owning a connection.
+ */
+enum class ReactorRequest
+{
+    RECEIVE,
+    WAIT_WRITABLE,
+    CLOSE
+};
+
+/**
+ * @struct Reactor
+ * @brief Event loop state of one Linux I/O thread, shared by the epoll and
+ * io_uring engines. Backends extend it with their own descriptors.
+ *
+ * Accepted connections stay on the same reactor for their whole lifetime.
+ */
+struct Reactor
+{
+    int id = -1;
+    int wake_fd = -1;
+    std::thread thread;
+
+    /**
+     * @brief Listening socket the reactor accepts from: the socket shared by
+     * every reactor, or its own SO_REUSEPORT shard. Owned by the engine.
+     */
+    int listen_fd = -1;
+
+    /**
+     * @brief Unix domain socket shared by every reactor, -1 without one. Owned
+     * by the engine.
+     */
+    int unix_listen_fd = -1;
+
+    /**
+     * @brief Connections owned by this reactor.
+     *
+     * Each entry holds one reference to the client, released when the
+     * connection is closed. Only accessed by the reactor thread.
+     */
+    std::unordered_set<Client *> clients;
+
+    /**
+     * @brief Requests posted by assembler workers and senders.
+     *
+     * Each entry holds one reference to the client, released once the
+     * reactor has processed it.
+     */
+    std::vector<std::pair<Client *, ReactorRequest>> pending;
+    std::mutex pending_mtx;
+
+    /**
+     * @brief Requests posted by the reactor thread itself, from a request
+     * handler running to completion on it.
+     *
+     * Processed after the current batch of events, without locking nor
+     * waking the reactor up. Only accessed by the reactor thread.
+     */
+    std::vector<std::pair<Client *, ReactorRequest>> local_pending;
+
+    /**
+     * @brief Receive buffers lent to the connections of this reactor while
+     * they have bytes to read or to assemble.
+     */
+    BufferPool buffers;
+
+    /**
+     * @brief Timeouts of the connections of this reactor. Only accessed by
+     * the reactor thread.
+     */
+    ConnectionTimer timers;
+
+    Reactor() = default;
+    Reactor(const Reactor &reactor) = delete;
+    Reactor &operator=(const Reactor &reactor) = delete;
+
+    ~Reactor()
+    {
+        if (wake_fd >= 0)
+        {
+            close(wake_fd);
+        }
+    }
+};
+
+/**
+ * @class ReactorEngine
+ * @brief Common part of the Linux I/O engines: listening socket, reactor
+ * threads, cross-thread requests and outbound queue flushing.
+ *
+ * Derived engines (CRTP) provide createReactor(), reactorLoop(), armReceive(),
+ * armWritable(), closeConnection(), closeConnections() and releaseResources(),
+ * all called on the concrete type.
+ *
+ * Either every reactor accepts from one shared listening socket, or, with
+ * sharded accept, each reactor binds its own listening socket to the same
+ * address with SO_REUSEPORT and the kernel load balances connections across
+ * their accept queues. A Unix domain socket, if configured, is always shared.
+ *
+ * @tparam Handler The server owning the engine (see ValidIoEngine).
+ * @tparam Derived The concrete engine.
+ * @tparam ReactorType The reactor state of the concrete engine.
+ */
+template <typename Handler, typename Derived, typename ReactorType> class ReactorEngine
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit ReactorEngine(Handler &handler) : m_handler(handler)
+    {
+    }
+
+    ReactorEngine(const ReactorEngine &engine) = delete;
+    ReactorEngine(ReactorEngine &&engine) = delete;
+    ReactorEngine &operator=(const ReactorEngine &engine) = delete;
+    ReactorEngine &operator=(ReactorEngine &&engine) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Sets the number of reactor threads. Must be called before start().
+     */
+    void setIoThreads(int threads)
+    {
+        if (threads < 1)
+        {
+            throw std::invalid_argument("I/O threads should be at least 1");
+        }
+
+        m_io_threads = threads;
+    }
+
+    /**
+     * @brief Creates the listening socket and starts the reactor threads.
+     */
+    void start(const IoEngineConfig &config)
+    {
+        if (m_running)
+        {
+            return;
+        }
+
+        if (config.backlog < 1)
+        {
+            throw std::invalid_argument("Listen backlog should be at least 1");
+        }
+
+        m_config = config;
+        m_config.accepts_per_listener = std::clamp(m_config.accepts_per_listener, 1, MAX_ACCEPTS_PER_LISTENER);
+
+        try
+        {
+            int shared_socket = m_config.sharded_accept ? -1 : createListener();
+            int unix_socket = m_config.unix_path.empty() ? -1 : createUnixListener();
+
+            for (int i = 0; i < m_io_threads; i++)
+            {
+                int listen_fd = m_config.sharded_accept ? createListener() : shared_socket;
+                m_reactors.push_back(derived().createReactor(i, listen_fd, unix_socket));
+                m_reactors.back()->timers.configure(m_config.timeouts);
+            }
+        }
+        catch (...)
+        {
+            closeListeners();
+            m_reactors.clear();
+            throw;
+        }
+
+        m_running = true;
+        m_placed_threads.assign(m_reactors.size(), PlacedThread{});
+
+        // Reactors are placed before they allocate their receive buffers
+        std::latch placed(static_cast<std::ptrdiff_t>(m_reactors.size()));
+
+        for (auto &reactor : m_reactors)
+        {
+            ReactorType *r = reactor.get();
+            r->thread = std::thread([this, r, &placed]() {
+                m_placed_threads[r->id] = placeCurrentThread(m_config.placement, r->id);
+                placed.count_down();
+
+                t_current_reactor = r;
+                derived().reactorLoop(*r);
+            });
+        }
+
+        placed.wait();
+    }
+
+    void stop()
+    {
+        if (!m_running.exchange(false))
+        {
+            return;
+        }
+
+        for (auto &reactor : m_reactors)
+        {
+            wakeReactor(*reactor);
+        }
+
+        // Reactors stay allocated, as workers may still post requests to them
+        for (auto &reactor : m_reactors)
+        {
+            if (reactor->thread.joinable())
+            {
+                reactor->thread.join();
+            }
+        }
+
+        // Connections left open are closed from here, once their reactor is gone
+        for (auto &reactor : m_reactors)
+        {
+            derived().closeConnections(*reactor);
+        }
+
+        closeListeners();
+    }
+
+    /**
+     * @brief Re-arms the receive of a client on its reactor.
+     *
+     * Counterpart of the IOCP WSARecv post: the reactor starts reading into the
+     * client buffer again once it processes the request.
+     */
+    void postReceive(Client &client)
+    {
+        postReactorRequest(client, ReactorRequest::RECEIVE);
+    }
+
+    /**
+     * @brief Writes the outbound queue of a client from a worker thread, asking
+     * its reactor to resume once the socket is writable if it would block.
+     *
+     * @note Must be called with client.m_send_mtx held.
+     */
+    void postSend(Client &client)
+    {
+        if (flushOutboundQueue(client))
+        {
+            postReactorRequest(client, ReactorRequest::WAIT_WRITABLE);
+        }
+    }
+
+    void postClose(Client &client)
+    {
+        postReactorRequest(client, ReactorRequest::CLOSE);
+    }
+
+    void releaseConnection(Client &client)
+    {
+        CLOSE_SOCKET(client.getSocket());
+        derived().releaseResources(client);
+    }
+
+    const std::vector<AppliedSocketOption> &getAppliedSocketOptions() const
+    {
+        return m_applied_socket_options;
+    }
+
+    const std::vector<PlacedThread> &getPlacedThreads() const
+    {
+        return m_placed_threads;
+    }
+
+  protected:
+    /* ----------------
+     * Protected attributes
+     * ----------------
+     */
+    Handler &m_handler;
+
+    IoEngineConfig m_config{};
+
+    /**
+     * @brief Every listening socket created by the engine: the shared one, or
+     * one per reactor with sharded accept, and the Unix domain socket.
+     */
+    std::vector<SOCKET_TYPE> m_listen_sockets;
+
+    /**
+     * @brief Whether the socket file of the Unix domain socket was created,
+     * and has to be removed once it is closed.
+     */
+    bool m_unix_path_bound = false;
+
+    /**
+     * @brief Socket options as set on the first listening socket. Every
+     * listening socket gets the same ones.
+     */
+    std::vector<AppliedSocketOption> m_applied_socket_options;
+
+    /**
+     * @brief Where every reactor thread runs, indexed by reactor id.
+     */
+    std::vector<PlacedThread> m_placed_threads;
+
+    std::atomic<bool> m_running = false;
+
+    std::vector<std::unique_ptr<ReactorType>> m_reactors;
+
+    int m_io_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    /**
+     * @brief Reactor run by the calling thread, if it is a reactor thread.
+     */
+    static inline thread_local Reactor *t_current_reactor = nullptr;
+
+    /* ----------------
+     * Protected methods
+     * ----------------
+     */
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+
+    /**
+     * @brief Creates the eventfd used to wake a reactor up.
+     */
+    static void createWakeFd(Reactor &reactor)
+    {
+        reactor.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (reactor.wake_fd < 0)
+        {
+            throw std::runtime_error("Failed to create reactor eventfd: " + std::string(std::strerror(errno)));
+        }
+    }
+
+    /**
+     * @brief Wakes the reactor up, so it processes its pending requests.
+     */
+    void wakeReactor(Reactor &reactor)
+    {
+        uint64_t value = 1;
+        ssize_t r = write(reactor.wake_fd, &value, sizeof(value));
+        (void)r;
+    }
+
+    /**
+     * @brief Queues a request for the reactor that owns the client.
+     *
+     * A reference to the client is held until the reactor has processed the
+     * request. Requests the reactor posts to itself skip the lock and the
+     * wake-up. Once the engine is stopped, requests are dropped: the
+     * connections have been closed already.
+     */
+    void postReactorRequest(Client &client, ReactorRequest request)
+    {
+        Reactor &reactor = *m_reactors[client.m_reactor];
+
+        if (t_current_reactor == &reactor)
+        {
+            client.increaseReferenceCount();
+            reactor.local_pending.emplace_back(&client, request);
+            return;
+        }
+
+        {
+            std::lock_guard lock(reactor.pending_mtx);
+
+            // Checked under the lock, so closeReactorConnections() sees every queued request
+            if (!m_running)
+            {
+                return;
+            }
+
+            client.increaseReferenceCount();
+            reactor.pending.emplace_back(&client, request);
+        }
+
+        wakeReactor(reactor);
+    }
+
+    void processPendingRequests(ReactorType &reactor)
+    {
+        uint64_t value;
+        ssize_t r = read(reactor.wake_fd, &value, sizeof(value));
+        (void)r;
+
+        std::vector<std::pair<Client *, ReactorRequest>> pending;
+        {
+            std::lock_guard lock(reactor.pending_mtx);
+            pending.swap(reactor.pending);
+        }
+
+        processRequests(reactor, pending);
+    }
+
+    /**
+     * @brief Processes the requests the reactor posted to itself. The ones
+     * posted meanwhile wait for the next batch of events, which the reactor
+     * then polls for without blocking.
+     */
+    void processLocalRequests(ReactorType &reactor)
+    {
+        if (reactor.local_pending.empty())
+        {
+            return;
+        }
+
+        std::vector<std::pair<Client *, ReactorRequest>> pending;
+        pending.swap(reactor.local_pending);
+
+        processRequests(reactor, pending);
+    }
+
+    void processRequests(ReactorType &reactor, std::vector<std::pair<Client *, ReactorRequest>> &pending)
+    {
+        for (auto &[client, request] : pending)
+        {
+            if (reactor.clients.contains(client))
+            {
+                if (client->isDisconnecting() || request == ReactorRequest::CLOSE)
+                {
+                    derived().closeConnection(reactor, *client);
+                }
+                else if (request == ReactorRequest::RECEIVE)
+                {
+                    derived().armReceive(reactor, *client);
+                }
+                else if (request == ReactorRequest::WAIT_WRITABLE)
+                {
+                    derived().armWritable(reactor, *client);
+                }
+            }
+
+            m_handler.releaseClient(*client);
+        }
+    }
+
+    /**
+     * @brief Closes every connection of a reactor whose thread has exited, and
+     * releases the references held by the requests it did not process.
+     *
+     * Clients still referenced elsewhere, like by a task assembling them, are
+     * terminated once released.
+     */
+    void closeReactorConnections(ReactorType &reactor)
+    {
+        while (!reactor.clients.empty())
+        {
+            derived().closeConnection(reactor, **reactor.clients.begin());
+        }
+
+        processLocalRequests(reactor);
+        processPendingRequests(reactor);
+    }
+
+    /**
+     * @brief Closes the connections of the reactor that timed out. Called once
+     * per batch of events, after it has been handled.
+     */
+    void expireConnections(ReactorType &reactor)
+    {
+        reactor.timers.expire([this, &reactor](Client &client, const char *timeout) {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: " + timeout + " timeout");
+            derived().closeConnection(reactor, client);
+        });
+    }
+
+    /**
+     * @brief Writes queued outbound messages until the queue is empty or the
+     * socket would block.
+     *
+     * Every sendmsg gathers as many queued messages as the send batch limits
+     * allow, so a client with many small pending responses costs one syscall
+     * instead of one per message. A partial write advances the offsets and the
+     * rest is gathered again. With the cork socket option, every batch but the
+     * last is sent with MSG_MORE. File ranges are written with sendfile, from
+     * the page cache to the socket, once the bytes before them are written.
+     *
+     * When the socket would block, m_is_sending stays true and the owning
+     * reactor resumes flushing once the socket is writable again. The time it
+     * started waiting is stamped for the write timeout.
+     *
+     * @note Must be called with client.m_send_mtx held.
+     *
+     * @return true if the socket would block.
+     */
+    bool flushOutboundQueue(Client &client)
+    {
+        client.m_is_sending = true;
+
+        while (client.hasOutbound())
+        {
+            ssize_t sent;
+            OutboundFileSegment file;
+
+            if (client.frontFile(file))
+            {
+                sent = sendFile(client.getSocket(), file);
+            }
+            else
+            {
+                iovec segments[MAX_SEND_BATCH_SEGMENTS];
+                msghdr msg{};
+                msg.msg_iov = segments;
+                size_t batch_bytes = 0;
+                auto add_segment = [&msg, &batch_bytes](const char *data, size_t len) {
+                    msg.msg_iov[msg.msg_iovlen++] = iovec{const_cast<char *>(data), len};
+                    batch_bytes += len;
+                };
+
+                client.gatherOutbound(m_config.send_batch_bytes, m_config.send_batch_segments, add_segment);
+
+                int flags = MSG_NOSIGNAL;
+
+                // More is queued than the batch holds, so the kernel may wait for it to fill segments
+                if (m_config.socket_options.cork && batch_bytes < client.getPendingOutboundBytes())
+                {
+                    flags |= MSG_MORE;
+                }
+
+                sent = batch_bytes > 0 ? sendmsg(client.getSocket(), &msg, flags) : 0;
+            }
+
+            // Nothing to write while bytes are left: a file was cut short
+            if (sent == 0)
+            {
+                LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                                   "Client " + std::to_string(client.getId()) +
+                                                       " disconnected: outbound file could not be read");
+                client.disconnect();
+                postClose(client);
+                break;
+            }
+
+            if (sent < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    if (client.m_send_blocked_since.load(std::memory_order_relaxed) == 0)
+                    {
+                        client.m_send_blocked_since.store(ConnectionTimer::clock(), std::memory_order_release);
+                    }
+
+                    return true;
+                }
+
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                LoggerManager::get_logger()->write(SEVERITY::WARN, "send failed: " + std::string(std::strerror(errno)));
+                client.disconnect();
+                postClose(client);
+                break;
+            }
+
+            client.consumeOutbound(static_cast<size_t>(sent));
+            client.m_last_send_ms.store(ConnectionTimer::clock(), std::memory_order_relaxed);
+            client.m_send_blocked_since.store(0, std::memory_order_release);
+        }
+
+        client.m_is_sending = false;
+        return false;
+    }
+
+    /**
+     * @brief Writes file bytes with sendfile, which has no MSG_NOSIGNAL: the
+     * SIGPIPE a closed connection raises is blocked, and taken back if it was
+     * raised, so that the process is not killed.
+     */
+    static ssize_t sendFile(int sock, const OutboundFileSegment &file)
+    {
+        sigset_t pipe_signal;
+        sigset_t previous;
+        sigemptyset(&pipe_signal);
+        sigaddset(&pipe_signal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe_signal, &previous);
+
+        off_t offset = static_cast<off_t>(file.offset);
+        size_t len = static_cast<size_t>(std::min<uint64_t>(file.length, FILE_SEND_CHUNK_BYTES));
+        ssize_t sent = sendfile(sock, file.file->native(), &offset, len);
+        int error = errno;
+
+        if (sent < 0 && error == EPIPE)
+        {
+            timespec no_wait{};
+            sigtimedwait(&pipe_signal, nullptr, &no_wait);
+        }
+
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        errno = error;
+        return sent;
+    }
+
+    /**
+     * @brief Registers a connection accepted from the Unix domain socket with
+     * the server, by the credentials of its process. The socket options of the
+     * configuration are TCP ones, and are not set on it.
+     *
+     * @return The client, or nullptr if its credentials could not be read or
+     * the server refused it, in which case the socket is closed.
+     */
+    Client *addLocalClient(int sock)
+    {
+        ucred credentials{};
+        socklen_t credentials_size = sizeof(credentials);
+
+        // Default credentials would read as root
+        if (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &credentials, &credentials_size) != 0)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "Could not read the credentials of a local client: " +
+                                                                   std::string(std::strerror(errno)));
+            close(sock);
+            return nullptr;
+        }
+
+        PeerCredentials peer{credentials.pid, credentials.uid, credentials.gid};
+        Client *client = m_handler.addClient(0, "", sock, peer);
+
+        if (client == nullptr)
+        {
+            close(sock);
+        }
+
+        return client;
+    }
+
+    /**
+     * @brief Gets the ip address and port of an accepted socket.
+     */
+    static std::pair<int, std::string> getRemoteAddress(const sockaddr_in &remote_in)
+    {
+        char client_ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &(remote_in.sin_addr), client_ip, INET_ADDRSTRLEN);
+
+        return {ntohs(remote_in.sin_port), client_ip};
+    }
+
+  private:
+    /**
+     * @brief Creates a non-blocking listening socket bound to the server
+     * address. With sharded accept, SO_REUSEPORT lets every reactor bind its
+     * own socket to the same address.
+     */
+    int createListener()
+    {
+        int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+
+        if (listen_fd < 0)
+        {
+            throw std::runtime_error("Error when creating socket! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port));
+        }
+
+        m_listen_sockets.push_back(listen_fd);
+
+        int reuse = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (m_config.sharded_accept && setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0)
+        {
+            throw std::runtime_error("Error enabling SO_REUSEPORT: " + std::string(std::strerror(errno)));
+        }
+
+        // Set before listen(), so the window scale offered matches the buffers
+        std::vector<AppliedSocketOption> applied = applyListenerOptions(listen_fd, m_config.socket_options);
+
+        if (m_listen_sockets.size() == 1)
+        {
+            m_applied_socket_options = std::move(applied);
+        }
+
+        int bindResult =
+            bind(listen_fd, reinterpret_cast<const sockaddr *>(&m_config.address), sizeof(m_config.address));
+        if (bindResult < 0)
+        {
+            throw std::runtime_error("Binding socket failed! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port) + ")");
+        }
+
+        if (listen(listen_fd, m_config.backlog) < 0)
+        {
+            throw std::runtime_error("Error trying to listen the socket! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port));
+        }
+
+        return listen_fd;
+    }
+
+    /**
+     * @brief Creates the non-blocking Unix domain socket local clients connect
+     * to, at the configured path and with the configured permissions.
+     *
+     * A socket file already at the path is removed first, unless a server
+     * still accepts on it, in which case binding fails.
+     */
+    int createUnixListener()
+    {
+        const std::string &path = m_config.unix_path;
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Unix socket path is too long: " + path);
+        }
+
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+        if (listen_fd < 0)
+        {
+            throw std::runtime_error("Error when creating Unix socket! (path: " + path + ")");
+        }
+
+        m_listen_sockets.push_back(listen_fd);
+
+        struct stat info{};
+
+        if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+        {
+            int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            bool in_use =
+                probe >= 0 && connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+
+            if (probe >= 0)
+            {
+                close(probe);
+            }
+
+            if (!in_use)
+            {
+                unlink(path.c_str());
+            }
+        }
+
+        if (bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            throw std::runtime_error("Binding Unix socket failed! (path: " + path +
+                                     "): " + std::string(std::strerror(errno)));
+        }
+
+        m_unix_path_bound = true;
+
+        if (chmod(path.c_str(), static_cast<mode_t>(m_config.unix_mode)) < 0)
+        {
+            throw std::runtime_error("Error setting the permissions of the Unix socket! (path: " + path +
+                                     "): " + std::string(std::strerror(errno)));
+        }
+
+        if (listen(listen_fd, m_config.backlog) < 0)
+        {
+            throw std::runtime_error("Error trying to listen the Unix socket! (path: " + path + ")");
+        }
+
+        return listen_fd;
+    }
+
+    /**
+     * @brief Closes every listening socket, and removes the socket file of the
+     * Unix domain socket.
+     */
+    void closeListeners()
+    {
+        for (SOCKET_TYPE listen_fd : m_listen_sockets)
+        {
+            close(listen_fd);
+        }
+
+        m_listen_sockets.clear();
+
+        if (m_unix_path_bound)
+        {
+            unlink(m_config.unix_path.c_str());
+            m_unix_path_bound = false;
+        }
+    }
+};
+
+} // namespace pulse::net
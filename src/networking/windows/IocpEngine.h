@@ -0,0 +1,862 @@
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#define NOMINMAX
+
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../BufferPool.h"
+#include "../Client.h"
+#include "../ConnectionTimer.h"
+#include "../IoEngine.h"
+#include "../LoggerManager.h"
+#include "../constants.h"
+
+// clang-format off
+
+#include <Wsrm.h>
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <mswsock.h>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+// clang-format on
+
+namespace pulse::net
+{
+
+/**
+ * @class IocpEngine
+ * @brief Completion based I/O engine for Windows: AcceptEx, WSARecv and WSASend
+ * completions are dispatched by a single listener thread through an I/O
+ * Completion Port.
+ *
+ * @note Sharded accept is not supported, as Winsock has no SO_REUSEPORT load
+ * balancing. Accept throughput is raised with several AcceptEx in flight
+ * (accepts_per_listener) on the single listening socket instead.
+ *
+ * @note Unix domain sockets are not supported: Winsock has AF_UNIX, but no
+ * peer credentials to identify local clients with.
+ */
+template <typename Handler> class IocpEngine
+{
+  public:
+    /* ----------------
+     * Constructors
+     * ----------------
+     */
+    explicit IocpEngine(Handler &handler) : m_handler(handler)
+    {
+    }
+
+    IocpEngine(const IocpEngine &engine) = delete;
+    IocpEngine(IocpEngine &&engine) = delete;
+    IocpEngine &operator=(const IocpEngine &engine) = delete;
+    IocpEngine &operator=(IocpEngine &&engine) = delete;
+
+    /* ----------------
+     * Public methods
+     * ----------------
+     */
+
+    /**
+     * @brief Not used: completions are dispatched by a single listener thread.
+     */
+    void setIoThreads(int threads)
+    {
+        if (threads < 1)
+        {
+            throw std::invalid_argument("I/O threads should be at least 1");
+        }
+    }
+
+    void start(const IoEngineConfig &config)
+    {
+        if (m_running)
+        {
+            return;
+        }
+
+        if (!config.unix_path.empty())
+        {
+            throw std::invalid_argument("Unix domain sockets are not supported by the IOCP engine");
+        }
+
+        m_config = config;
+        m_timers.configure(m_config.timeouts);
+        setupSocket();
+
+        GUID guid = WSAID_ACCEPTEX;
+        DWORD bytes;
+        int res = WSAIoctl(m_server_socket, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), &acceptEx,
+                           sizeof(acceptEx), &bytes, NULL, NULL);
+
+        if (res == SOCKET_ERROR)
+        {
+            throw std::runtime_error("Error getting acceptEx ptr");
+        }
+
+        if (listen(m_server_socket, m_config.backlog) == SOCKET_ERROR)
+        {
+            throw std::runtime_error("Error trying to listen the socket! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port));
+        }
+
+        iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+
+        if (iocp == NULL)
+        {
+            throw std::runtime_error("Failed to create IOCP");
+        }
+
+        HANDLE result = CreateIoCompletionPort(reinterpret_cast<HANDLE>(m_server_socket), iocp, 0, 0);
+
+        if (result == NULL)
+        {
+            throw std::runtime_error("Failed to associate server socket with IOCP");
+        }
+
+        int accepts = std::clamp(m_config.accepts_per_listener, 1, MAX_ACCEPTS_PER_LISTENER);
+        m_running = true;
+
+        for (int i = 0; i < accepts; i++)
+        {
+            m_accept_contexts.push_back(std::make_unique<AcceptContext>());
+            bool success = postAcceptExEvent(*m_accept_contexts.back());
+
+            if (success)
+            {
+                m_pending_accepts.fetch_add(1);
+            }
+        }
+
+        if (m_pending_accepts == 0)
+        {
+            closeSocket();
+            throw std::runtime_error("Error executing first acceptEX" + std::to_string(WSAGetLastError()));
+        }
+
+        m_placed_threads.assign(1, PlacedThread{});
+        std::latch placed(1);
+
+        m_listener_thread = std::thread([this, &placed]() {
+            m_placed_threads[0] = placeCurrentThread(m_config.placement, 0);
+            placed.count_down();
+
+            const int MAX_ENTRIES = 64;
+
+            OVERLAPPED_ENTRY overlapped_entries[MAX_ENTRIES];
+
+            ULONG removed = 0;
+
+            while (m_running)
+            {
+                DWORD timeout = INFINITE;
+                {
+                    std::lock_guard lock(m_timers_mtx);
+                    int next = m_timers.nextTimeout();
+                    timeout = next < 0 ? INFINITE : static_cast<DWORD>(next);
+                }
+
+                removed = 0;
+                BOOL ok = GetQueuedCompletionStatusEx(iocp, overlapped_entries, MAX_ENTRIES, &removed, timeout, FALSE);
+
+                {
+                    std::lock_guard lock(m_timers_mtx);
+                    m_timers.update();
+                }
+
+                for (ULONG i = 0; i < removed; i++)
+                {
+                    OVERLAPPED_ENTRY &e = overlapped_entries[i];
+
+                    // Wake-up posted by stop()
+                    if (e.lpOverlapped == NULL)
+                    {
+                        continue;
+                    }
+
+                    // New connection case (the listening socket has no completion key)
+                    if (e.lpCompletionKey == 0)
+                    {
+                        AcceptContext *accept_ctx = CONTAINING_RECORD(e.lpOverlapped, AcceptContext, overlapped);
+                        m_pending_accepts.fetch_sub(1);
+
+                        setsockopt(accept_ctx->client_socket, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
+                                   (char *)&m_server_socket, sizeof(m_server_socket));
+                        applyConnectionOptions(accept_ctx->client_socket, m_config.socket_options);
+
+                        std::pair<int, std::string> address = getRemoteAddressFromAcceptContext(*accept_ctx);
+
+                        Client *client =
+                            m_handler.addClient(address.first, address.second, accept_ctx->client_socket);
+
+                        if (client == nullptr)
+                        {
+                            closesocket(accept_ctx->client_socket);
+                        }
+                        else
+                        {
+                            CreateIoCompletionPort(reinterpret_cast<HANDLE>(accept_ctx->client_socket), iocp,
+                                                   reinterpret_cast<ULONG_PTR>(client), 0);
+
+                            {
+                                std::lock_guard lock(m_timers_mtx);
+                                m_timers.add(*client);
+                                m_connections.insert(client);
+                            }
+
+                            client->increaseReferenceCount();
+                            postReceiveEvent(*client);
+                            client->decreaseReferenceCount();
+
+                            client->decreaseReferenceCount();
+
+                            if (client->isDisconnecting() && client->getReferenceCount() == 0)
+                            {
+                                m_handler.terminateClient(client->getId());
+                            }
+                        }
+
+                        // Keep listening, reusing the context of the completed accept
+                        bool success = postAcceptExEvent(*accept_ctx);
+                        if (success)
+                        {
+                            m_pending_accepts.fetch_add(1);
+                        }
+                    }
+                    else // Already existent connection
+                    {
+
+                        Client *client = reinterpret_cast<Client *>(e.lpCompletionKey);
+                        client->decreaseReferenceCount();
+
+                        if (client->isDisconnecting() && client->getReferenceCount() == 0)
+                        {
+                            m_handler.terminateClient(client->getId());
+                        }
+                        else
+                        {
+
+                            if (e.lpOverlapped == client->getReadOverlapped()) // Read case
+                            {
+
+                                if (client->m_recv_probe) // Readable: attach a buffer and read for real
+                                {
+                                    client->m_recv_probe = false;
+                                    client->attachRecvBuffer(m_buffers);
+                                    postReceiveEvent(*client);
+                                }
+                                else if (e.dwNumberOfBytesTransferred == 0) // Client disconnected
+                                {
+                                    client->disconnect();
+
+                                    if (client->getReferenceCount() == 0)
+                                    {
+                                        m_handler.terminateClient(client->getId());
+                                    }
+                                }
+                                else
+                                {
+                                    client->m_last_receive_ms = m_timers.now();
+                                    client->addBytesReceived(static_cast<int>(e.dwNumberOfBytesTransferred));
+                                    m_handler.queueAssembling(*client);
+                                }
+                            }
+                            else if (e.lpOverlapped == client->getSendOverlapped())
+                            {
+                                std::lock_guard lock(client->m_send_mtx);
+                                client->m_send_pinned = 0;
+                                client->consumeOutbound(e.dwNumberOfBytesTransferred);
+                                client->m_last_send_ms.store(ConnectionTimer::clock(), std::memory_order_relaxed);
+                                client->m_send_blocked_since.store(0, std::memory_order_release);
+
+                                // Nothing was written while bytes were left: a file was cut short
+                                if (e.dwNumberOfBytesTransferred == 0)
+                                {
+                                    client->m_is_sending = false;
+                                    client->disconnect();
+                                }
+                                else if (client->hasOutbound())
+                                {
+                                    client->increaseReferenceCount();
+                                    postSendEvent(*client);
+                                    client->decreaseReferenceCount();
+
+                                    if (client->isDisconnecting() && client->getReferenceCount() == 0)
+                                    {
+                                        m_handler.terminateClient(client->getId());
+                                    }
+                                }
+                                else
+                                {
+                                    client->m_is_sending = false;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                expireConnections();
+            }
+        });
+
+        placed.wait();
+    }
+
+    void stop()
+    {
+        if (!m_running.exchange(false))
+        {
+            return;
+        }
+
+        PostQueuedCompletionStatus(iocp, 0, 0, NULL);
+
+        if (m_listener_thread.joinable())
+        {
+            m_listener_thread.join();
+        }
+
+        closeConnections();
+        closeSocket();
+    }
+
+    void postReceive(Client &client)
+    {
+        postReceiveEvent(client);
+    }
+
+    /**
+     * @note Must be called with client.m_send_mtx held.
+     */
+    void postSend(Client &client)
+    {
+        postSendEvent(client);
+    }
+
+    /**
+     * @brief Cancels the pending operations of a client being disconnected,
+     * as a stuck send or an idle receive may otherwise never complete. Their
+     * completions release the client like any failed operation.
+     */
+    void postClose(Client &client)
+    {
+        CancelIoEx(reinterpret_cast<HANDLE>(client.getSocket()), NULL);
+    }
+
+    void releaseConnection(Client &client)
+    {
+        {
+            std::lock_guard lock(m_timers_mtx);
+            m_timers.remove(client);
+            m_connections.erase(&client);
+        }
+
+        CLOSE_SOCKET(client.getSocket());
+    }
+
+    const std::vector<AppliedSocketOption> &getAppliedSocketOptions() const
+    {
+        return m_applied_socket_options;
+    }
+
+    /**
+     * @brief Where the listener thread runs, the only I/O thread of the
+     * engine.
+     */
+    const std::vector<PlacedThread> &getPlacedThreads() const
+    {
+        return m_placed_threads;
+    }
+
+  private:
+    /* ----------------
+     * Private attributes
+     * ----------------
+     */
+    Handler &m_handler;
+
+    IoEngineConfig m_config{};
+
+    std::atomic<bool> m_running = false;
+
+    /**
+     * @brief Background thread that dispatches the completions of the IOCP.
+     */
+    std::thread m_listener_thread;
+
+    SOCKET_TYPE m_server_socket = NULL;
+
+    /**
+     * @brief Socket options as set on the listening socket, which accepted
+     * sockets inherit through SO_UPDATE_ACCEPT_CONTEXT.
+     */
+    std::vector<AppliedSocketOption> m_applied_socket_options;
+
+    std::vector<PlacedThread> m_placed_threads;
+
+    /**
+     * @struct AcceptContext
+     * @brief Context structure for Windows overlapped I/O accept operations.
+     *
+     * This structure encapsulates the necessary data for asynchronous socket
+     * acceptance on Windows platforms using I/O Completion Ports (IOCP).
+     *
+     * @note Windows-specific: Only compiled when _WIN32 is defined.
+     */
+    struct AcceptContext
+    {
+        OVERLAPPED overlapped;
+        SOCKET client_socket;
+        char rcv_buffer[4096]; // TODO: PARAMETRIZE THIS
+    };
+
+    /**
+     * @brief Accept contexts of the AcceptEx operations kept in flight, one per
+     * accepts_per_listener.
+     *
+     * A context is reused for the next AcceptEx once its accept completes, so
+     * they live until the engine is destroyed.
+     */
+    std::vector<std::unique_ptr<AcceptContext>> m_accept_contexts;
+
+    /**
+     * @brief Atomic counter tracking the number of pending asynchronous accept
+     * operations.
+     *
+     * Maintains a count of AcceptEx calls that have been initiated but not yet
+     * completed. This is used to ensure proper cleanup during shutdown (wait for
+     * pending operations):
+     *
+     * The counter is incremented when AcceptEx is called and decremented when:
+     * - An accept operation completes successfully
+     * - An accept operation fails
+     * - An operation is cancelled during shutdown
+     *
+     * @note Atomic to ensure thread-safety when accessed from both the listener
+     *       thread and I/O completion port worker threads.
+     *
+     * @note On Windows with IOCP, multiple AcceptEx operations may be pending
+     *       simultaneously to improve connection acceptance throughput.
+     */
+    std::atomic<int> m_pending_accepts = 0;
+
+    HANDLE iocp;
+
+    LPFN_ACCEPTEX acceptEx = nullptr;
+
+    /**
+     * @brief Receive buffers, only attached while a read completes and its
+     * bytes are assembled.
+     */
+    BufferPool m_buffers;
+
+    /**
+     * @brief Timeouts of every connection, expired by the listener thread.
+     * Locked as clients are terminated, and leave the wheel, on any thread.
+     */
+    ConnectionTimer m_timers;
+    std::mutex m_timers_mtx;
+
+    /**
+     * @brief Connections accepted and not released yet, closed by stop().
+     * Locked with m_timers_mtx.
+     */
+    std::unordered_set<Client *> m_connections;
+
+    /* ----------------
+     * Private methods
+     * ----------------
+     */
+
+    /**
+     * @brief Cancels the pending operations of the connections that timed
+     * out. Their completions release the client like any failed operation.
+     */
+    void expireConnections()
+    {
+        std::lock_guard lock(m_timers_mtx);
+
+        m_timers.expire([](Client &client, const char *timeout) {
+            LoggerManager::get_logger()->write(SEVERITY::INFO, "Client " + std::to_string(client.getId()) +
+                                                                   " disconnected: " + timeout + " timeout");
+            client.disconnect();
+            CancelIoEx(reinterpret_cast<HANDLE>(client.getSocket()), NULL);
+        });
+    }
+
+    /**
+     * @brief Disconnects the connections left open once the listener thread
+     * is gone and cancels their pending operations.
+     *
+     * Their completions are reaped here, until none arrives for
+     * IOCP_DRAIN_TIMEOUT_MS, and release their references. Clients still
+     * referenced elsewhere, like by a task assembling them, are terminated once
+     * released.
+     */
+    void closeConnections()
+    {
+        {
+            std::lock_guard lock(m_timers_mtx);
+
+            for (Client *client : m_connections)
+            {
+                client->disconnect();
+                CancelIoEx(reinterpret_cast<HANDLE>(client->getSocket()), NULL);
+            }
+        }
+
+        const int MAX_ENTRIES = 64;
+        OVERLAPPED_ENTRY overlapped_entries[MAX_ENTRIES];
+        ULONG removed = 0;
+
+        while (GetQueuedCompletionStatusEx(iocp, overlapped_entries, MAX_ENTRIES, &removed, IOCP_DRAIN_TIMEOUT_MS,
+                                           FALSE))
+        {
+            for (ULONG i = 0; i < removed; i++)
+            {
+                OVERLAPPED_ENTRY &e = overlapped_entries[i];
+
+                // Wake-ups and accepts hold no client
+                if (e.lpOverlapped == NULL || e.lpCompletionKey == 0)
+                {
+                    continue;
+                }
+
+                Client *client = reinterpret_cast<Client *>(e.lpCompletionKey);
+
+                if (e.lpOverlapped == client->getSendOverlapped())
+                {
+                    std::lock_guard lock(client->m_send_mtx);
+                    client->m_send_pinned = 0;
+                    client->m_is_sending = false;
+                }
+
+                if (client->decreaseReferenceCount() == 0)
+                {
+                    m_handler.terminateClient(client->getId());
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Creates the network socket
+     */
+    void setupSocket()
+    {
+        WSADATA wsaData;
+
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        {
+            throw std::runtime_error("WSAStartup failed!");
+        }
+
+        m_server_socket = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+
+        if (m_server_socket == INVALID_SOCKET)
+        {
+            WSACleanup();
+            throw std::runtime_error("Error when creating socket! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port));
+        }
+
+        m_applied_socket_options = applyListenerOptions(m_server_socket, m_config.socket_options);
+
+        int bindResult = bind(m_server_socket, (struct sockaddr *)&m_config.address, sizeof(m_config.address));
+        if (bindResult == SOCKET_ERROR)
+        {
+            closeSocket();
+            throw std::runtime_error("Binding socket failed! (ip: " + m_config.ip_address +
+                                     ", port: " + std::to_string(m_config.port) + ")");
+        }
+    }
+
+    /**
+     * @brief Posts an asynchronous AcceptEx operation to accept incoming client
+     * connections.
+     *
+     * This function initiates an overlapped accept operation using the Windows
+     * AcceptEx API, which allows the server to accept incoming client
+     * connections asynchronously through the I/O Completion Port (IOCP)
+     * associated with the server socket. The AcceptEx function pointer is
+     * retrieved once using a static lambda and cached for subsequent calls to
+     * avoid repeated WSAIoctl overhead.
+     *
+     * @param accept_context Reference to an AcceptContext structure that will
+     * be populated with the client socket and overlapped I/O information. This
+     * context must remain valid until the accept operation completes and is
+     *                       processed by the IOCP worker thread.
+     *
+     * @return true if the AcceptEx operation was successfully posted (either
+     * completed immediately or is pending), false otherwise
+     *
+     * @note Prerequisites:
+     *       - m_server_socket must be initialized, valid, and associated with
+     * an IOCP
+     *       - The accept_context parameter must remain valid until the
+     * operation completes
+     *
+     * @note The function creates a new client socket (TCP/IPv4) and stores it
+     * in accept_context. If the operation fails, the client socket is
+     * automatically closed and set to INVALID_SOCKET.
+     *
+     * @note The AcceptEx call is configured with:
+     *       - No initial receive data (0 bytes)
+     *       - Address buffers sized at sizeof(m_config.address) + 16 bytes each
+     * for local and remote addresses (the +16 is required by AcceptEx for
+     * internal metadata)
+     *       - Overlapped I/O for asynchronous operation
+     *
+     * @note Error cases that return false:
+     *       - Server socket is NULL
+     *       - AcceptEx function pointer retrieval fails (SOCKET_ERROR)
+     *       - AcceptEx call fails with an error other than WSA_IO_PENDING
+     *
+     * @note On success, the completion notification will be posted to the IOCP
+     * associated with m_server_socket, where it should be handled by calling
+     * GetAcceptExSockaddrs to extract the client and server addresses.
+
+     * @see MSDN documentation for AcceptEx and overlapped I/O operations
+     */
+
+    bool postAcceptExEvent(AcceptContext &accept_context)
+    {
+
+        if (m_server_socket == NULL)
+        {
+            LoggerManager::get_logger()->write(SEVERITY::WARN,
+                                               "Tried to post an accept event to IOCP, but the server socket "
+                                               "is not set");
+            return false;
+        }
+
+        DWORD bytes_accept = 0;
+        SOCKET client_socket = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+
+        accept_context.client_socket = client_socket;
+
+        ZeroMemory(&accept_context.overlapped, sizeof(accept_context.overlapped));
+
+        BOOL acceptEx_result =
+            acceptEx(m_server_socket, client_socket, accept_context.rcv_buffer, 0, sizeof(m_config.address) + 16,
+                     sizeof(m_config.address) + 16, &bytes_accept, &accept_context.overlapped);
+
+        if (!acceptEx_result && WSAGetLastError() != WSA_IO_PENDING)
+        {
+            int error_code = WSAGetLastError();
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "AcceptEx failed with error code: " + error_code);
+
+            closesocket(accept_context.client_socket);
+            accept_context.client_socket = INVALID_SOCKET;
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    /**
+     * @brief Extracts the remote client's IP address and port from an AcceptEx
+     * context
+     *
+     * This function parses the address information stored in the AcceptContext
+     * buffer after an AcceptEx operation completes. It uses
+     * GetAcceptExSockaddrs to retrieve both local and remote socket addresses,
+     * then extracts the client's IP and port.
+     *
+     * @param accept_context Reference to the AcceptContext containing the
+     * address buffer populated by AcceptEx
+     *
+     * @return std::pair<int, std::string> A pair containing:
+     *         - first: The client's port number (in host byte order)
+     *         - second: The client's IP address as a string (IPv4 format)
+     *
+     * @note This function assumes IPv4 addresses (AF_INET)
+     * @note The AcceptContext's rcv_buffer must have been properly initialized
+     *       and filled by a successful AcceptEx call
+     */
+    std::pair<int, std::string> getRemoteAddressFromAcceptContext(AcceptContext &accept_context)
+    {
+        sockaddr_in remote_in{};
+
+        int remote_size = sizeof(remote_in);
+
+        int r = getpeername(accept_context.client_socket, reinterpret_cast<sockaddr *>(&remote_in), &remote_size);
+
+        char client_ip[INET_ADDRSTRLEN];
+        DWORD client_port;
+
+        inet_ntop(AF_INET, &(remote_in.sin_addr), client_ip, INET_ADDRSTRLEN);
+        client_port = ntohs(remote_in.sin_port);
+
+        return {client_port, client_ip};
+    }
+
+    /**
+     * @brief Posts an asynchronous receive operation for a connected client
+     *
+     * Initiates an overlapped WSARecv operation to receive data from the client
+     * socket. The operation completes asynchronously and will be handled by the
+     * I/O completion port.
+     *
+     * @param client Reference to the Client object whose socket will receive
+     * data
+     *
+     * @return true if the receive operation was successfully posted (or is
+     * pending)
+     * @return false if WSARecv failed with an error other than WSA_IO_PENDING
+     *
+     * @note The function returns true even when WSA_IO_PENDING is returned by
+     * WSARecv, as this indicates the operation was successfully queued
+     * @note Errors are logged to the Logger instance with NETWORK type and
+     * ERROR severity
+     * @note The client's read overlapped structure is zeroed before use
+     */
+    void postReceiveEvent(Client &client)
+    {
+
+        bool error = false;
+
+        DWORD flags = 0;
+        DWORD bytes_received = 0;
+        WSABUF wsa_buf{};
+
+        // Without a buffer, a zero-byte read waits for the socket to be
+        // readable, so idle connections hold no receive buffer
+        if (client.hasRecvBuffer())
+        {
+            // The assembler needs more room than the buffer has
+            if (client.m_recv_len == static_cast<int>(client.m_recv_capacity))
+            {
+                client.growRecvBuffer(m_buffers);
+            }
+
+            // Decrypted bytes that did not fit last time come before the socket
+            if (client.hasPendingInput())
+            {
+                client.addBytesReceived(0);
+                m_handler.queueAssembling(client);
+                return;
+            }
+
+            wsa_buf.buf = client.m_recv_buffer + client.m_recv_len;
+            wsa_buf.len = static_cast<ULONG>(client.m_recv_capacity - client.m_recv_len);
+        }
+        else
+        {
+            client.m_recv_probe = true;
+        }
+
+        OVERLAPPED *read_overlapped = client.getReadOverlapped();
+        ZeroMemory(read_overlapped, sizeof(*read_overlapped));
+
+        // TODO: This can end immediately if it already has data, we need to manage
+        // pushing to queue and recursive call.
+        int result = WSARecv(client.getSocket(), &wsa_buf, 1, &bytes_received, &flags, read_overlapped, NULL);
+
+        if (result == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING)
+        {
+            int error_code = WSAGetLastError();
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "WSARecv failed with error code: " + error_code);
+            error = true;
+        }
+
+        else
+        {
+            client.increaseReferenceCount();
+        }
+
+        if (error)
+        {
+            client.disconnect();
+        }
+    }
+
+    /**
+     * @brief Posts one overlapped WSASend gathering as much of the outbound
+     * queue as the send batch limits allow.
+     *
+     * Winsock captures the WSABUF array when the call returns, and the buffers
+     * themselves stay alive in the queue until the completion, which consumes
+     * the bytes actually transferred.
+     */
+    void postSendEvent(Client &client)
+    {
+        DWORD bytesSent = 0;
+        DWORD flags = 0;
+
+        WSABUF wsa_bufs[MAX_SEND_BATCH_SEGMENTS];
+        DWORD buf_count = 0;
+        auto add_buf = [&wsa_bufs, &buf_count](const char *data, size_t len) {
+            wsa_bufs[buf_count].buf = const_cast<char *>(data);
+            wsa_bufs[buf_count].len = static_cast<ULONG>(len);
+            buf_count++;
+        };
+
+        OVERLAPPED *send_overlapped = client.getSendOverlapped();
+        ZeroMemory(send_overlapped, sizeof(*send_overlapped));
+
+        OutboundFileSegment file;
+        int result;
+
+        // File ranges go from the file to the socket, at the offset of the overlapped
+        if (client.frontFile(file))
+        {
+            send_overlapped->Offset = static_cast<DWORD>(file.offset);
+            send_overlapped->OffsetHigh = static_cast<DWORD>(file.offset >> 32);
+            DWORD len = static_cast<DWORD>(std::min<uint64_t>(file.length, FILE_SEND_CHUNK_BYTES));
+
+            result = TransmitFile(client.getSocket(), file.file->native(), len, 0, send_overlapped, NULL, 0)
+                         ? 0
+                         : SOCKET_ERROR;
+        }
+        else
+        {
+            client.gatherOutbound(m_config.send_batch_bytes, m_config.send_batch_segments, add_buf);
+            result = WSASend(client.getSocket(), wsa_bufs, buf_count, &bytesSent, flags, send_overlapped, NULL);
+        }
+
+        if (result == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING)
+        {
+            int error_code = WSAGetLastError();
+            LoggerManager::get_logger()->write(SEVERITY::WARN, "WSASend failed with error code: " + error_code);
+            client.disconnect();
+        }
+        else
+        {
+            // The gathered messages must stay queued until the completion
+            client.m_send_pinned = client.m_outbound_message_queue.size();
+            client.m_is_sending = true;
+            client.m_send_blocked_since.store(ConnectionTimer::clock(), std::memory_order_release);
+            client.increaseReferenceCount();
+        }
+    }
+
+    /**
+     * @brief Closes the socket
+     */
+    void closeSocket()
+    {
+        closesocket(m_server_socket);
+        WSACleanup();
+    }
+};
+
+} // namespace pulse::net
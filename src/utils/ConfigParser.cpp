@@ -39,11 +39,24 @@ void ConfigParser::read()
             size_t separator_index = line.find(CONFIG_KEY_SEPARATOR);
             std::string config_key = line.substr(0, separator_index);
             std::string config_value = line.substr(separator_index + 1, line.size() - 1);
+
+            // Files edited on Windows keep their carriage returns
+            if (!config_value.empty() && config_value.back() == '\r')
+            {
+                config_value.pop_back();
+            }
+
             m_config[config_key] = config_value;
         }
     }
 }
 
+std::string ConfigParser::getValue(const std::string &key, const std::string &default_value) const
+{
+    auto it = m_config.find(key);
+    return it != m_config.end() ? it->second : default_value;
+}
+
 std::string ConfigParser::getConfigFilePath() const
 {
 #ifdef _WIN32
@@ -86,6 +99,35 @@ void ConfigParser::createConfigFileIfNotExists(const std::string &configPath)
             newConfigFile << "DATABASE_PORT=5432\n";
             newConfigFile << "DATABASE_PASSWORD=root\n";
             newConfigFile << "\n";
+            newConfigFile << "*******************************************************"
+                             "****************\n";
+            newConfigFile << "*                           NETWORK CONFIG             "
+                             "               *\n";
+            newConfigFile << "*******************************************************"
+                             "****************\n";
+            newConfigFile << "\n";
+            newConfigFile << "* Connections accepted at once, past which new ones are refused.\n";
+            newConfigFile << "MAX_CLIENTS=65536\n";
+            newConfigFile << "\n";
+            newConfigFile << "* Socket options of every listener: default, latency or throughput.\n";
+            newConfigFile << "* SOCKET_PROFILE_<port> overrides it for the listener of one port.\n";
+            newConfigFile << "SOCKET_PROFILE=default\n";
+            newConfigFile << "\n";
+            newConfigFile << "* PEM certificate chain and private key to terminate TLS with, if built with it.\n";
+            newConfigFile << "* TLS_CERTIFICATE_<port> and TLS_PRIVATE_KEY_<port> override them for one port.\n";
+            newConfigFile << "* TLS_CERTIFICATE=server.crt\n";
+            newConfigFile << "* TLS_PRIVATE_KEY=server.key\n";
+            newConfigFile << "* TLS_KERNEL_OFFLOAD=1 lets the kernel encrypt once the handshake is done (kTLS).\n";
+            newConfigFile << "\n";
+            newConfigFile << "* Unix domain socket local clients connect to, besides the port (not on Windows).\n";
+            newConfigFile << "* UNIX_SOCKET_<port> overrides it for one port.\n";
+            newConfigFile << "* UNIX_SOCKET=/run/pulsenet.sock\n";
+            newConfigFile << "\n";
+            newConfigFile << "* CPUs the threads run on: none, cores (one thread per physical core), nodes (one\n";
+            newConfigFile << "* NUMA node per thread) or a CPU list like 0-3,8. IO_PLACEMENT and WORKER_PLACEMENT\n";
+            newConfigFile << "* override it for the I/O threads and the workers assembling and handling requests.\n";
+            newConfigFile << "THREAD_PLACEMENT=none\n";
+            newConfigFile << "\n";
             newConfigFile << "\n";
             newConfigFile.close();
             logger.log(LogType::APPLICATION, LogSeverity::LOG_INFO, "Created config file at: " + configPath);
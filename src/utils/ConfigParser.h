@@ -32,6 +32,12 @@ class ConfigParser
      */
     void read();
 
+    /**
+     * @return The value of a key, or default_value if the configuration file
+     * does not set it.
+     */
+    std::string getValue(const std::string &key, const std::string &default_value = "") const;
+
     /**
      * @brief This method returns the config params related to database.
      * @return DatabaseKeys struct containing DB hostname, port and password.
@@ -12,7 +12,11 @@ void Console::showPrompt(std::ostream &os) const
     auto now = std::chrono::system_clock::now();
     std::time_t now_time = std::chrono::system_clock::to_time_t(now);
     std::tm local_tm{};
+#ifdef _WIN32
     localtime_s(&local_tm, &now_time);
+#else
+    localtime_r(&now_time, &local_tm);
+#endif
 
     // ANSI color codes
     const char *RESET = "\033[0m";
@@ -0,0 +1,107 @@
+#include "networking/AddressLimiter.h"
+#include <gtest/gtest.h>
+
+using pulse::net::AddressLimiter;
+using pulse::net::AddressLimits;
+
+static uint32_t address(const std::string &ip_address)
+{
+    uint32_t parsed = 0;
+    EXPECT_TRUE(AddressLimiter::parseAddress(ip_address, parsed));
+    return parsed;
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(AddressLimiterTest, ConnectionsAreCappedPerAddress)
+{
+    AddressLimiter limiter;
+    limiter.configure(AddressLimits{2});
+
+    uint32_t first = address("10.0.0.1");
+    uint32_t second = address("10.0.0.2");
+
+    EXPECT_TRUE(limiter.acquireConnection(first, 0));
+    EXPECT_TRUE(limiter.acquireConnection(first, 0));
+    EXPECT_FALSE(limiter.acquireConnection(first, 0));
+    EXPECT_TRUE(limiter.acquireConnection(second, 0));
+
+    limiter.releaseConnection(first, 0);
+    EXPECT_TRUE(limiter.acquireConnection(first, 0));
+    EXPECT_EQ(limiter.getStats().refused_connections, 1);
+}
+
+TEST(AddressLimiterTest, RequestTokensRefillAtTheRate)
+{
+    AddressLimiter limiter;
+    limiter.configure(AddressLimits{0, 10, 2});
+
+    uint32_t peer = address("10.0.0.1");
+
+    EXPECT_TRUE(limiter.admitRequest(peer, 1000));
+    EXPECT_TRUE(limiter.admitRequest(peer, 1000));
+    EXPECT_FALSE(limiter.admitRequest(peer, 1000));
+
+    // One token every 100 ms
+    EXPECT_FALSE(limiter.admitRequest(peer, 1050));
+    EXPECT_TRUE(limiter.admitRequest(peer, 1150));
+    EXPECT_FALSE(limiter.acquireConnection(peer, 1150));
+}
+
+TEST(AddressLimiterTest, ReceivedBytesMayLeaveTheBucketInDebt)
+{
+    AddressLimiter limiter;
+    limiter.configure(AddressLimits{0, 0, 0, 1000, 1000});
+
+    uint32_t peer = address("10.0.0.1");
+
+    EXPECT_TRUE(limiter.admitBytes(peer, 5000, 0));
+    EXPECT_FALSE(limiter.admitBytes(peer, 1, 3000));
+    EXPECT_TRUE(limiter.admitBytes(peer, 1, 4100));
+    EXPECT_EQ(limiter.getStats().limited_receives, 1);
+}
+
+TEST(AddressLimiterTest, IdleAddressesAreForgotten)
+{
+    AddressLimiter limiter;
+    limiter.configure(AddressLimits{1});
+
+    const uint32_t COUNT = 100000;
+
+    for (uint32_t i = 1; i <= COUNT; i++)
+    {
+        EXPECT_TRUE(limiter.acquireConnection(i, 0));
+    }
+
+    EXPECT_EQ(limiter.size(), COUNT);
+
+    for (uint32_t i = 1; i <= COUNT; i += 2)
+    {
+        limiter.releaseConnection(i, 0);
+    }
+
+    EXPECT_EQ(limiter.size(), COUNT / 2);
+
+    // Entries moved back by the removals are still found
+    for (uint32_t i = 2; i <= COUNT; i += 2)
+    {
+        EXPECT_FALSE(limiter.acquireConnection(i, 0));
+        limiter.releaseConnection(i, 0);
+    }
+
+    EXPECT_EQ(limiter.size(), 0);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(AddressLimiterTest, RejectsInvalidAddresses)
+{
+    uint32_t parsed = 0;
+
+    EXPECT_FALSE(AddressLimiter::parseAddress("10.0.0", parsed));
+    EXPECT_FALSE(AddressLimiter::parseAddress("::1", parsed));
+}
@@ -0,0 +1,54 @@
+#include "networking/BufferPool.h"
+#include <cstring>
+#include <gtest/gtest.h>
+
+using pulse::net::BufferPool;
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(BufferPoolTest, ReleasedBufferIsReused)
+{
+    BufferPool pool;
+
+    char *buffer = pool.acquire(4096);
+    std::memset(buffer, 'a', 4096);
+    pool.release(buffer, 4096);
+
+    EXPECT_EQ(pool.acquire(4096), buffer);
+}
+
+TEST(BufferPoolTest, SizesShareTheirClass)
+{
+    BufferPool pool;
+
+    char *buffer = pool.acquire(3000);
+    pool.release(buffer, 3000);
+
+    // 3000 and 4096 bytes both come from the 4 KiB class
+    EXPECT_EQ(pool.acquire(4096), buffer);
+}
+
+TEST(BufferPoolTest, BuffersDoNotOverlap)
+{
+    BufferPool pool;
+
+    char *first = pool.acquire(1024);
+    char *second = pool.acquire(1024);
+    char *large = pool.acquire(8192);
+
+    EXPECT_GE(std::abs(first - second), 1024);
+    EXPECT_TRUE(large + 8192 <= first || large >= first + 1024);
+    EXPECT_TRUE(large + 8192 <= second || large >= second + 1024);
+}
+
+TEST(BufferPoolTest, OversizedBufferIsNotPooled)
+{
+    BufferPool pool;
+
+    size_t size = pulse::net::BUFFER_POOL_MAX_CLASS + 1;
+    char *buffer = pool.acquire(size);
+    std::memset(buffer, 'a', size);
+    pool.release(buffer, size);
+}
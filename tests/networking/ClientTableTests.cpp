@@ -0,0 +1,95 @@
+#include "networking/ClientTable.h"
+#include <gtest/gtest.h>
+
+using pulse::net::Client;
+using pulse::net::ClientTable;
+
+static Client *addClient(ClientTable &table)
+{
+    return table.add([](uint64_t id) {
+        auto *client = new Client(id, 0, "127.0.0.1", 16, -1);
+        client->increaseReferenceCount();
+        return client;
+    });
+}
+
+static void releaseClient(ClientTable &table, Client &client)
+{
+    if (client.decreaseReferenceCount() == 0 && client.isDisconnecting())
+    {
+        table.remove(client.getId(), [](Client &) {});
+    }
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(ClientTableTest, AcquireLiveClient)
+{
+    ClientTable table(4);
+
+    Client *client = addClient(table);
+    ASSERT_NE(client, nullptr);
+
+    EXPECT_EQ(table.acquire(client->getId()), client);
+    EXPECT_EQ(client->getReferenceCount(), 2);
+}
+
+TEST(ClientTableTest, ReusedSlotGetsNewGeneration)
+{
+    ClientTable table(1);
+
+    Client *first = addClient(table);
+    uint64_t first_id = first->getId();
+    first->disconnect();
+    releaseClient(table, *first);
+
+    Client *second = addClient(table);
+    ASSERT_NE(second, nullptr);
+
+    EXPECT_EQ(second->getId() & 0xFFFFFFFF, first_id & 0xFFFFFFFF);
+    EXPECT_NE(second->getId(), first_id);
+    EXPECT_EQ(table.acquire(first_id), nullptr);
+}
+
+TEST(ClientTableTest, ReferencedClientIsKept)
+{
+    ClientTable table(1);
+
+    Client *client = addClient(table);
+    uint64_t id = client->getId();
+    Client *acquired = table.acquire(id);
+
+    client->disconnect();
+    releaseClient(table, *client);
+
+    // The lookup reference keeps the client in its slot
+    EXPECT_EQ(addClient(table), nullptr);
+
+    releaseClient(table, *acquired);
+
+    EXPECT_EQ(table.acquire(id), nullptr);
+    EXPECT_NE(addClient(table), nullptr);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(ClientTableTest, FullTableRefusesClients)
+{
+    ClientTable table(2);
+
+    EXPECT_NE(addClient(table), nullptr);
+    EXPECT_NE(addClient(table), nullptr);
+    EXPECT_EQ(addClient(table), nullptr);
+}
+
+TEST(ClientTableTest, UnknownIdIsNotFound)
+{
+    ClientTable table(2);
+
+    EXPECT_EQ(table.acquire(1), nullptr);
+    EXPECT_EQ(table.acquire(uint64_t(7) << 32), nullptr);
+}
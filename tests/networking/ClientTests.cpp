@@ -0,0 +1,251 @@
+#include "networking/Client.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using pulse::net::Client;
+using pulse::net::FileHandle;
+using pulse::net::FileRange;
+using pulse::net::OutboundBudget;
+using pulse::net::OutboundMessage;
+using pulse::net::OutboundFileSegment;
+using pulse::net::SendStatus;
+using pulse::net::SlowConsumerPolicy;
+
+static void queueMessage(Client &client, const std::string &header, const std::string &payload)
+{
+    client.queueOutbound(OutboundMessage{header, std::make_shared<const std::string>(payload), {}});
+}
+
+static SendStatus queueBytes(Client &client, size_t size, char c)
+{
+    return client.queueOutbound(OutboundMessage{std::string(size, c), nullptr, {}});
+}
+
+/**
+ * @brief Budget congesting a client over 10 queued bytes, until written down
+ * to 4.
+ */
+static void setLimits(OutboundBudget &budget, SlowConsumerPolicy policy)
+{
+    budget.limits.client_high = 10;
+    budget.limits.client_low = 4;
+    budget.limits.policy = policy;
+}
+
+static pulse::net::SharedFile createFile(const std::string &contents)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "pulsenet_client_test.txt").string();
+    std::ofstream(path, std::ios::binary) << contents;
+    return FileHandle::open(path);
+}
+
+static std::string gather(Client &client, size_t max_bytes, int max_segments, int &segments)
+{
+    std::string out;
+    segments = client.gatherOutbound(max_bytes, max_segments,
+                                     [&out](const char *data, size_t len) { out.append(data, len); });
+    return out;
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(ClientTest, GatherWholeQueue)
+{
+    Client client(0, 0, "127.0.0.1", 16, -1);
+    queueMessage(client, "h1:", "aaa");
+    queueMessage(client, "", "bbb");
+    queueMessage(client, "h3:", "");
+
+    int segments = 0;
+    EXPECT_EQ(gather(client, 1024, 64, segments), "h1:aaabbbh3:");
+    EXPECT_EQ(segments, 4);
+}
+
+TEST(ClientTest, GatherStopsAtLimits)
+{
+    Client client(0, 0, "127.0.0.1", 16, -1);
+    queueMessage(client, "h1:", "aaa");
+    queueMessage(client, "h2:", "bbb");
+
+    int segments = 0;
+    EXPECT_EQ(gather(client, 1024, 3, segments), "h1:aaah2:");
+    EXPECT_EQ(segments, 3);
+
+    EXPECT_EQ(gather(client, 8, 64, segments), "h1:aaah2");
+    EXPECT_EQ(segments, 3);
+}
+
+TEST(ClientTest, PartialWriteAdvancesOffsets)
+{
+    Client client(0, 0, "127.0.0.1", 16, -1);
+    queueMessage(client, "h1:", "aaa");
+    queueMessage(client, "h2:", "bbb");
+
+    client.consumeOutbound(4);
+
+    int segments = 0;
+    EXPECT_EQ(client.m_outbound_message_queue.size(), 2);
+    EXPECT_EQ(gather(client, 1024, 64, segments), "aah2:bbb");
+
+    client.consumeOutbound(5);
+
+    EXPECT_EQ(client.m_outbound_message_queue.size(), 1);
+    EXPECT_EQ(gather(client, 1024, 64, segments), "bbb");
+
+    client.consumeOutbound(3);
+
+    EXPECT_TRUE(client.m_outbound_message_queue.empty());
+    EXPECT_EQ(client.m_send_len, 0);
+}
+
+TEST(ClientTest, DropOldestKeepsPartlyWrittenFront)
+{
+    OutboundBudget budget;
+    setLimits(budget, SlowConsumerPolicy::DROP_OLDEST);
+    Client client(0, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+
+    queueBytes(client, 4, 'a');
+    queueBytes(client, 4, 'b');
+    client.consumeOutbound(1);
+
+    EXPECT_EQ(queueBytes(client, 4, 'c'), SendStatus::QUEUED);
+
+    int segments = 0;
+    EXPECT_EQ(gather(client, 1024, 64, segments), "aaacccc");
+    EXPECT_EQ(budget.stats.dropped_messages, 1);
+    EXPECT_EQ(budget.stats.queued_bytes, 7);
+}
+
+TEST(ClientTest, ConflateKeepsNewestMessage)
+{
+    OutboundBudget budget;
+    setLimits(budget, SlowConsumerPolicy::CONFLATE);
+    Client client(0, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+
+    queueBytes(client, 4, 'a');
+    queueBytes(client, 4, 'b');
+
+    EXPECT_EQ(queueBytes(client, 4, 'c'), SendStatus::QUEUED);
+    EXPECT_EQ(queueBytes(client, 8, 'd'), SendStatus::QUEUED);
+
+    int segments = 0;
+    EXPECT_EQ(gather(client, 1024, 64, segments), "dddddddd");
+    EXPECT_EQ(budget.stats.dropped_messages, 3);
+}
+
+TEST(ClientTest, FileRangeIsWrittenAfterHeader)
+{
+    OutboundBudget budget;
+    Client client(0, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+
+    client.queueOutbound(OutboundMessage{"h1:", nullptr, FileRange::of(createFile("0123456789"), 2, 5)});
+    queueMessage(client, "h2:", "bbb");
+
+    // Only the header is held in memory
+    EXPECT_EQ(budget.stats.queued_bytes, 9);
+
+    int segments = 0;
+    OutboundFileSegment file;
+    EXPECT_FALSE(client.frontFile(file));
+    EXPECT_EQ(gather(client, 1024, 64, segments), "h1:");
+
+    client.consumeOutbound(3);
+    ASSERT_TRUE(client.frontFile(file));
+    EXPECT_EQ(file.offset, 2);
+    EXPECT_EQ(file.length, 5);
+
+    client.consumeOutbound(2);
+    ASSERT_TRUE(client.frontFile(file));
+    EXPECT_EQ(file.offset, 4);
+    EXPECT_EQ(file.length, 3);
+
+    client.consumeOutbound(3);
+    EXPECT_FALSE(client.frontFile(file));
+    EXPECT_EQ(gather(client, 1024, 64, segments), "h2:bbb");
+    EXPECT_EQ(budget.stats.queued_bytes, 6);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(ClientTest, CongestionLastsUntilLowWatermark)
+{
+    OutboundBudget budget;
+    setLimits(budget, SlowConsumerPolicy::DROP_NEWEST);
+    Client client(0, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+
+    EXPECT_EQ(queueBytes(client, 8, 'a'), SendStatus::QUEUED);
+    EXPECT_EQ(queueBytes(client, 4, 'b'), SendStatus::DROPPED);
+    EXPECT_TRUE(client.isOutboundCongested());
+
+    // Back under the high watermark, but not the low one yet
+    client.consumeOutbound(3);
+    EXPECT_EQ(queueBytes(client, 1, 'c'), SendStatus::DROPPED);
+
+    client.consumeOutbound(1);
+    EXPECT_FALSE(client.isOutboundCongested());
+    EXPECT_EQ(queueBytes(client, 1, 'c'), SendStatus::QUEUED);
+}
+
+TEST(ClientTest, GlobalWatermarkAppliesToClientsOverTheirLowWatermark)
+{
+    OutboundBudget budget;
+    budget.limits.client_low = 2;
+    budget.limits.global_high = 10;
+    budget.limits.global_low = 4;
+    Client first(0, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+    Client second(1, 0, "127.0.0.1", 16, -1, nullptr, &budget);
+
+    EXPECT_EQ(queueBytes(first, 8, 'a'), SendStatus::QUEUED);
+
+    // A client keeping up is still written to, until its queue grows
+    EXPECT_EQ(queueBytes(second, 4, 'b'), SendStatus::QUEUED);
+    EXPECT_EQ(queueBytes(second, 1, 'c'), SendStatus::DISCONNECTED);
+    EXPECT_EQ(queueBytes(first, 1, 'c'), SendStatus::DISCONNECTED);
+    EXPECT_EQ(budget.stats.disconnects, 2);
+
+    first.discardOutbound();
+    EXPECT_EQ(budget.stats.queued_bytes, 4);
+    EXPECT_EQ(queueBytes(second, 1, 'c'), SendStatus::QUEUED);
+}
+
+TEST(ClientTest, RefusedMessagesReleaseTheirMemory)
+{
+    pulse::net::MemoryBudget memory;
+
+    for (SlowConsumerPolicy policy :
+         {SlowConsumerPolicy::DROP_NEWEST, SlowConsumerPolicy::DROP_OLDEST, SlowConsumerPolicy::DISCONNECT})
+    {
+        OutboundBudget budget;
+        setLimits(budget, policy);
+        Client client(0, 0, "127.0.0.1", 16, -1, nullptr, &budget, &memory);
+
+        // The first message is partly written, so it can be neither sent again nor dropped
+        EXPECT_EQ(queueBytes(client, 10, 'a'), SendStatus::QUEUED);
+        client.consumeOutbound(1);
+
+        for (int i = 0; i < 100; i++)
+        {
+            EXPECT_NE(queueBytes(client, 8, 'b'), SendStatus::QUEUED);
+        }
+
+        EXPECT_EQ(memory.used(), 9);
+
+        client.discardOutbound();
+        EXPECT_EQ(memory.used(), 0);
+    }
+}
+
+TEST(ClientTest, FileRangePastEndIsRejected)
+{
+    pulse::net::SharedFile file = createFile("0123456789");
+
+    EXPECT_EQ(FileRange::of(file).length, 10);
+    EXPECT_NO_THROW(FileRange::of(file, 10, 0));
+    EXPECT_THROW(FileRange::of(file, 5, 6), std::out_of_range);
+    EXPECT_THROW(FileRange::of(file, 11, 0), std::out_of_range);
+}
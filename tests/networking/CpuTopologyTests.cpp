@@ -0,0 +1,116 @@
+#include "networking/CpuTopology.h"
+#include "networking/TaskScheduler.h"
+#include <gtest/gtest.h>
+
+using pulse::net::CpuTopology;
+using pulse::net::LogicalCpu;
+using pulse::net::ThreadPlacement;
+
+/**
+ * @brief Two packages of two cores with two hardware threads each, one NUMA
+ * node per package. Siblings are numbered like Linux does: 0-3 are the first
+ * threads of every core, 4-7 the second ones.
+ */
+static CpuTopology twoSockets()
+{
+    std::vector<LogicalCpu> cpus;
+
+    for (int id = 0; id < 8; id++)
+    {
+        int core = id % 4;
+        cpus.push_back(LogicalCpu{id, core, core / 2, core / 2});
+    }
+
+    return CpuTopology(cpus);
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(CpuTopologyTest, PhysicalCoresFillOneNodeFirst)
+{
+    CpuTopology topology = twoSockets();
+
+    EXPECT_EQ(topology.getCoreCount(), 4);
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::physicalCores(), 0), (std::vector<int>{0, 4}));
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::physicalCores(), 1), (std::vector<int>{1, 5}));
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::physicalCores(), 2), (std::vector<int>{2, 6}));
+
+    // More threads than cores wrap around
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::physicalCores(), 4), (std::vector<int>{0, 4}));
+    EXPECT_EQ(topology.nodeOf({2, 6}), 1);
+}
+
+TEST(CpuTopologyTest, NumaNodesAlternate)
+{
+    CpuTopology topology = twoSockets();
+
+    EXPECT_EQ(topology.getNodeCount(), 2);
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::numaNodes(), 0), (std::vector<int>{0, 1, 4, 5}));
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::numaNodes(), 1), (std::vector<int>{2, 3, 6, 7}));
+    EXPECT_EQ(topology.cpusFor(ThreadPlacement::numaNodes(), 2), (std::vector<int>{0, 1, 4, 5}));
+    EXPECT_EQ(topology.nodeOf({1, 2}), -1);
+}
+
+TEST(CpuTopologyTest, PlacementsAreParsedAndSpelled)
+{
+    ThreadPlacement placement;
+
+    ASSERT_TRUE(pulse::net::parseThreadPlacement("0-2, 6", placement));
+    EXPECT_EQ(placement.mode, pulse::net::PlacementMode::CPU_LIST);
+    EXPECT_EQ(placement.cpus, (std::vector<int>{0, 1, 2, 6}));
+    EXPECT_EQ(pulse::net::getThreadPlacementName(placement), "0-2,6");
+
+    EXPECT_EQ(twoSockets().cpusFor(placement, 5), std::vector<int>{1});
+
+    for (const char *name : {"none", "cores", "nodes"})
+    {
+        ASSERT_TRUE(pulse::net::parseThreadPlacement(name, placement));
+        EXPECT_EQ(pulse::net::getThreadPlacementName(placement), name);
+    }
+}
+
+TEST(CpuTopologyTest, WorkersArePlacedBeforeStartReturns)
+{
+    int first_cpu = CpuTopology::system().getCpus().front().id;
+    std::vector<int> initialized(2, 0);
+
+    pulse::net::TaskScheduler scheduler(2);
+    scheduler.setPlacement(ThreadPlacement::cpuList({first_cpu}));
+    scheduler.setThreadInit([&initialized](int id) { initialized[id] = 1; });
+    scheduler.start();
+
+    EXPECT_EQ(initialized, (std::vector<int>{1, 1}));
+
+    for (const pulse::net::PlacedThread &thread : scheduler.getPlacedThreads())
+    {
+        EXPECT_EQ(thread.cpus, std::vector<int>{first_cpu});
+        EXPECT_EQ(thread.status, "ok");
+    }
+
+    scheduler.stop();
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(CpuTopologyTest, InvalidPlacementsAreRejected)
+{
+    ThreadPlacement placement;
+
+    EXPECT_FALSE(pulse::net::parseThreadPlacement("", placement));
+    EXPECT_FALSE(pulse::net::parseThreadPlacement("3-1", placement));
+    EXPECT_FALSE(pulse::net::parseThreadPlacement("all", placement));
+
+    // Ids past what an affinity mask holds are rejected before any is listed
+    std::vector<int> cpus;
+    EXPECT_FALSE(pulse::net::parseCpuList("0-2000000000", cpus));
+    EXPECT_FALSE(pulse::net::parseCpuList(std::to_string(pulse::net::CPU_ID_LIMIT), cpus));
+    EXPECT_TRUE(pulse::net::parseCpuList(std::to_string(pulse::net::CPU_ID_LIMIT - 1), cpus));
+
+    pulse::net::TaskScheduler scheduler(1);
+    EXPECT_THROW(scheduler.setPlacement(ThreadPlacement::cpuList({100000})), std::invalid_argument);
+    EXPECT_THROW(scheduler.setPlacement(ThreadPlacement::cpuList({})), std::invalid_argument);
+}
@@ -1,6 +1,30 @@
 #include "networking/http/HttpAssembler.h"
 #include "utils/Logger.h"
+#include <cstring>
 #include <gtest/gtest.h>
+#include <map>
+
+/**
+ * @brief HttpAssembler keeping the state of every connection id it is fed, as
+ * the clients of a server do.
+ */
+class ConnectionsAssembler : public pulse::net::HttpAssembler
+{
+  public:
+    AssemblingResult feed(uint64_t id, char *buffer, int &buffer_len, int max_buffer_len, int last_tcp_packet_len)
+    {
+        std::unique_ptr<pulse::net::AssemblerState> &state = m_states[id];
+        if (!state)
+        {
+            state = onConnect(id);
+        }
+
+        return HttpAssembler::feed(id, state.get(), buffer, buffer_len, max_buffer_len, last_tcp_packet_len);
+    }
+
+  private:
+    std::map<uint64_t, std::unique_ptr<pulse::net::AssemblerState>> m_states;
+};
 
 //*************************************************************************************
 //**********************        POSITIVE TESTS       **********************************
@@ -8,7 +32,7 @@
 
 TEST(HttpParserTest, SuccessCompleteMessage)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     for (int i = 0; i < 3; i++)
     {
@@ -34,7 +58,7 @@ TEST(HttpParserTest, SuccessCompleteMessage)
 
 TEST(HttpParserTest, SuccessCompleteMessageNoBody)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     for (int i = 0; i < 3; i++)
     {
@@ -58,7 +82,7 @@ TEST(HttpParserTest, SuccessCompleteMessageNoBody)
 
 TEST(HttpParserTest, SuccessAfterError)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char invalid_request[] = "??? /uri";
     int length = sizeof(invalid_request) - 1;
@@ -89,7 +113,7 @@ TEST(HttpParserTest, SuccessAfterError)
 
 TEST(HttpParserTest, ConsecutiveHttpRequestsAtOnce)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char consecutive_requests[] = "GET /aaa HTTP/1.1\r\n"
                                   "content-length: 26\r\n"
@@ -120,9 +144,39 @@ TEST(HttpParserTest, ConsecutiveHttpRequestsAtOnce)
     EXPECT_EQ(length, 0); // Everything consumed
 }
 
+TEST(HttpParserTest, PipelinedRequestsKeepPartialTail)
+{
+    ConnectionsAssembler assembler;
+
+    const std::string request = "GET /a HTTP/1.1\r\nhost: x\r\n\r\n";
+    const int maxBufLen = 96;
+
+    // Three whole requests and the first bytes of a fourth, which fill the buffer
+    std::string data = request + request + request + request;
+    char buffer[maxBufLen];
+    int length = maxBufLen;
+    std::memcpy(buffer, data.data(), length);
+
+    pulse::net::HttpAssembler::AssemblingResult result = assembler.feed(1, buffer, length, maxBufLen, length);
+
+    EXPECT_FALSE(result.error);
+    EXPECT_EQ(result.messages.size(), 3);
+    EXPECT_EQ(std::string(buffer, length), data.substr(3 * request.size(), maxBufLen - 3 * request.size()));
+
+    int rest = static_cast<int>(data.size()) - maxBufLen;
+    std::memcpy(buffer + length, data.data() + maxBufLen, rest);
+    length += rest;
+
+    result = assembler.feed(1, buffer, length, maxBufLen, rest);
+
+    EXPECT_FALSE(result.error);
+    EXPECT_EQ(result.messages.size(), 1);
+    EXPECT_EQ(length, 0);
+}
+
 TEST(HttpParserTest, SuccessStreamedMessage)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char buffer[] = "POST /aaa HTTP/1.1\r\n"
                     "content-length: 26\r\n"
@@ -160,7 +214,7 @@ TEST(HttpParserTest, SuccessStreamedMessage)
 
 TEST(HttpParserTest, SuccessCompleteChunkedMessage)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     for (int i = 0; i < 3; i++)
     {
@@ -191,7 +245,7 @@ TEST(HttpParserTest, SuccessCompleteChunkedMessage)
 
 TEST(HttpParserTest, SuccessFiniteMessageAfterChunkedMessage)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char request[] = "POST /aaa HTTP/1.1\r\n"
                      "content-length: 26\r\n"
@@ -230,7 +284,7 @@ TEST(HttpParserTest, SuccessFiniteMessageAfterChunkedMessage)
 
 TEST(HttpParserTest, SuccessChunkedMessageAfterFiniteMessage)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char request[] = "POST /upload HTTP/1.1\r\n"
                      "Host: example.com\r\n"
@@ -269,7 +323,7 @@ TEST(HttpParserTest, SuccessChunkedMessageAfterFiniteMessage)
 
 TEST(HttpParserTest, SuccessStreamedMessageWithSmallBuffer)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     assembler.setMaxBodyMemoryBuffer(32);
 
     const char data[] = "POST /upload HTTP/1.1\r\n"
@@ -316,7 +370,7 @@ TEST(HttpParserTest, SuccessStreamedMessageWithSmallBuffer)
 
 TEST(HttpParserTest, SuccessStreamedChunkedMessageWithSmallBuffer)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     const char data[] = "POST /upload HTTP/1.1\r\n"
                         "Host: example.com\r\n"
@@ -369,7 +423,7 @@ TEST(HttpParserTest, SuccessStreamedChunkedMessageWithSmallBuffer)
 
 TEST(HttpParserTest, InvalidMethod)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     char buffer[] = "??? /uri";
     int length = sizeof(buffer) - 1;
 
@@ -380,7 +434,7 @@ TEST(HttpParserTest, InvalidMethod)
 
 TEST(HttpParserTest, EmptyHeaderFieldName)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     char buffer1[] = "GET / HTTP/1.1\r\n: chunked\r\n\r\nhello";
     int length1 = sizeof(buffer1) - 1;
 
@@ -405,7 +459,7 @@ TEST(HttpParserTest, EmptyHeaderFieldName)
 
 TEST(HttpParserTest, EmptyHeaderFieldValue)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     char buffer1[] = "GET / HTTP/1.1\r\nContent-Length:  \r\n\r\nhello";
     int length1 = sizeof(buffer1) - 1;
 
@@ -430,7 +484,7 @@ TEST(HttpParserTest, EmptyHeaderFieldValue)
 
 TEST(HttpParserTest, UriTooLong)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     char buffer[] = "GET /123567";
     int length = sizeof(buffer) - 1;
 
@@ -442,7 +496,7 @@ TEST(HttpParserTest, UriTooLong)
 
 TEST(HttpParserTest, TotalHeaderBytesTooLong)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
     char buffer[] = "GET /index.html HTTP/1.1\r\nContent-length: 23\r\nTooLarge: jasdajdasjd\r\nTooLarge: "
                     "jasdajdasjd\r\nTooLarge: jasdajdasjd\r\n";
     int length = sizeof(buffer) - 1;
@@ -458,7 +512,7 @@ TEST(HttpParserTest, TotalHeaderBytesTooLong)
 
 TEST(HttpParserTest, BodyTooLong)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char buffer[] = "GET /index.html HTTP/1.1\r\nContent-length: 9\r\n\r\n"
                     "Too large";
@@ -479,7 +533,7 @@ TEST(HttpParserTest, BodyTooLong)
 
 TEST(HttpParserTest, ChunkedMessageMalformedChunkSize)
 {
-    pulse::net::HttpAssembler assembler;
+    ConnectionsAssembler assembler;
 
     char request[] = "POST /upload HTTP/1.1\r\n"
                      "Host: example.com\r\n"
@@ -0,0 +1,343 @@
+#include "networking/TCPServer.h"
+#include "networking/http/HttpAssembler.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+
+using LoopbackServer = pulse::net::TCPServer<pulse::net::HttpAssembler, pulse::net::LoopbackEngine>;
+
+/**
+ * @brief Answers every request with the first letter of its host.
+ */
+struct HostHandler
+{
+    void operator()(pulse::net::RequestView<pulse::net::HttpMessage> &request, pulse::net::ResponseWriter &response)
+    {
+        std::string body = request.message.headerContainsValue("host", "a") ? "a" : "b";
+        response.write("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n" + body);
+    }
+};
+
+using RunToCompletionServer =
+    pulse::net::TCPServer<pulse::net::HttpAssembler, pulse::net::LoopbackEngine, HostHandler>;
+
+static std::unique_ptr<LoopbackServer> createServer()
+{
+    auto server = std::make_unique<LoopbackServer>(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server->start();
+    return server;
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(LoopbackEngineTest, RequestAndResponse)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    uint64_t id = engine.connect(5000, "10.0.0.1");
+
+    // Split across writes, the assembler waits for the whole message
+    engine.write(id, "GET /aaa HTTP/1.1\r\n");
+    engine.write(id, "host: 127.0.0.1\r\n\r\n");
+
+    std::optional<LoopbackServer::Request> request = server->next();
+
+    EXPECT_EQ(request->client.id, id);
+    EXPECT_EQ(request->client.ip_address, "10.0.0.1");
+    EXPECT_EQ(request->client.port, 5000);
+    EXPECT_TRUE(request->message->hasHeader("host"));
+
+    server->send(id, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+    EXPECT_EQ(engine.read(id), "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    EXPECT_TRUE(engine.isConnected(id));
+}
+
+TEST(LoopbackEngineTest, PipelinedRequests)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    uint64_t id = engine.connect();
+
+    engine.write(id, "GET /first HTTP/1.1\r\nhost: a\r\n\r\nGET /second HTTP/1.1\r\nhost: b\r\n\r\n");
+
+    EXPECT_EQ(server->next()->client.id, id);
+    EXPECT_EQ(server->next()->client.id, id);
+}
+
+TEST(LoopbackEngineTest, SharedPayloadWithHeaders)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    uint64_t first = engine.connect();
+    uint64_t second = engine.connect();
+
+    pulse::net::SharedPayload body = std::make_shared<const std::string>(std::string(10000, 'x'));
+
+    server->send(first, body, "HTTP/1.1 200 OK\r\nContent-Length: 10000\r\nX-Id: 1\r\n\r\n");
+    server->send(second, body, "HTTP/1.1 200 OK\r\nContent-Length: 10000\r\nX-Id: 2\r\n\r\n");
+
+    EXPECT_EQ(engine.read(first), "HTTP/1.1 200 OK\r\nContent-Length: 10000\r\nX-Id: 1\r\n\r\n" + *body);
+    EXPECT_EQ(engine.read(second), "HTTP/1.1 200 OK\r\nContent-Length: 10000\r\nX-Id: 2\r\n\r\n" + *body);
+
+    // Written payloads are not retained by the outbound queues
+    EXPECT_EQ(body.use_count(), 1);
+}
+
+TEST(LoopbackEngineTest, FileRangeAfterHeader)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    std::string path = (std::filesystem::temp_directory_path() / "pulsenet_loopback_test.txt").string();
+    std::ofstream(path, std::ios::binary) << "0123456789";
+
+    uint64_t id = engine.connect();
+    server->send(id, "first");
+    server->send(id, pulse::net::FileRange::of(pulse::net::FileHandle::open(path), 2, 5), "header:");
+    server->send(id, "last");
+
+    EXPECT_EQ(engine.read(id), "firstheader:23456last");
+}
+
+TEST(LoopbackEngineTest, ReceiveBufferGrowsForLargeHeaders)
+{
+    auto server = std::make_unique<LoopbackServer>(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server->setClientBufferLen(1024);
+    server->setRecvBufferSizing(1024, 16384, 1, 4);
+    server->start();
+
+    auto &engine = server->getIoEngine();
+    uint64_t id = engine.connect();
+
+    // Larger than the initial buffer, in writes of a few hundred bytes
+    std::string request = "GET /aaa HTTP/1.1\r\nx-large: " + std::string(6000, 'a') + "\r\n\r\n";
+    for (size_t offset = 0; offset < request.size(); offset += 500)
+    {
+        engine.write(id, std::string_view(request).substr(offset, 500));
+    }
+
+    std::optional<LoopbackServer::Request> received = server->next();
+
+    EXPECT_TRUE(received->message->headerContainsValue("x-large", std::string(6000, 'a')));
+    EXPECT_GT(server->getRecvBufferStats().expansions, 0);
+
+    // The size is raised once the assembler gives the grown buffer back
+    for (int i = 0; i < 1000 && server->getRecvBufferStats().grows == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(server->getRecvBufferStats().grows, 1);
+}
+
+TEST(LoopbackEngineTest, RunToCompletionRespondsInline)
+{
+    RunToCompletionServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setRequestHandler(HostHandler{});
+    server.start();
+
+    auto &engine = server.getIoEngine();
+    uint64_t id = engine.connect();
+
+    // Handled on the writing thread, so the responses are there once write() returns
+    engine.write(id, "GET /first HTTP/1.1\r\nhost: a\r\n\r\nGET /second HTTP/1.1\r\nhost: b\r\n\r\n");
+
+    EXPECT_EQ(engine.read(id), "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\na"
+                               "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\nb");
+    EXPECT_TRUE(engine.isConnected(id));
+}
+
+TEST(LoopbackEngineTest, RequestCallbackRunsOnSharedScheduler)
+{
+    pulse::net::TaskScheduler scheduler(2);
+    scheduler.start();
+
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setScheduler(scheduler);
+    server.setRequestCallback([&server, &scheduler](LoopbackServer::Request request) {
+        EXPECT_GE(scheduler.currentWorker(), 0);
+        server.send(request.client.id, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    server.start();
+
+    auto &engine = server.getIoEngine();
+    uint64_t id = engine.connect();
+    engine.write(id, "GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+
+    std::string response;
+    for (int i = 0; i < 2000 && response.empty(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        response = engine.read(id);
+    }
+
+    EXPECT_EQ(response, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+    // Assembling and handling ran as two tasks, and the shared scheduler outlives the server
+    server.stop();
+    EXPECT_EQ(scheduler.getStats().executed, 2);
+    EXPECT_TRUE(scheduler.isRunning());
+}
+
+TEST(LoopbackEngineTest, LocalClientsCarryCredentials)
+{
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setAddressLimits(pulse::net::AddressLimits{1, 1, 1});
+    server.start();
+
+    auto &engine = server.getIoEngine();
+
+    // Local clients have no address to count against
+    uint64_t id = engine.connectLocal(pulse::net::PeerCredentials{1234, 1000, 100});
+    EXPECT_NO_THROW(engine.connectLocal(pulse::net::PeerCredentials{1234, 1000, 100}));
+
+    engine.write(id, "GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+
+    std::optional<LoopbackServer::Request> request = server.next();
+
+    ASSERT_TRUE(request->client.peer.has_value());
+    EXPECT_EQ(request->client.peer->pid, 1234);
+    EXPECT_EQ(request->client.peer->uid, 1000u);
+    EXPECT_EQ(request->client.peer->gid, 100u);
+    EXPECT_EQ(request->client.ip_address, "");
+
+    uint64_t remote = engine.connect(0, "10.0.0.1");
+    engine.write(remote, "GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+
+    EXPECT_FALSE(server.next()->client.peer.has_value());
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(LoopbackEngineTest, ClientsPastTheTableCapacityAreRefused)
+{
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>(), 2);
+    server.start();
+
+    auto &engine = server.getIoEngine();
+
+    engine.connect();
+    engine.connect();
+    EXPECT_THROW(engine.connect(), std::runtime_error);
+
+    EXPECT_THROW(LoopbackServer(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>(), 0),
+                 std::invalid_argument);
+}
+
+TEST(LoopbackEngineTest, MalformedRequestClosesConnection)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    uint64_t id = engine.connect();
+
+    engine.write(id, "??? /aaa HTTP/1.1\r\n\r\n");
+
+    for (int i = 0; i < 1000 && engine.isConnected(id); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_FALSE(engine.isConnected(id));
+    EXPECT_FALSE(engine.write(id, "GET /aaa HTTP/1.1\r\n\r\n"));
+    EXPECT_NE(engine.read(id).find("400"), std::string::npos);
+}
+
+TEST(LoopbackEngineTest, SlowHeadersTimeOut)
+{
+    RunToCompletionServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setRequestHandler(HostHandler{});
+    server.start();
+
+    auto &engine = server.getIoEngine();
+    uint64_t start = pulse::net::ConnectionTimer::clock();
+
+    uint64_t idle = engine.connect();
+    uint64_t slow = engine.connect();
+    engine.write(slow, "GET /aaa HTTP/1.1\r\nhost: a\r\n");
+
+    engine.expireTimeouts(start + pulse::net::HEADER_TIMEOUT_MS + 1000);
+
+    EXPECT_FALSE(engine.isConnected(slow));
+    EXPECT_TRUE(engine.isConnected(idle));
+
+    engine.expireTimeouts(start + pulse::net::IDLE_TIMEOUT_MS + 1000);
+
+    EXPECT_FALSE(engine.isConnected(idle));
+}
+
+TEST(LoopbackEngineTest, MemoryBudgetRefusesBodiesAndConnections)
+{
+    pulse::net::MemoryBudget budget(pulse::net::MemoryLimits{64 * 1024, 32 * 1024});
+
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setMemoryBudget(budget);
+    server.start();
+
+    auto &engine = server.getIoEngine();
+
+    uint64_t id = engine.connect();
+    engine.write(id, "POST /upload HTTP/1.1\r\ncontent-length: 1000000\r\n\r\n");
+
+    for (int i = 0; i < 1000 && engine.isConnected(id); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_FALSE(engine.isConnected(id));
+    EXPECT_NE(engine.read(id).find("503"), std::string::npos);
+    EXPECT_EQ(server.getMemoryStats().request_bodies, 0);
+
+    // Memory held elsewhere in the process stops new connections
+    budget.reserve(pulse::net::MemoryUse::OUTBOUND, 40 * 1024);
+    EXPECT_THROW(engine.connect(), std::runtime_error);
+
+    budget.release(pulse::net::MemoryUse::OUTBOUND, 40 * 1024);
+    EXPECT_NO_THROW(engine.connect());
+}
+
+TEST(LoopbackEngineTest, AddressLimitsRefuseConnectionsAndRequests)
+{
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server.setAddressLimits(pulse::net::AddressLimits{1, 1, 1});
+    server.start();
+
+    auto &engine = server.getIoEngine();
+
+    uint64_t id = engine.connect(0, "10.0.0.1");
+    EXPECT_THROW(engine.connect(0, "10.0.0.1"), std::runtime_error);
+    EXPECT_NO_THROW(engine.connect(0, "10.0.0.2"));
+
+    // The second request finds the bucket empty
+    engine.write(id, "GET /a HTTP/1.1\r\nhost: a\r\n\r\nGET /b HTTP/1.1\r\nhost: b\r\n\r\n");
+
+    auto request = server.next();
+    ASSERT_TRUE(request.has_value());
+    EXPECT_TRUE(request->message->headerContainsValue("host", "a"));
+
+    for (int i = 0; i < 1000 && engine.isConnected(id); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_FALSE(engine.isConnected(id));
+    EXPECT_EQ(server.getAddressLimiterStats().limited_requests, 1);
+}
+
+TEST(LoopbackEngineTest, EmptyUnixSocketPathIsRejected)
+{
+    LoopbackServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+
+    EXPECT_THROW(server.setUnixSocket(""), std::invalid_argument);
+    EXPECT_EQ(server.getUnixSocket(), "");
+}
@@ -0,0 +1,135 @@
+#include "networking/RingQueue.h"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+using pulse::net::RingQueue;
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(RingQueueTest, ItemsComeOutInOrder)
+{
+    RingQueue<int> queue(4);
+
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(queue.tryPush(int(i)));
+
+        int item = -1;
+        EXPECT_TRUE(queue.tryPop(item));
+        EXPECT_EQ(item, i);
+    }
+}
+
+TEST(RingQueueTest, BatchesStopAtCapacity)
+{
+    RingQueue<int> queue(4);
+
+    std::vector<int> items{1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(queue.tryPushBatch(items.data(), items.size()), 4);
+
+    int popped[8];
+    EXPECT_EQ(queue.tryPopBatch(popped, 3), 3);
+    EXPECT_EQ(popped[2], 3);
+
+    EXPECT_EQ(queue.tryPushBatch(items.data() + 4, 2), 2);
+    EXPECT_EQ(queue.tryPopBatch(popped, 8), 3);
+    EXPECT_EQ(popped[0], 4);
+    EXPECT_EQ(popped[2], 6);
+}
+
+TEST(RingQueueTest, ClosedQueueIsDrainedFirst)
+{
+    RingQueue<std::string> queue(8);
+
+    queue.push("last");
+    queue.close();
+
+    std::string item;
+    EXPECT_FALSE(queue.push("late"));
+    EXPECT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, "last");
+    EXPECT_FALSE(queue.pop(item));
+}
+
+TEST(RingQueueTest, CloseWakesBlockedConsumer)
+{
+    RingQueue<int> queue(8);
+
+    std::thread consumer([&queue]() {
+        int item;
+        EXPECT_FALSE(queue.pop(item));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    consumer.join();
+}
+
+TEST(RingQueueTest, ConcurrentProducersAndConsumers)
+{
+    const int producers = 4;
+    const int consumers = 4;
+    const int per_producer = 50000;
+
+    // Small, so producers and consumers keep waiting on each other
+    RingQueue<uint64_t> queue(64);
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<int> count = 0;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p]() {
+            std::vector<uint64_t> batch;
+            for (int i = 1; i <= per_producer; i++)
+            {
+                batch.push_back(uint64_t(p) * per_producer + i);
+                if (batch.size() == 7 || i == per_producer)
+                {
+                    queue.pushBatch(batch.data(), batch.size());
+                    batch.clear();
+                }
+            }
+        });
+    }
+
+    for (int c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&queue, &sum, &count]() {
+            uint64_t items[16];
+            size_t popped;
+            while ((popped = queue.popBatch(items, 16)) > 0)
+            {
+                sum += std::accumulate(items, items + popped, uint64_t(0));
+                count += static_cast<int>(popped);
+            }
+        });
+    }
+
+    for (int p = 0; p < producers; p++)
+    {
+        threads[p].join();
+    }
+
+    while (count < producers * per_producer)
+    {
+        std::this_thread::yield();
+    }
+
+    queue.close();
+    for (int c = 0; c < consumers; c++)
+    {
+        threads[producers + c].join();
+    }
+
+    uint64_t total = uint64_t(producers) * per_producer;
+    EXPECT_EQ(count, total);
+    EXPECT_EQ(sum, total * (total + 1) / 2);
+}
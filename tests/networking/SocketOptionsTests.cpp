@@ -0,0 +1,58 @@
+#include "networking/SocketOptions.h"
+#include <gtest/gtest.h>
+
+using pulse::net::SocketOptions;
+using pulse::net::SocketProfile;
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(SocketOptionsTest, ProfilesAreFoundByName)
+{
+    for (SocketProfile profile : {SocketProfile::DEFAULT, SocketProfile::LATENCY, SocketProfile::THROUGHPUT})
+    {
+        SocketProfile parsed = SocketProfile::DEFAULT;
+
+        EXPECT_TRUE(pulse::net::parseSocketProfile(pulse::net::getSocketProfileName(profile), parsed));
+        EXPECT_EQ(parsed, profile);
+    }
+
+    SocketOptions latency = SocketOptions::forProfile(SocketProfile::LATENCY);
+    EXPECT_TRUE(latency.no_delay);
+    EXPECT_FALSE(latency.cork);
+}
+
+#ifndef _WIN32
+TEST(SocketOptionsTest, ListenerOptionsAreReadBack)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ASSERT_GE(sock, 0);
+
+    SocketOptions options;
+    options.no_delay = true;
+    options.recv_buffer = 256 * 1024;
+
+    std::vector<pulse::net::AppliedSocketOption> applied = pulse::net::applyListenerOptions(sock, options);
+    close(sock);
+
+    ASSERT_EQ(applied.size(), 2);
+    EXPECT_EQ(applied[0].name, "TCP_NODELAY");
+    EXPECT_EQ(applied[0].applied, 1);
+    EXPECT_EQ(applied[1].name, "SO_RCVBUF");
+    EXPECT_GT(applied[1].applied, 0);
+    EXPECT_EQ(applied[1].status, "ok");
+}
+#endif
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(SocketOptionsTest, UnknownProfileIsRejected)
+{
+    SocketProfile parsed = SocketProfile::LATENCY;
+
+    EXPECT_FALSE(pulse::net::parseSocketProfile("fast", parsed));
+    EXPECT_EQ(parsed, SocketProfile::LATENCY);
+}
@@ -0,0 +1,175 @@
+#include "networking/TaskScheduler.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using pulse::net::TaskScheduler;
+
+template <typename Condition> static bool waitUntil(Condition condition)
+{
+    for (int i = 0; i < 2000 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return condition();
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TaskSchedulerTest, RunsEverySubmittedTask)
+{
+    TaskScheduler scheduler(4);
+    scheduler.start();
+
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 10000; i++)
+    {
+        EXPECT_TRUE(scheduler.submit([&count]() { count.fetch_add(1); }));
+    }
+
+    EXPECT_TRUE(waitUntil([&count]() { return count == 10000; }));
+    EXPECT_EQ(scheduler.getStats().executed, 10000);
+    EXPECT_EQ(scheduler.getStats().injected, 10000);
+}
+
+TEST(TaskSchedulerTest, ContinuationRunsAfterItsTasks)
+{
+    TaskScheduler scheduler(3);
+    scheduler.start();
+
+    std::atomic<int> count{0};
+    std::atomic<int> seen{-1};
+    std::vector<TaskScheduler::Task> tasks;
+
+    for (int i = 0; i < 50; i++)
+    {
+        tasks.push_back([&count]() { count.fetch_add(1); });
+    }
+
+    scheduler.submitAll(std::move(tasks), [&count, &seen]() { seen = count.load(); });
+
+    EXPECT_TRUE(waitUntil([&seen]() { return seen >= 0; }));
+    EXPECT_EQ(seen, 50);
+
+    // A single task and its continuation, chained
+    std::atomic<int> step{0};
+    scheduler.submit([&step]() { step = 1; }, [&step]() { step = step == 1 ? 2 : -1; });
+
+    EXPECT_TRUE(waitUntil([&step]() { return step != 1 && step != 0; }));
+    EXPECT_EQ(step, 2);
+}
+
+TEST(TaskSchedulerTest, SubtasksOfABusyWorkerAreStolen)
+{
+    TaskScheduler scheduler(2);
+    scheduler.start();
+
+    std::atomic<int> thief{-1};
+
+    // The parent waits for its subtask, which only another worker can run
+    scheduler.submit([&scheduler, &thief]() {
+        int parent = scheduler.currentWorker();
+        scheduler.submit([&scheduler, &thief]() { thief = scheduler.currentWorker(); });
+
+        waitUntil([&thief]() { return thief >= 0; });
+        EXPECT_NE(thief, parent);
+    });
+
+    EXPECT_TRUE(waitUntil([&thief]() { return thief >= 0; }));
+    EXPECT_EQ(scheduler.getStats().stolen, 1);
+}
+
+TEST(TaskSchedulerTest, StopRunsSubmittedTasks)
+{
+    std::atomic<int> count{0};
+    {
+        TaskScheduler scheduler(2);
+        scheduler.start();
+
+        for (int i = 0; i < 1000; i++)
+        {
+            // Every task submits a continuation from its worker, run before stopping as well
+            scheduler.submit([&count]() { count.fetch_add(1); }, [&count]() { count.fetch_add(1); });
+        }
+
+        scheduler.stop();
+        EXPECT_EQ(count, 2000);
+    }
+
+    EXPECT_EQ(count, 2000);
+}
+
+TEST(TaskSchedulerTest, IdleWorkersPark)
+{
+    TaskScheduler scheduler(2);
+    scheduler.start();
+
+    EXPECT_TRUE(waitUntil([&scheduler]() { return scheduler.getStats().parks >= 2; }));
+
+    std::atomic<bool> ran{false};
+    scheduler.submit([&ran]() { ran = true; });
+
+    EXPECT_TRUE(waitUntil([&ran]() { return ran.load(); }));
+}
+
+TEST(TaskSchedulerTest, TasksReleaseWhatTheyCaptureWhateverTheirSize)
+{
+    TaskScheduler scheduler(2);
+    scheduler.start();
+
+    auto captured = std::make_shared<int>(0);
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 1000; i++)
+    {
+        // Small tasks are stored in their node, large ones on the heap
+        scheduler.submit([captured, &count]() { count.fetch_add(1); });
+        scheduler.submit([captured, &count, padding = std::array<char, 256>{}]() { count.fetch_add(1); });
+    }
+
+    EXPECT_TRUE(waitUntil([&count]() { return count == 2000; }));
+    EXPECT_TRUE(waitUntil([&captured]() { return captured.use_count() == 1; }));
+
+    // A task dropped by a stopped scheduler is released too
+    scheduler.stop();
+    EXPECT_FALSE(scheduler.submit([captured]() {}));
+    EXPECT_EQ(captured.use_count(), 1);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TaskSchedulerTest, SubmitWithoutRunningSchedulerIsRejected)
+{
+    TaskScheduler scheduler(1);
+    std::atomic<bool> ran{false};
+
+    EXPECT_FALSE(scheduler.submit([&ran]() { ran = true; }));
+
+    scheduler.start();
+    scheduler.stop();
+
+    EXPECT_FALSE(scheduler.submit([&ran]() { ran = true; }));
+    EXPECT_FALSE(ran);
+    EXPECT_THROW(TaskScheduler(0), std::invalid_argument);
+}
+
+TEST(TaskSchedulerTest, ThrowingTaskStillRunsItsContinuation)
+{
+    TaskScheduler scheduler(1);
+    scheduler.start();
+
+    std::atomic<bool> continued{false};
+    scheduler.submit([]() { throw std::runtime_error("task failed"); }, [&continued]() { continued = true; });
+
+    EXPECT_TRUE(waitUntil([&continued]() { return continued.load(); }));
+}
@@ -0,0 +1,106 @@
+#include "networking/TimingWheel.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using pulse::net::TimerNode;
+using pulse::net::TimingWheel;
+
+struct Timed
+{
+    int id = 0;
+    TimerNode<Timed> node;
+
+    explicit Timed(int id) : id(id)
+    {
+        node.owner = this;
+    }
+};
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TimingWheelTest, FiresAtExpiry)
+{
+    TimingWheel<Timed> wheel;
+    Timed timed(1);
+    std::vector<int> fired;
+
+    wheel.schedule(timed.node, 5);
+
+    wheel.advance(4, [&fired](Timed &t) { fired.push_back(t.id); });
+    EXPECT_TRUE(fired.empty());
+
+    wheel.advance(5, [&fired](Timed &t) { fired.push_back(t.id); });
+    EXPECT_EQ(fired, std::vector<int>{1});
+    EXPECT_FALSE(timed.node.isScheduled());
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimingWheelTest, FarExpiriesCascadeDown)
+{
+    TimingWheel<Timed> wheel(100);
+    Timed near(1), far(2), farthest(3);
+    std::vector<std::pair<int, uint64_t>> fired;
+    auto fire = [&fired, &wheel](Timed &t) { fired.emplace_back(t.id, wheel.now()); };
+
+    wheel.schedule(farthest.node, 100 + 300000);
+    wheel.schedule(far.node, 100 + 5000);
+    wheel.schedule(near.node, 100 + 63);
+
+    wheel.advance(100 + 300000, fire);
+
+    std::vector<std::pair<int, uint64_t>> expected{{1, 163}, {2, 5100}, {3, 300100}};
+    EXPECT_EQ(fired, expected);
+}
+
+TEST(TimingWheelTest, NodeCanBeScheduledAgainWhenFired)
+{
+    TimingWheel<Timed> wheel;
+    Timed timed(1);
+    int fired = 0;
+
+    wheel.schedule(timed.node, 10);
+    wheel.advance(100, [&fired, &wheel](Timed &t) {
+        if (++fired < 3)
+        {
+            wheel.schedule(t.node, wheel.now() + 10);
+        }
+    });
+
+    EXPECT_EQ(fired, 3);
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimingWheelTest, TicksUntilNext)
+{
+    TimingWheel<Timed> wheel(10);
+    Timed near(1), far(2);
+
+    EXPECT_EQ(wheel.ticksUntilNext(), 0);
+
+    wheel.schedule(far.node, 1000);
+    EXPECT_EQ(wheel.ticksUntilNext(), 64 - 10); // Next cascade
+
+    wheel.schedule(near.node, 20);
+    EXPECT_EQ(wheel.ticksUntilNext(), 10);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TimingWheelTest, CancelledNodeDoesNotFire)
+{
+    TimingWheel<Timed> wheel;
+    Timed first(1), second(2);
+    std::vector<int> fired;
+
+    wheel.schedule(first.node, 5000);
+    wheel.schedule(second.node, 5000);
+    wheel.cancel(first.node);
+
+    wheel.advance(6000, [&fired](Timed &t) { fired.push_back(t.id); });
+
+    EXPECT_EQ(fired, std::vector<int>{2});
+}
@@ -0,0 +1,73 @@
+#include "networking/tls/TlsSessionCache.h"
+#include <gtest/gtest.h>
+
+using pulse::net::TLS_SESSION_CACHE_SHARDS;
+using pulse::net::TlsSessionCache;
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TlsSessionCacheTest, StoresSessionsById)
+{
+    TlsSessionCache cache(100, 60);
+    std::string session;
+
+    cache.put("first", "a", 0);
+    cache.put("second", "b", 0);
+
+    EXPECT_TRUE(cache.get("first", session, 0));
+    EXPECT_EQ(session, "a");
+    EXPECT_TRUE(cache.get("second", session, 0));
+    EXPECT_EQ(session, "b");
+
+    cache.remove("first");
+    EXPECT_FALSE(cache.get("first", session, 0));
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(TlsSessionCacheTest, OldestSessionsAreEvicted)
+{
+    // One session per shard
+    TlsSessionCache cache(TLS_SESSION_CACHE_SHARDS, 60);
+    std::string session;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        cache.put(std::to_string(i), "session", 0);
+    }
+
+    EXPECT_LE(cache.size(), TLS_SESSION_CACHE_SHARDS);
+    EXPECT_TRUE(cache.get("999", session, 0));
+}
+
+TEST(TlsSessionCacheTest, StoringAgainReplacesSession)
+{
+    TlsSessionCache cache(TLS_SESSION_CACHE_SHARDS, 60);
+    std::string session;
+
+    for (int i = 0; i < 100; i++)
+    {
+        cache.put("id", std::to_string(i), 0);
+    }
+
+    EXPECT_TRUE(cache.get("id", session, 0));
+    EXPECT_EQ(session, "99");
+    EXPECT_EQ(cache.size(), 1);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TlsSessionCacheTest, ExpiredSessionsAreNotResumed)
+{
+    TlsSessionCache cache(100, 1);
+    std::string session;
+
+    cache.put("id", "a", 0);
+
+    EXPECT_TRUE(cache.get("id", session, 999));
+    EXPECT_FALSE(cache.get("id", session, 1000));
+    EXPECT_EQ(cache.size(), 0);
+}
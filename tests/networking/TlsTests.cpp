@@ -0,0 +1,498 @@
+#ifdef PULSENET_TLS
+
+#include "networking/TCPServer.h"
+#include "networking/http/HttpAssembler.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#ifdef __linux__
+#include <climits>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+using pulse::net::TlsConfig;
+using pulse::net::TlsContext;
+
+/**
+ * @brief Answers every request with its host, or 100000 bytes for host
+ * "large".
+ */
+struct EchoHostHandler
+{
+    void operator()(pulse::net::RequestView<pulse::net::HttpMessage> &request, pulse::net::ResponseWriter &response)
+    {
+        std::string body = request.message.headerContainsValue("host", "large") ? std::string(100000, 'x') : "ok";
+        response.write("HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+    }
+};
+
+using TlsServer = pulse::net::TCPServer<pulse::net::HttpAssembler, pulse::net::LoopbackEngine, EchoHostHandler>;
+
+/**
+ * @brief Self-signed certificate and key, written once for every test.
+ */
+static const TlsConfig &testConfig()
+{
+    static TlsConfig config = [] {
+        auto directory = std::filesystem::temp_directory_path();
+        TlsConfig created;
+        created.certificate_file = (directory / "pulsenet_test.crt").string();
+        created.private_key_file = (directory / "pulsenet_test.key").string();
+        created.kernel_offload = false; // Loopback connections have no socket
+
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        X509 *certificate = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+        X509_set_pubkey(certificate, key);
+        X509_NAME_add_entry_by_txt(X509_get_subject_name(certificate), "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(certificate, X509_get_subject_name(certificate));
+        X509_sign(certificate, key, EVP_sha256());
+
+        FILE *file = std::fopen(created.certificate_file.c_str(), "w");
+        PEM_write_X509(file, certificate);
+        std::fclose(file);
+
+        file = std::fopen(created.private_key_file.c_str(), "w");
+        PEM_write_PrivateKey(file, key, nullptr, nullptr, 0, nullptr, nullptr);
+        std::fclose(file);
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+        return created;
+    }();
+
+    return config;
+}
+
+/**
+ * @brief Client side of a TLS connection of the loopback engine, over memory
+ * BIOs.
+ */
+class TlsPeer
+{
+  public:
+    TlsPeer(TlsServer &server, int max_version = 0, SSL_SESSION *session = nullptr)
+        : m_engine(server.getIoEngine()), m_id(m_engine.connect())
+    {
+        m_ctx = SSL_CTX_new(TLS_client_method());
+
+        if (max_version != 0)
+        {
+            SSL_CTX_set_max_proto_version(m_ctx, max_version);
+        }
+
+        BIO *rbio = BIO_new(BIO_s_mem());
+        BIO_set_mem_eof_return(rbio, -1);
+
+        m_ssl = SSL_new(m_ctx);
+        SSL_set_bio(m_ssl, rbio, BIO_new(BIO_s_mem()));
+        SSL_set_connect_state(m_ssl);
+
+        if (session != nullptr)
+        {
+            SSL_set_session(m_ssl, session);
+        }
+    }
+
+    ~TlsPeer()
+    {
+        // Sessions of connections not shut down are not resumed
+        SSL_shutdown(m_ssl);
+        SSL_free(m_ssl);
+        SSL_CTX_free(m_ctx);
+    }
+
+    bool handshake()
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            int result = SSL_do_handshake(m_ssl);
+            int error = SSL_get_error(m_ssl, result);
+            pump();
+
+            if (result == 1)
+            {
+                return true;
+            }
+
+            if (error != SSL_ERROR_WANT_READ)
+            {
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    void send(const std::string &plaintext)
+    {
+        size_t written = 0;
+        SSL_write_ex(m_ssl, plaintext.data(), plaintext.size(), &written);
+        pump();
+    }
+
+    /**
+     * @brief Reads the plaintext the server sent, until len bytes arrived.
+     */
+    std::string receive(size_t len)
+    {
+        std::string plaintext;
+        char chunk[16384];
+
+        for (int i = 0; i < 100 && plaintext.size() < len; i++)
+        {
+            pump();
+            size_t read = 0;
+
+            while (SSL_read_ex(m_ssl, chunk, sizeof(chunk), &read) == 1)
+            {
+                plaintext.append(chunk, read);
+            }
+        }
+
+        return plaintext;
+    }
+
+    SSL *ssl()
+    {
+        return m_ssl;
+    }
+
+    uint64_t id() const
+    {
+        return m_id;
+    }
+
+  private:
+    pulse::net::LoopbackEngine<TlsServer> &m_engine;
+    uint64_t m_id;
+    SSL_CTX *m_ctx;
+    SSL *m_ssl;
+
+    /**
+     * @brief Moves the records of the client to the server, and back.
+     */
+    void pump()
+    {
+        char chunk[16384];
+        int read;
+
+        while ((read = BIO_read(SSL_get_wbio(m_ssl), chunk, sizeof(chunk))) > 0)
+        {
+            m_engine.write(m_id, std::string_view(chunk, static_cast<size_t>(read)));
+        }
+
+        std::string records = m_engine.read(m_id);
+        BIO_write(SSL_get_rbio(m_ssl), records.data(), static_cast<int>(records.size()));
+    }
+};
+
+static std::unique_ptr<TlsServer> createServer(const TlsConfig &config = testConfig())
+{
+    auto server = std::make_unique<TlsServer>(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    server->setRequestHandler(EchoHostHandler{});
+    server->setTls(config);
+    server->start();
+    return server;
+}
+
+static const std::string OK_RESPONSE = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+#ifdef __linux__
+/**
+ * @brief TCP connection over loopback, server side first.
+ */
+static std::pair<int, int> connectedSockets()
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(address);
+
+    bind(listener, reinterpret_cast<sockaddr *>(&address), len);
+    listen(listener, 1);
+    getsockname(listener, reinterpret_cast<sockaddr *>(&address), &len);
+
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    connect(client, reinterpret_cast<sockaddr *>(&address), len);
+    int server = accept(listener, nullptr, nullptr);
+
+    close(listener);
+    return {server, client};
+}
+#endif
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TlsTest, HandshakeAndRequest)
+{
+    auto server = createServer();
+    TlsPeer peer(*server);
+
+    ASSERT_TRUE(peer.handshake());
+
+    peer.send("GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+    EXPECT_EQ(peer.receive(OK_RESPONSE.size()), OK_RESPONSE);
+
+    EXPECT_EQ(server->getTlsStats().handshakes, 1);
+    EXPECT_EQ(server->getTlsStats().resumed_handshakes, 0);
+}
+
+TEST(TlsTest, LargeResponseAndPipelinedRequests)
+{
+    auto server = createServer();
+    TlsPeer peer(*server);
+
+    ASSERT_TRUE(peer.handshake());
+
+    peer.send("GET / HTTP/1.1\r\nhost: large\r\n\r\nGET / HTTP/1.1\r\nhost: a\r\n\r\n");
+
+    std::string large = "HTTP/1.1 200 OK\r\nContent-Length: 100000\r\n\r\n" + std::string(100000, 'x');
+    EXPECT_EQ(peer.receive(large.size() + OK_RESPONSE.size()), large + OK_RESPONSE);
+}
+
+TEST(TlsTest, FileRangeIsEncrypted)
+{
+    auto server = createServer();
+    TlsPeer peer(*server);
+
+    ASSERT_TRUE(peer.handshake());
+
+    std::string contents(50000, 'f');
+    std::string path = (std::filesystem::temp_directory_path() / "pulsenet_tls_test.txt").string();
+    std::ofstream(path, std::ios::binary) << contents;
+
+    server->send(peer.id(), pulse::net::FileRange::of(pulse::net::FileHandle::open(path)), "header:");
+
+    EXPECT_EQ(peer.receive(contents.size() + 7), "header:" + contents);
+}
+
+TEST(TlsTest, ResumesWithTicket)
+{
+    auto server = createServer();
+    SSL_SESSION *session;
+    {
+        TlsPeer first(*server);
+        ASSERT_TRUE(first.handshake());
+
+        // The ticket comes after the handshake, with the response
+        first.send("GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+        first.receive(OK_RESPONSE.size());
+        session = SSL_get1_session(first.ssl());
+    }
+
+    TlsPeer second(*server, 0, session);
+    ASSERT_TRUE(second.handshake());
+
+    EXPECT_TRUE(SSL_session_reused(second.ssl()));
+    EXPECT_EQ(server->getTlsStats().resumed_handshakes, 1);
+
+    SSL_SESSION_free(session);
+}
+
+TEST(TlsTest, ResumesFromSessionCache)
+{
+    TlsConfig config = testConfig();
+    config.session_tickets = false;
+
+    auto server = createServer(config);
+    SSL_SESSION *session;
+    {
+        TlsPeer first(*server, TLS1_2_VERSION);
+        ASSERT_TRUE(first.handshake());
+        session = SSL_get1_session(first.ssl());
+    }
+
+    TlsPeer second(*server, TLS1_2_VERSION, session);
+    ASSERT_TRUE(second.handshake());
+
+    EXPECT_TRUE(SSL_session_reused(second.ssl()));
+    EXPECT_EQ(server->getTlsStats().cache_hits, 1);
+
+    second.send("GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+    EXPECT_EQ(second.receive(OK_RESPONSE.size()), OK_RESPONSE);
+
+    SSL_SESSION_free(session);
+}
+
+TEST(TlsTest, ContextIsSharedByServers)
+{
+    TlsContext context(testConfig());
+
+    auto first = std::make_unique<TlsServer>(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+    auto second = std::make_unique<TlsServer>(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+
+    for (TlsServer *server : {first.get(), second.get()})
+    {
+        server->setRequestHandler(EchoHostHandler{});
+        server->setTlsContext(context);
+        server->start();
+    }
+
+    SSL_SESSION *session;
+    {
+        TlsPeer peer(*first);
+        ASSERT_TRUE(peer.handshake());
+        peer.send("GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+        peer.receive(OK_RESPONSE.size());
+        session = SSL_get1_session(peer.ssl());
+    }
+
+    // A ticket of one server resumes on the other
+    TlsPeer peer(*second, 0, session);
+    ASSERT_TRUE(peer.handshake());
+    EXPECT_TRUE(SSL_session_reused(peer.ssl()));
+
+    SSL_SESSION_free(session);
+}
+
+#ifdef __linux__
+TEST(TlsTest, KernelEncryptsOnceOffloaded)
+{
+    // The tls module of the kernel is loaded by the first socket asking for it
+    auto [probe_server, probe_client] = connectedSockets();
+    bool available = setsockopt(probe_server, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) == 0;
+    close(probe_server);
+    close(probe_client);
+
+    if (!available)
+    {
+        GTEST_SKIP() << "The kernel has no tls module";
+    }
+
+    TlsConfig config = testConfig();
+    config.kernel_offload = true;
+    TlsContext context(config);
+
+    if (!context.getConfig().kernel_offload)
+    {
+        GTEST_SKIP() << "Kernel offload is not supported with this OpenSSL";
+    }
+
+    auto [server_sock, client_sock] = connectedSockets();
+    fcntl(client_sock, F_SETFL, O_NONBLOCK);
+
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    SSL *client = SSL_new(client_ctx);
+    SSL_set_fd(client, client_sock);
+    SSL_set_connect_state(client);
+
+    auto session = context.createSession();
+    ASSERT_NE(session, nullptr);
+
+    // Records of the session are written to the socket, as an engine would
+    auto flush = [&session, server_sock = server_sock] {
+        session->gatherOutput(SIZE_MAX, INT_MAX, [server_sock](const char *data, size_t len) {
+            EXPECT_EQ(send(server_sock, data, len, 0), static_cast<ssize_t>(len));
+        });
+        session->consumeOutput(session->outputSize());
+    };
+
+    char buffer[16384];
+    bool connected = false;
+
+    for (int i = 0; i < 100 && !(connected && session->isEstablished()); i++)
+    {
+        connected = connected || SSL_do_handshake(client) == 1;
+
+        ssize_t received = recv(server_sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+        if (received > 0)
+        {
+            session->receive(buffer, static_cast<size_t>(received));
+        }
+
+        ASSERT_GE(session->read(buffer, sizeof(buffer)), 0);
+        flush();
+    }
+
+    ASSERT_TRUE(connected);
+    ASSERT_TRUE(session->isEstablished());
+
+    // Records sealed after the keys were handed over advance the sequence the
+    // kernel starts from
+    session->seal("sealed,", 7);
+    session->closeRecord();
+    flush();
+
+    ASSERT_TRUE(session->offload(server_sock));
+    EXPECT_TRUE(session->isOffloaded());
+    EXPECT_EQ(context.getStats().offloaded_sessions, 1);
+
+    ASSERT_EQ(send(server_sock, "offloaded", 9, 0), 9);
+
+    std::string plaintext;
+
+    for (int i = 0; i < 100 && plaintext.size() < 16; i++)
+    {
+        size_t read = 0;
+
+        if (SSL_read_ex(client, buffer, sizeof(buffer), &read) == 1)
+        {
+            plaintext.append(buffer, read);
+            continue;
+        }
+
+        pollfd readable{client_sock, POLLIN, 0};
+        poll(&readable, 1, 10);
+    }
+
+    EXPECT_EQ(plaintext, "sealed,offloaded");
+
+    SSL_free(client);
+    SSL_CTX_free(client_ctx);
+    close(server_sock);
+    close(client_sock);
+}
+#endif
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(TlsTest, PlaintextClosesConnection)
+{
+    auto server = createServer();
+    auto &engine = server->getIoEngine();
+
+    uint64_t id = engine.connect();
+    engine.write(id, "GET / HTTP/1.1\r\nhost: a\r\n\r\n");
+
+    EXPECT_FALSE(engine.isConnected(id));
+    EXPECT_EQ(server->getTlsStats().failed_sessions, 1);
+}
+
+TEST(TlsTest, MissingCertificateIsRejected)
+{
+    TlsConfig config;
+    config.certificate_file = "missing.crt";
+    config.private_key_file = "missing.key";
+
+    TlsServer server(0, "127.0.0.1", 1, std::make_unique<pulse::net::HttpAssembler>());
+
+    EXPECT_THROW(server.setTls(config), std::runtime_error);
+    EXPECT_THROW(server.getTlsStats(), std::logic_error);
+}
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef _WIN32
+
+#include "networking/DefaultDatagramDecoder.h"
+#include "networking/UdpServer.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using pulse::net::DefaultDatagramDecoder;
+
+using UdpQueueServer = pulse::net::UdpServer<DefaultDatagramDecoder>;
+
+/**
+ * @brief Answers every datagram with its bytes, after "echo:".
+ */
+struct EchoHandler
+{
+    void operator()(pulse::net::RequestView<std::string> &request, pulse::net::ResponseWriter &response)
+    {
+        response.write(std::make_shared<const std::string>(request.message), "echo:");
+    }
+};
+
+/**
+ * @brief Rejects the datagrams starting with '!'.
+ */
+class StrictDecoder : public pulse::net::DatagramDecoder<std::string>
+{
+  public:
+    bool decode(const char *data, size_t len, std::vector<std::shared_ptr<std::string>> &messages) override
+    {
+        if (len > 0 && data[0] == '!')
+        {
+            return false;
+        }
+
+        messages.push_back(std::make_shared<std::string>(data, len));
+        return true;
+    }
+};
+
+/**
+ * @brief UDP socket of a source, bound to an ephemeral port of 127.0.0.1.
+ */
+class UdpPeer
+{
+  public:
+    UdpPeer()
+    {
+        m_sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_sock, reinterpret_cast<sockaddr *>(&local), sizeof(local));
+
+        socklen_t local_len = sizeof(local);
+        getsockname(m_sock, reinterpret_cast<sockaddr *>(&local), &local_len);
+        m_port = ntohs(local.sin_port);
+
+        timeval timeout{2, 0};
+        setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~UdpPeer()
+    {
+        close(m_sock);
+    }
+
+    void send(int port, const std::string &datagram)
+    {
+        sockaddr_in server{};
+        server.sin_family = AF_INET;
+        server.sin_port = htons(static_cast<uint16_t>(port));
+        server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        sendto(m_sock, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&server), sizeof(server));
+    }
+
+    /**
+     * @brief Waits up to two seconds for a datagram.
+     */
+    std::string receive()
+    {
+        char buffer[2048];
+        ssize_t len = recv(m_sock, buffer, sizeof(buffer), 0);
+        return len > 0 ? std::string(buffer, static_cast<size_t>(len)) : "";
+    }
+
+    int port() const
+    {
+        return m_port;
+    }
+
+  private:
+    int m_sock;
+    int m_port;
+};
+
+template <typename Counter> static void waitFor(const Counter &counter, uint64_t value)
+{
+    for (int i = 0; i < 2000 && counter.load() < value; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(UdpServerTest, DatagramsAreQueuedForNext)
+{
+    UdpQueueServer server(0, "127.0.0.1", std::make_unique<DefaultDatagramDecoder>());
+    server.start();
+
+    UdpPeer peer;
+
+    for (int i = 0; i < 3; i++)
+    {
+        peer.send(server.getPort(), "event " + std::to_string(i));
+    }
+
+    uint64_t id = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        std::optional<UdpQueueServer::Request> request = server.next();
+
+        EXPECT_EQ(*request->message, "event " + std::to_string(i));
+        EXPECT_EQ(request->client.ip_address, "127.0.0.1");
+        EXPECT_EQ(request->client.port, peer.port());
+
+        // A source keeps its id
+        id = id == 0 ? request->client.id : id;
+        EXPECT_EQ(request->client.id, id);
+    }
+
+    EXPECT_EQ(server.getStats().datagrams, 3);
+    EXPECT_GE(server.getStats().batches, 1);
+    EXPECT_LE(server.getStats().batches, 3);
+}
+
+TEST(UdpServerTest, SendAnswersSource)
+{
+    UdpQueueServer server(0, "127.0.0.1", std::make_unique<DefaultDatagramDecoder>());
+    server.start();
+
+    UdpPeer peer;
+    peer.send(server.getPort(), "ping");
+
+    std::optional<UdpQueueServer::Request> request = server.next();
+
+    EXPECT_EQ(server.send(request->client.id, "pong"), pulse::net::SendStatus::QUEUED);
+    EXPECT_EQ(peer.receive(), "pong");
+}
+
+TEST(UdpServerTest, RunToCompletionAnswersEveryDatagram)
+{
+    pulse::net::UdpServer<DefaultDatagramDecoder, EchoHandler> server(0, "127.0.0.1",
+                                                                      std::make_unique<DefaultDatagramDecoder>());
+    server.setRequestHandler(EchoHandler{});
+    server.setIoThreads(2);
+    server.start();
+
+    UdpPeer peer;
+    peer.send(server.getPort(), "a");
+    peer.send(server.getPort(), "b");
+
+    EXPECT_EQ(peer.receive(), "echo:a");
+    EXPECT_EQ(peer.receive(), "echo:b");
+
+    // Counted once sendmmsg returns, which may be after they arrived
+    waitFor(server.getStats().sent, 2);
+    EXPECT_EQ(server.getStats().sent, 2);
+}
+
+//*************************************************************************************
+//**********************        NEGATIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(UdpServerTest, MalformedDatagramsAreDropped)
+{
+    pulse::net::UdpServer<StrictDecoder> server(0, "127.0.0.1", std::make_unique<StrictDecoder>());
+    server.start();
+
+    UdpPeer peer;
+    peer.send(server.getPort(), "!bad");
+    peer.send(server.getPort(), "good");
+
+    EXPECT_EQ(*server.next()->message, "good");
+    EXPECT_EQ(server.getStats().malformed, 1);
+}
+
+TEST(UdpServerTest, DatagramsLargerThanTheBufferAreDropped)
+{
+    UdpQueueServer server(0, "127.0.0.1", std::make_unique<DefaultDatagramDecoder>());
+    server.setClientBufferLen(16);
+    server.setGro(false);
+    server.start();
+
+    UdpPeer peer;
+    peer.send(server.getPort(), std::string(100, 'x'));
+    peer.send(server.getPort(), "small");
+
+    EXPECT_EQ(*server.next()->message, "small");
+    waitFor(server.getStats().truncated, 1);
+    EXPECT_EQ(server.getStats().truncated, 1);
+}
+
+TEST(UdpServerTest, InvalidBatchSizeIsRejected)
+{
+    UdpQueueServer server(0, "127.0.0.1", std::make_unique<DefaultDatagramDecoder>());
+
+    EXPECT_THROW(server.setBatchSize(0), std::invalid_argument);
+    EXPECT_THROW(server.setBatchSize(pulse::net::MAX_UDP_BATCH_DATAGRAMS + 1), std::invalid_argument);
+    EXPECT_THROW(UdpQueueServer(0, "127.0.0.1", nullptr), std::invalid_argument);
+}
+
+#endif
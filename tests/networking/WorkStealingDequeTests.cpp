@@ -0,0 +1,103 @@
+#include "networking/WorkStealingDeque.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using pulse::net::WorkStealingDeque;
+
+//*************************************************************************************
+//**********************        POSITIVE TESTS       **********************************
+//*************************************************************************************
+
+TEST(WorkStealingDequeTest, OwnerPopsNewestAndThievesStealOldest)
+{
+    int items[3] = {0, 1, 2};
+    WorkStealingDeque<int *> deque(4);
+
+    for (int &item : items)
+    {
+        deque.push(&item);
+    }
+
+    EXPECT_EQ(deque.pop(), &items[2]);
+    EXPECT_EQ(deque.steal(), &items[0]);
+    EXPECT_EQ(deque.pop(), &items[1]);
+
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, GrowsWhenFull)
+{
+    std::vector<int> items(100);
+    WorkStealingDeque<int *> deque(2);
+
+    for (int &item : items)
+    {
+        deque.push(&item);
+    }
+
+    EXPECT_GE(deque.capacity(), 100);
+
+    for (int i = 99; i >= 0; i--)
+    {
+        EXPECT_EQ(deque.pop(), &items[i]);
+    }
+}
+
+TEST(WorkStealingDequeTest, EveryItemIsTakenOnce)
+{
+    const int COUNT = 100000;
+    std::vector<int> items(COUNT);
+    std::vector<std::atomic<int>> taken(COUNT);
+    WorkStealingDeque<int *> deque(16);
+    std::atomic<bool> done{false};
+
+    auto take = [&items, &taken](int *item) { taken[item - items.data()].fetch_add(1); };
+
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; i++)
+    {
+        thieves.emplace_back([&]() {
+            while (!done || !deque.empty())
+            {
+                if (int *item = deque.steal())
+                {
+                    take(item);
+                }
+            }
+        });
+    }
+
+    // The owner pops every other item, racing the thieves for the last ones
+    for (int i = 0; i < COUNT; i++)
+    {
+        deque.push(&items[i]);
+
+        if (i % 2 == 0)
+        {
+            if (int *item = deque.pop())
+            {
+                take(item);
+            }
+        }
+    }
+
+    while (int *item = deque.pop())
+    {
+        take(item);
+    }
+
+    done = true;
+    for (std::thread &thief : thieves)
+    {
+        thief.join();
+    }
+
+    for (int i = 0; i < COUNT; i++)
+    {
+        ASSERT_EQ(taken[i], 1) << "item " << i;
+    }
+}